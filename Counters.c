@@ -0,0 +1,69 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Counters.c
+* \details  This module holds the performance counters that show why a node
+*			in the field is slow: how busy the I2C bus and both EEPROMs are,
+*			what the UART and the SBUS parser had to throw away, whether the
+*			player keeps the segments back-to-back, and how long the main loop
+*			can take to get round.  Each module counts its own events with the
+*			COUNT macros, which cost an increment and a compare, and SBUS sends
+*			the block as a STATS page.
+*
+*			Commenting out COUNTERS in Counters.h gives a lean build in which
+*			the macros expand to nothing and the STATS page reports an error.
+*			The main loop is timed with the 16-bit time stamps, so a pass longer
+*			than about one second is not measured correctly.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Counters.h"
+#include "Timer.h"
+
+#ifdef COUNTERS
+
+CountersBlock Counters_Block;
+
+static unsigned int lastPass;			/*!< time stamp of the last main loop pass */
+static BOOL started;					/*!< lastPass is valid */
+
+#endif
+
+void Counters_Loop (BOOL restart) {
+#ifdef COUNTERS
+	unsigned int now = Timer_Stamp();
+	unsigned int pass = now - lastPass;
+	
+	if (started && !restart) COUNT_MAX(loopMax, pass);
+	lastPass = now;
+	started = TRUE;
+#endif
+}
+
+BOOL Counters_Get (CountersBlock *block) {
+#ifdef COUNTERS
+	di();							// some counters are kept by the interrupt
+	*block = Counters_Block;
+	ei();
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void Counters_Clear (void) {
+#ifdef COUNTERS
+	unsigned int *counter = (unsigned int *)&Counters_Block;
+	unsigned char i;
+	
+	di();
+	for (i=0; i<COUNTERS_SIZE; i++) counter[i] = 0;
+	ei();
+	started = FALSE;
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+
+#include "system.h"
+
+#define COUNTERS		/* comment out for a lean build without the performance counters */
+
+typedef struct _CountersBlock {
+	unsigned int i2cTransactions;	// stop conditions sent on the I2C bus
+	unsigned int i2cNacks;			// bytes the 24LC256 did not acknowledge
+	unsigned int extWrites;			// 24LC256 page write cycles
+	unsigned int segmentsRead;		// sequence segments read for playback or SBUS
+	unsigned int intWrites;			// internal EEPROM bytes written
+	unsigned int rxBytes;			// characters received (interrupt)
+	unsigned int rxFraming;			// characters received with a framing error (interrupt)
+	unsigned int rxOverruns;		// receiver or buffer overruns, each losing at least one character (interrupt)
+	unsigned int droppedFrames;		// received frames discarded without being parsed
+	unsigned int parseTimeouts;		// frames abandoned waiting for a character
+	unsigned int segmentGaps;		// segments that started a tick or more after the previous hold ended
+	unsigned int segmentGapMax;		// longest such gap in ticks
+	unsigned int loopMax;			// longest pass of the main loop in phase counts (about 17uS)
+} CountersBlock;
+
+#define COUNTERS_SIZE	(sizeof(CountersBlock)/sizeof(unsigned int))
+
+#ifdef COUNTERS
+
+extern CountersBlock Counters_Block;
+
+// Counts an event; the counters stick at their maximum rather than wrap
+#define COUNT(c)			{ if (++Counters_Block.c == 0) Counters_Block.c--; }
+
+// Adds 'n' events
+#define COUNT_ADD(c, n)		{ unsigned int sum = Counters_Block.c + (n); \
+							  Counters_Block.c = (sum < Counters_Block.c) ? 0xFFFF : sum; }
+
+// Keeps the largest value seen
+#define COUNT_MAX(c, v)		{ if ((v) > Counters_Block.c) Counters_Block.c = (v); }
+
+#else
+
+#define COUNT(c)
+#define COUNT_ADD(c, n)
+#define COUNT_MAX(c, v)
+
+#endif
+
+extern void Counters_Loop (BOOL restart);
+// Marks each pass of the main loop.  'restart' is TRUE after a deliberate wait, such as a
+// sleep, that should not count as a slow pass.
+
+extern BOOL Counters_Get (CountersBlock *block);
+// Copies the counters to 'block'.  Returns FALSE in a lean build without the counters.
+
+extern void Counters_Clear (void);
+// Clears all the counters.
+
+#endif
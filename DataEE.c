@@ -0,0 +1,217 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	DataEE.c
+* \details  This module implements a write-behind queue for the internal data
+*			EEPROM that holds the configuration and the macros.  Each byte takes
+*			a 4mS write cycle, so rather than waiting in \em eeprom_write the
+*			writes are queued and returned from at once.  The queue drains in
+*			order in the background: the EEPROM interrupt at the end of every
+*			write starts the next one.  A second write to an address that is
+*			still queued only replaces the queued value, and a byte is only
+*			written if it differs from what the EEPROM already holds, so the
+*			same setting sent over and over costs no write cycles at all.
+*
+*			\em DataEE_Read looks in the queue first so callers always see the
+*			latest value.  The queue is flushed before a sleep, and the
+*			high/low-voltage detect interrupts as the supply starts to fail so
+*			the remaining writes finish before the brown-out reset.  A dip that
+*			recovers without a reset is seen by a timer that re-arms the
+*			detector once the supply is back above the trip point.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "DataEE.h"
+#include "Counters.h"
+#include "Timer.h"
+
+#define QUEUESIZE	16					/*!< writes held, a power of two */
+#define WATCH		10					/*!< ticks between supply checks after a dip - 50mS */
+#define NONE		0xFF
+
+typedef struct _Pending {
+	unsigned char address;
+	unsigned char value;
+} Pending;
+
+static Pending queue[QUEUESIZE];		/*!< writes in order */
+static volatile unsigned char head;		/*!< oldest write */
+static volatile unsigned char count;	/*!< writes queued */
+static volatile BOOL writing;			/*!< the oldest write is in progress */
+static volatile BOOL failing;			/*!< the supply is failing */
+
+static unsigned char ReadCell (unsigned char address) {
+	EEADR = address;
+	EECON1bits.EEPGD = 0;				// data EEPROM
+	EECON1bits.CFGS = 0;
+	EECON1bits.RD = 1;
+	return EEDATA;
+}
+
+//********************************************************************************
+/**
+* \details  Starts writing the oldest queued byte, dropping any at the front of
+*			the queue that are already in the EEPROM.  Called with the interrupts
+*			disabled, or from the interrupt, and no write in progress.
+*/ 
+//********************************************************************************
+static void StartWrite (void) {
+	Pending *next;
+	
+	while (count > 0) {
+		next = &queue[head];
+		if (ReadCell(next->address) != next->value) {
+			EEADR = next->address;
+			EEDATA = next->value;
+			EECON1bits.EEPGD = 0;
+			EECON1bits.CFGS = 0;
+			EECON1bits.WREN = 1;
+			EECON2 = 0x55;				// required unlock sequence
+			EECON2 = 0xAA;
+			EECON1bits.WR = 1;
+			EECON1bits.WREN = 0;
+			writing = TRUE;
+			COUNT(intWrites);
+			return;
+		}
+		head = (head + 1) & (QUEUESIZE-1);
+		count--;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Returns the queued entry for \em address or \em NONE.  The entry
+*			being written cannot be changed any more so it is skipped.  Called
+*			with the interrupts disabled.
+*/ 
+//********************************************************************************
+static unsigned char Find (unsigned char address) {
+	unsigned char i, n;
+	
+	for (n=writing ? 1 : 0; n<count; n++) {
+		i = (head + n) & (QUEUESIZE-1);
+		if (queue[i].address == address) return i;
+	}
+	return NONE;
+}
+
+//********************************************************************************
+/**
+* \details  While the supply is failing the detector looks for a rising
+*			voltage.  Once it has crossed back over the trip point the queue
+*			goes back to writing behind and the falling detector is re-armed.
+*/ 
+//********************************************************************************
+static void Watch (void) {
+	if (!failing || !HLVDIF) return;
+	di();
+	HLVDCONbits.VDIRMAG = 0;			// falling voltage again
+	HLVDIF = 0;
+	failing = FALSE;
+	HLVDIE = 1;
+	ei();
+}
+
+void DataEE_Init (void) {
+	head = 0; count = 0;
+	writing = FALSE;
+	failing = FALSE;
+	EEIF = 0;
+	EEIE = 1;							// drain on the write complete interrupt
+	
+	// Interrupt as the 5V supply sags well before the brown-out reset
+	HLVDCONbits.VDIRMAG = 0;			// falling voltage
+	HLVDCONbits.HLVDL = 0b1101;			// one of the highest trip points
+	HLVDCONbits.HLVDEN = 1;
+	while (!HLVDCONbits.IRVST) continue;	// reference stable
+	HLVDIF = 0;
+	HLVDIE = 1;
+	Timer_Start(Watch, WATCH, WATCH, TIMER_TASK);
+}
+
+//********************************************************************************
+/**
+* \details  Returns the byte at \em address.  A queued write is returned if
+*			there is one; otherwise, the EEPROM is read once no write is using
+*			the address register.
+*/ 
+//********************************************************************************
+unsigned char DataEE_Read (unsigned char address) {
+	unsigned char i, value;
+	
+	for (;;) {
+		while (EECON1bits.WR) continue;
+		di();
+		if (!EECON1bits.WR) break;		// no new write started meanwhile
+		ei();
+	}
+	i = Find(address);
+	if (i != NONE) value = queue[i].value;
+	else value = ReadCell(address);
+	ei();
+	return value;
+}
+
+//********************************************************************************
+/**
+* \details  Queues a write and returns at once unless the queue is full, in
+*			which case it waits for the oldest write to finish.  Once the supply
+*			is failing every write is finished before returning.
+*/ 
+//********************************************************************************
+void DataEE_Write (unsigned char address, unsigned char value) {
+	unsigned char i;
+	
+	while (count == QUEUESIZE) NOP();
+	di();
+	i = Find(address);
+	if (i != NONE) queue[i].value = value;		// coalesce with the queued write
+	else {
+		i = (head + count) & (QUEUESIZE-1);
+		queue[i].address = address;
+		queue[i].value = value;
+		count++;
+	}
+	if (!writing) StartWrite();
+	ei();
+	if (failing) DataEE_Flush();
+}
+
+void DataEE_Flush (void) {
+	while (count > 0) NOP();			// the interrupt drains the queue
+}
+
+//********************************************************************************
+/**
+* \details  EEPROM write complete: the oldest write is done so the next one is
+*			started.
+*/ 
+//********************************************************************************
+void DataEE_interrupt (void) {
+	if (!writing) return;
+	writing = FALSE;
+	head = (head + 1) & (QUEUESIZE-1);
+	count--;
+	StartWrite();
+}
+
+//********************************************************************************
+/**
+* \details  The supply is failing.  Queued writes already follow each other
+*			back to back, so only the interrupt is turned off and later writes
+*			are made to wait for completion.  The detector is turned round to
+*			flag the supply coming back for \em Watch.
+*/ 
+//********************************************************************************
+void DataEE_PowerFail (void) {
+	HLVDIE = 0;
+	HLVDCONbits.VDIRMAG = 1;			// rising voltage
+	failing = TRUE;
+	if (!writing) StartWrite();
+}
@@ -0,0 +1,25 @@
+#ifndef _DATAEE_H_
+#define _DATAEE_H_
+
+#include "system.h"
+
+extern void DataEE_Init (void);
+// Starts the background writer, the low-voltage detect and its recovery timer.
+
+extern unsigned char DataEE_Read (unsigned char address);
+// Returns the internal EEPROM byte at 'address' including any write still queued for it.
+
+extern void DataEE_Write (unsigned char address, unsigned char value);
+// Queues a write of 'value' to the internal EEPROM 'address' and returns immediately.
+// A queued write to the same address is replaced and unchanged bytes are not written.
+
+extern void DataEE_Flush (void);
+// Waits until every queued write is in the EEPROM.
+
+extern void DataEE_interrupt (void);
+// EEPROM write complete interrupt service.
+
+extern void DataEE_PowerFail (void);
+// Low-voltage interrupt service.  Writes are made without delay until the supply recovers.
+
+#endif
@@ -0,0 +1,124 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	IsrStats.c
+* \details  This module measures how long the interrupt service routine runs
+*			for each of its sources.  It is only built in when ISRSTATS is
+*			defined in IsrStats.h; otherwise the ISR_ENTER and ISR_EXIT marks in
+*			\em high_isr expand to nothing and the SBUS statistics page reports an
+*			error.
+*
+*			Timer1 runs free from the instruction clock, so its counts are
+*			instruction cycles whether the core is on the crystal or the PLL.
+*			The entry mark is the first statement of \em high_isr, after the
+*			compiler has saved the context, so the vectoring and the context save
+*			and restore (about 40 cycles) are not included.  A service that runs
+*			longer than the 65536-cycle range of Timer1 is not measured correctly,
+*			which would be an overrun many times over anyway.
+*
+*			An overrun is counted when the tick is due again as its service
+*			ends, that is another Timer4 period elapsed while the tick was
+*			serviced.  The PIC18 does not nest high priority interrupts, so a
+*			late service shows up as an overrun of the tick and a long service
+*			of another source.  Receive overruns are reset by the receive
+*			service itself and are in the performance counters instead.
+*
+*			With ISRPIN also defined RA5 is high for the duration of the routine
+*			so it can be timed with a logic analyser against the PWM outputs.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "IsrStats.h"
+
+#ifdef ISRSTATS
+
+#define MAXCOUNT	(0xFFFF)
+
+typedef struct _Source {
+	unsigned int count;				/*!< services since the statistics were cleared */
+	unsigned long total;			/*!< cycles of those services */
+	unsigned int longest;			/*!< longest service in cycles */
+	unsigned int overruns;			/*!< services that ended with the source due again */
+} Source;
+
+unsigned int IsrStats_Entry;
+
+static Source sources[ISR_SOURCES];
+
+//********************************************************************************
+/**
+* \details  Ends the service of \em source.  The count and total are halved
+*			together once the count is full so the average follows recent
+*			behaviour without overflowing.
+*/ 
+//********************************************************************************
+void IsrStats_Exit (unsigned char source) {
+	unsigned int now, cycles;
+	Source *s = &sources[source];
+
+	now = TMR1L;
+	now |= (unsigned int)TMR1H << 8;
+	cycles = now - IsrStats_Entry;
+	if (s->count == MAXCOUNT) {
+		s->count >>= 1;
+		s->total >>= 1;
+	}
+	s->count++;
+	s->total += cycles;
+	if (cycles > s->longest) s->longest = cycles;
+	if ((source == ISR_TICK) && TMR4IF) s->overruns++;
+#ifdef ISRPIN
+	LATAbits.LATA5 = 0;
+#endif
+}
+
+#endif
+
+void IsrStats_Init (void) {
+#ifdef ISRSTATS
+#ifdef ISRPIN
+	LATAbits.LATA5 = 0;
+	TRISAbits.TRISA5 = 0;			// spare pin for the logic analyser
+#endif
+	T1CON = 0b00000011;				// Fosc/4, no prescale, 16-bit reads, on
+	IsrStats_Clear();
+#endif
+}
+
+BOOL IsrStats_Get (unsigned char source, unsigned int *count, unsigned int *average,
+				   unsigned int *longest, unsigned int *overruns) {
+#ifdef ISRSTATS
+	Source s;
+	
+	di();
+	s = sources[source];
+	ei();
+	*count = s.count;
+	*average = (s.count > 0) ? (unsigned int)(s.total / s.count) : 0;
+	*longest = s.longest;
+	*overruns = s.overruns;
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void IsrStats_Clear (void) {
+#ifdef ISRSTATS
+	unsigned char source;
+	
+	di();
+	for (source=0; source<ISR_SOURCES; source++) {
+		sources[source].count = 0;
+		sources[source].total = 0;
+		sources[source].longest = 0;
+		sources[source].overruns = 0;
+	}
+	ei();
+#endif
+}
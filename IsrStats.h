@@ -0,0 +1,54 @@
+#ifndef _ISRSTATS_H_
+#define _ISRSTATS_H_
+
+#include "system.h"
+
+//#define ISRSTATS		/* define this variable to time the interrupt service routine */
+//#define ISRPIN		/* also drive RA5 high while the interrupt routine runs */
+
+#define ISR_TICK		(0)			// interrupt sources in the order high_isr tests them
+#define ISR_HLVD		(1)
+#define ISR_EEPROM		(2)
+#define ISR_RX			(3)
+#define ISR_SOURCES		(4)
+
+#ifdef ISRSTATS
+
+extern unsigned int IsrStats_Entry;
+// Timer1 count when the interrupt routine was entered.
+
+#ifdef ISRPIN
+#define ISR_PINHIGH()	(LATAbits.LATA5 = 1)
+#else
+#define ISR_PINHIGH()
+#endif
+
+// First statement of high_isr: Timer1 is read low byte first so the high byte is latched with it
+#define ISR_ENTER()		{ ISR_PINHIGH(); IsrStats_Entry = TMR1L; IsrStats_Entry |= (unsigned int)TMR1H << 8; }
+
+// Last statement of each branch of high_isr
+#define ISR_EXIT(s)		IsrStats_Exit(s)
+
+extern void IsrStats_Exit (unsigned char source);
+// Adds the time since ISR_ENTER to the statistics of 'source' and notes an overrun if the
+// tick is due again already.
+
+#else
+
+#define ISR_ENTER()
+#define ISR_EXIT(s)
+
+#endif
+
+extern void IsrStats_Init (void);
+// Starts Timer1 counting instruction cycles.  Does nothing unless ISRSTATS is defined.
+
+extern BOOL IsrStats_Get (unsigned char source, unsigned int *count, unsigned int *average,
+						  unsigned int *longest, unsigned int *overruns);
+// Returns how often 'source' was serviced, its average and longest service time in instruction
+// cycles, and the number of overruns.  Returns FALSE if the statistics were not built in.
+
+extern void IsrStats_Clear (void);
+// Restarts the statistics of all the sources.
+
+#endif
@@ -0,0 +1,142 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Journal.c
+* \details  This module keeps the configuration parameters in a wear-leveled
+*			journal in the first half of the internal EEPROM.  Parameters that
+*			used to live at fixed addresses, like the start sequence rewritten by
+*			every RUNSEGS, wore out the same few cells; now every change appends
+*			a new record to the next slot of a circular journal, so each cell is
+*			only written once per trip around it.
+*
+*			A record holds the parameter key, a sequence number, the 16-bit value
+*			and a check byte which is written last.  Only a record with a good
+*			check counts, so a write cut short by a power failure leaves the
+*			previous record of that parameter in force.  At power-up the journal
+*			is read once and the newest record of each parameter is cached in
+*			RAM; the sequence numbers are compared modulo 256, which works since
+*			all records in the journal come from the last trip around it.  A
+*			slot that holds the newest record of a parameter is never written
+*			over: that record is first copied to the next slot holding none,
+*			so a write cut short anywhere leaves every parameter a good record.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Journal.h"
+#include "DataEE.h"
+
+#define JOURNALADD	(0x00)				/*!< start of the journal */
+#define NOSLOT		(0xFF)
+#define NOKEY		(0xFF)
+
+static unsigned int values[JOURNALKEYS];	/*!< newest value of each parameter */
+static unsigned char slots[JOURNALKEYS];	/*!< slot of the newest record or NOSLOT */
+static unsigned char head;				/*!< next slot to write */
+static unsigned char sequence;			/*!< sequence number of the next record */
+
+static BOOL Newer (unsigned char seq, unsigned char than) {
+	return (signed char)(seq - than) > 0;
+}
+
+static unsigned char Live (unsigned char slot) {
+	// key whose newest record is in 'slot'
+	unsigned char key;
+	
+	for (key=0; key<JOURNALKEYS; key++) if (slots[key] == slot) return key;
+	return NOKEY;
+}
+
+static unsigned char Free (unsigned char slot) {
+	// next slot after 'slot' that holds no newest record; there are more slots than keys
+	do {
+		if (++slot == JOURNALSLOTS) slot = 0;
+	} while (Live(slot) != NOKEY);
+	return slot;
+}
+
+//********************************************************************************
+/**
+* \details  Writes a record to \em slot.  The check byte goes last, after the
+*			bytes it covers, which the write queue keeps in order.
+*/ 
+//********************************************************************************
+static void Put (unsigned char slot, unsigned char key, unsigned int data) {
+	unsigned char add = JOURNALADD + slot * RECORDSIZE;
+	
+	DataEE_Write(add, key);
+	DataEE_Write(add+1, sequence);
+	DataEE_Write(add+2, data >> 8);
+	DataEE_Write(add+3, data);
+	DataEE_Write(add+4, JOURNALCHECK(key, sequence, (unsigned char)(data >> 8), (unsigned char)data));
+	values[key] = data;
+	slots[key] = slot;
+	sequence++;
+}
+
+//********************************************************************************
+/**
+* \details  Scans the journal for the newest valid record of every parameter
+*			and continues after the newest record of all.
+*/ 
+//********************************************************************************
+void Journal_Init (void) {
+	unsigned char record[RECORDSIZE];
+	unsigned char seqs[JOURNALKEYS];
+	unsigned char slot, i, add, key;
+	unsigned char newest = NOSLOT;
+	
+	for (key=0; key<JOURNALKEYS; key++) {
+		slots[key] = NOSLOT;
+		values[key] = 0xFFFF;			// as an erased parameter reads
+	}
+	add = JOURNALADD;
+	for (slot=0; slot<JOURNALSLOTS; slot++) {
+		for (i=0; i<RECORDSIZE; i++) record[i] = DataEE_Read(add++);
+		key = record[0];
+		if ((key >= JOURNALKEYS) || (record[4] != JOURNALCHECK(key, record[1], record[2], record[3]))) continue;
+		if ((slots[key] == NOSLOT) || Newer(record[1], seqs[key])) {
+			slots[key] = slot;
+			seqs[key] = record[1];
+			values[key] = ((unsigned int)record[2] << 8) | record[3];
+		}
+		if ((newest == NOSLOT) || Newer(record[1], sequence)) {
+			newest = slot;
+			sequence = record[1];
+		}
+	}
+	if (newest == NOSLOT) {
+		head = 0; sequence = 0;
+	} else {
+		head = (newest + 1 == JOURNALSLOTS) ? 0 : newest + 1;
+		sequence++;
+	}
+}
+
+unsigned int ReadWord (unsigned char key) {
+	if (key >= JOURNALKEYS) return 0xFFFF;
+	return values[key];
+}
+
+//********************************************************************************
+/**
+* \details  Records a new value for parameter \em key.  An unchanged value is
+*			not recorded at all.  A record at the head that is still in force,
+*			which may be the old record of \em key itself, is first copied to a
+*			free slot, so it is no longer the only one of its parameter when the
+*			head is written over.
+*/ 
+//********************************************************************************
+void WriteWord (unsigned char key, unsigned int data) {
+	unsigned char live;
+	
+	if (key >= JOURNALKEYS) return;
+	if ((slots[key] != NOSLOT) && (values[key] == data)) return;
+	if ((live = Live(head)) != NOKEY) Put(Free(head), live, values[live]);
+	Put(head, key, data);
+	if (++head == JOURNALSLOTS) head = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include "system.h"
+
+#define JOURNALKEYS		(12)		// parameter keys 0 to 11 (see MemoryMap.h)
+#define JOURNALSLOTS	(25)		// records in the journal
+#define RECORDSIZE		(5)			// key, sequence, value high, value low, check
+
+#define JOURNALCHECK(key, seq, hi, lo)	((key) ^ (seq) ^ (hi) ^ (lo) ^ 0x5A)
+// Check byte of a record.  Erased bytes (0xFF) never form a valid record.
+
+extern void Journal_Init (void);
+// Finds the newest record of every parameter and caches the values.
+
+// read/write a parameter in the internal EEPROM journal
+extern unsigned int ReadWord (unsigned char key);
+extern void WriteWord (unsigned char key, unsigned int data);
+
+#endif
@@ -1,20 +1,20 @@
-#ifndef _MACROS_H_
-#define _MACROS_H_
-
-#include "system.h"
-
-#define ENDMACRO	(0xFFFF)
-#define PLAYMACROS	(0xFFFF)
-
-// read/write a word from internal EEPROM
-extern unsigned int ReadWord (unsigned char address);
-extern void WriteWord (unsigned char address, unsigned int data);
-
-extern unsigned int Macros_Count (void);
-
-extern BOOL Macros_Add(unsigned int macro);
-extern unsigned int Macros_Read(unsigned int macroID);
-
-extern void Macros_Init(void);
-
-#endif
+#ifndef _MACROS_H_
+#define _MACROS_H_
+
+#include "system.h"
+
+#define ENDMACRO	(0xFFFF)
+#define PLAYMACROS	(0xFFFF)
+
+extern unsigned int Macros_Count (void);
+
+extern BOOL Macros_Add(unsigned int macro);
+extern unsigned int Macros_Read(unsigned int macroID);
+
+// write a raw macro image in pieces and then terminate it
+extern BOOL Macros_WriteImage(unsigned int offset, unsigned char buffer[], unsigned int size);
+extern void Macros_EndImage(unsigned int size);
+
+extern void Macros_Init(void);
+
+#endif
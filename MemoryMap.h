@@ -1,18 +1,22 @@
-#ifndef _MEMORYMAP_H_
-#define _MEMORYMAP_H_
-
-#include "Types.h"
-
-#define NIGHTADD		(0x0000)				// Storage for Night Sense parameters
-#define STATEADD		(NIGHTADD) 				// 1 byte - NightState state
-#define OFFTIMEADD		(NIGHTADD+1)			// 1 byte - Delay before turning off in minutes
-#define ONTIMEADD		(NIGHTADD+2)			// 1 byte - Delay before turning on in minutes
-#define DURATIONADD		(NIGHTADD+3)			// 2 bytes - Total on time in minutes
-#define STARTSEQADD		(NIGHTADD+5)			// 2 bytes - First sequence to play on power-up
-#define TOTALSEQADD		(NIGHTADD+7)			// 2 bytes - Number of sequences to play
-#define DEVICEADD		(NIGHTADD+9)			// 1 byte - Protocol address (0xFF is default)
-#define EESEQADD		(0x10)					// Start of EEPROM macro sequences
-
-#define MAXMACROS		(100)					// Allow up to 100 macros
-
-#endif
+#ifndef _MEMORYMAP_H_
+#define _MEMORYMAP_H_
+
+#include "Types.h"
+
+// Parameter keys in the internal EEPROM journal (0x00-0x7F, see Journal.c).  The keys
+// are also the REPORT and CONFIGURE item numbers so they keep their old offsets.
+#define NIGHTADD		(0x0000)				// Night Sense parameters
+#define STATEADD		(NIGHTADD) 				// byte - NightState state
+#define OFFTIMEADD		(NIGHTADD+1)			// byte - Delay before turning off in minutes
+#define ONTIMEADD		(NIGHTADD+2)			// byte - Delay before turning on in minutes
+#define DURATIONADD		(NIGHTADD+3)			// word - Total on time in minutes
+#define RESUMEADD		(NIGHTADD+4)			// word - Sequence playing at the last checkpoint
+#define STARTSEQADD		(NIGHTADD+5)			// word - First sequence to play on power-up
+#define TOTALSEQADD		(NIGHTADD+7)			// word - Number of sequences to play
+#define DEVICEADD		(NIGHTADD+9)			// byte - Protocol address (0xFF is default)
+#define GROUPADD		(NIGHTADD+11)			// byte - Group membership bitmask
+#define EESEQADD		(0x80)					// Start of EEPROM macro sequences
+
+#define MAXMACROS		(63)					// Allow up to 63 macros and the terminator
+
+#endif
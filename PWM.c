@@ -1,227 +1,380 @@
-//************************************************************************************
-//
-// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
-// You are permitted to modify and use this code for personal use only.
-//
-//************************************************************************************
-/**
-* \file   	PWM.c
-* \details  This module implements the Pulse-Width Modulation (PWM) timers that drive
-*			the external FETs.  Four independent hardware timers are used that can
-*			generate PWM pulses from 0 to 100% with a resolution of 10 bits.  Note:
-*			currently only the upper 8 bits of the PWM register are used.  
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//************************************************************************************
-#include "system.h"        /* System funct/params, like osc/peripheral config */
-#include "Types.h"
-#include "PWM.h"
-
-#define	PERIOD		200							/*!< Desired clock in Hz - 5mS */
-#define	SCALE		64							/*!</ Timer 4 prescaler */
-#define	PRCOUNT		(IPERIOD/SCALE/PERIOD)
-
-// PWM state definitions
-typedef enum _PWMState {	
-	OFF, FADING, HOLDING
-} PWMState;
-
-static unsigned int prevPWM[4];		/*!< previous pwm values */
-static unsigned int newPWM[4];		/*!< new pwm values */
-static unsigned int fadeCount;		/*!< count down fade value in 5mS increments */
-static unsigned int counter;		/*!< counter used for fade/hold count down */
-static unsigned int holdCount;		/*!< count down hold value in 5mS increments */
-static PWMState pwmState;			/*!< current PWM state */
-
-//#define SETPWM1(pwm) 	{ CCP3CONbits.CCP3M = 0b1100; CCPR3L = pwm >> 2; CCP3CONbits.DC3B = pwm & 0x03;}
-//#define SETPWM2(pwm) 	{ CCP1CONbits.CCP1M = 0b1100; CCPR1L = pwm >> 2; CCP1CONbits.DC1B = pwm & 0x03;}
-//#define SETPWM3(pwm) 	{ CCP2CONbits.CCP2M = 0b1100; CCPR2L = pwm >> 2; CCP2CONbits.DC2B = pwm & 0x03;}
-//#define SETPWM4(pwm) 	{ CCP4CONbits.CCP4M = 0b1100; CCPR4L = pwm >> 2; CCP4CONbits.DC4B = pwm & 0x03;}
-#define SETPWM1(pwm) 	{ CCP3CONbits.CCP3M = 0b1100; CCPR3L = pwm; CCP3CONbits.DC3B = 0;}
-#define SETPWM2(pwm) 	{ CCP1CONbits.CCP1M = 0b1100; CCPR1L = pwm; CCP1CONbits.DC1B = 0;}
-#define SETPWM3(pwm) 	{ CCP2CONbits.CCP2M = 0b1100; CCPR2L = pwm; CCP2CONbits.DC2B = 0;}
-#define SETPWM4(pwm) 	{ CCP4CONbits.CCP4M = 0b1100; CCPR4L = pwm; CCP4CONbits.DC4B = 0;}
-
-//********************************************************************************
-/**
-* \details  Shared interrupt service routine for the PWM timers, night sense
-*			state machine timing, and the receive UART. 
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PWM_interrupt (void) {
-    unsigned char i;
-    unsigned char done;
-
-    switch (pwmState) {
-        case FADING:
-            if (counter == 0) {
-                // Fade the PWM values
-                done = 0;
-                for (i=CH1; i<=CH4; i++) {
-                    if (prevPWM[i] < newPWM[i]) prevPWM[i]++;
-                    else if (prevPWM[i] > newPWM[i]) prevPWM[i]--;
-                    else done++;
-                }
-
-                // Update the PWM outputs with new values
-                SETPWM1(prevPWM[CH1]);
-                SETPWM2(prevPWM[CH2]);
-                SETPWM3(prevPWM[CH3]); 
-                SETPWM4(prevPWM[CH4]);
-
-                if (done == 4) {
-                    // change to holding state
-                    counter = holdCount;
-                    pwmState = HOLDING;
-                } else {
-                    counter = fadeCount;
-                }
-            }
-            break;
-        case HOLDING:
-            if (counter == 0) {
-                    pwmState = OFF;		// finished holding
-            }
-            break;
-        default:
-            // OFF state
-            break;
-    }
-    if (counter > 0) counter--;
-}
-
-//********************************************************************************
-/**
-* \details  PWM timer and I/O port initialization.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PWM_Init (void) {
-	prevPWM[0] = 0; prevPWM[1] = 0; prevPWM[2] = 0; prevPWM[3] = 0;
-	
-//	APFCON1 = 0x00;				// PWM2 output on pin RC3
-	ANSELA = 0;				// All analog inputs are digital
-	ANSELB = 0;
-	ANSELC = 0;
-	
-	// Set up PWM registers
-	TRISCbits.TRISC3 = 1;			// disable PWM output until set up
-	TRISAbits.TRISA2 = 1;			// disable PWM output until set up
-	TRISCbits.TRISC5 = 1;			// disable PWM output until set up
-	TRISCbits.TRISC6 = 1;			// disable PWM output until set up
-	
-	// PWM1 initialization -- initially off
-	CCP1CONbits.CCP1M = 0b1100;		// PWM mode
-	CCP1CONbits.DC1B = 0b00;		// Lowest 2 bits of PWM duty cycle
-	CCPR1L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
-	CCPTMRS0bits.C1TSEL = 0b00;		// Use Timer2 for this PWM
-	
-	// PWM2 initialization -- initially off
-	CCP2CONbits.CCP2M = 0b1100;		// PWM mode
-	CCP2CONbits.DC2B = 0b00;		// Lowest 2 bits of PWM duty cycle
-	CCPR2L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
-	CCPTMRS0bits.C2TSEL = 0b00;		// Use Timer2 for this PWM
-	
-	// PWM3 initialization -- initially off
-	CCP3CONbits.CCP3M = 0b1100;		// PWM mode
-	CCP3CONbits.DC3B = 0b00;		// Lowest 2 bits of PWM duty cycle
-	CCPR3L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
-	CCPTMRS0bits.C3TSEL = 0b00;		// Use Timer2 for this PWM
-	
-	// PWM4 initialization -- initially off
-	CCP4CONbits.CCP4M = 0b1100;		// PWM mode
-	CCP4CONbits.DC4B = 0b00;		// Lowest 2 bits of PWM duty cycle
-	CCPR4L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
-	CCPTMRS1bits.C4TSEL = 0b00;		// Use Timer2 for this PWM
-	
-	// Set up pwm Timer 2 registers
-	PR2 = 0xFF;				// PWM period value
-	PIR1bits.TMR2IF = 0;			// Clear Timer2 interrupt flag bit
-	T2CONbits.T2CKPS = 0b10;		// Set up Timer2 prescale to /16
-	T2CONbits.TMR2ON = 1;			// Enable Timer2
-	
-	// Turn on the PWM outputs
-	TRISCbits.TRISC3 = 0;			// enable PWM output
-	TRISAbits.TRISA2 = 0;			// enable PWM output
-	TRISCbits.TRISC5 = 0;			// enable PWM output
-	TRISCbits.TRISC6 = 0;			// enable PWM output
-	
-	// Initialize Timer 4 for pwm updates
-	PR4 = PRCOUNT-1;			// PWM update period
-	PIR5bits.TMR4IF = 0;			// Clear Timer4 interrupt flag bit
-	T4CONbits.T4CKPS = 0b11;		// Set up Timer4 prescale to /64
-	TMR4IE = 1;				// Enable Timer4 interrupts
-	PEIE = 1;				// Also enable peripheral interrupts for Timer4 use
-	T4CONbits.TMR4ON = 1;			// Enable Timer4
-	ei();					// Global interrupts enabled
-	
-	counter = 0;
-	pwmState = OFF;				// prevent PWM action
-}
-
-//********************************************************************************
-/**
-* \details  Returns \em TRUE iff the PWM state machine is currently performing a
-*			PWM fade or hold function.  Although the PWM pulses are hardware-based,
-*			the fading and hold features require software timers.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-BOOL PWM_Busy (void) {
-	return (pwmState != OFF);
-}		
-
-//********************************************************************************
-/**
-* \details  Override the active PWM fade/hold functions by setting fixed PWM 
-*			outputs for the four channels.  The pwm value is applied during the 
-*			next PWM period.  Function returns immmediately.  PWM values range 
-*			from 0 to PWM_MAX where PWM_MAX represents 100% duty cycle.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PWM_Set (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4) {
-	// .	
-	pwmState = OFF;	// Stop ramping now
-	__delay_ms(10);	// Wait for next interrupt
-	
-	prevPWM[CH1] = pwm1; SETPWM1(pwm1);
-	prevPWM[CH2] = pwm2; SETPWM2(pwm2);
-	prevPWM[CH3] = pwm3; SETPWM3(pwm3);
-	prevPWM[CH4] = pwm4; SETPWM4(pwm4);
-}	
-
-//********************************************************************************
-/**
-* \details 	Ramps from the previous pwm values for all channels to the passed pwm
-*			value over the fade time which has units of 10 milliseconds.  The hold
-*			time has units of 50 milliseconds.  The total fade/hold function takes 
-*			fade*5 + hold*50 milliseconds.  This function returns immediately and
-*			will prevent another PWM fade/hold event until the current event has
-*			completed.  See also the \em PWM_Busy function.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PWM_Ramp (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4, 
-			   unsigned char fade, unsigned char hold) {
-	if (pwmState != OFF) return;			// don't add a new ramp until the current one is finished
-
-	// Initialize the next ramping stage
-	newPWM[CH1] = pwm1;
-	newPWM[CH2] = pwm2;
-	newPWM[CH3] = pwm3;
-	newPWM[CH4] = pwm4;
-	holdCount = 10*(unsigned int)hold;
-	fadeCount = fade;
-	
-	// Start next ramping now
-	counter = fadeCount;
-	pwmState = FADING;
-}	
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	PWM.c
+* \details  This module implements the Pulse-Width Modulation (PWM) timers that drive
+*			the external FETs.  Four independent hardware timers are used that can
+*			generate PWM pulses from 0 to 100% with a resolution of 10 bits.  Note:
+*			currently only the upper 8 bits of the PWM register are used.  
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//************************************************************************************
+#include "system.h"        /* System funct/params, like osc/peripheral config */
+#include "Types.h"
+#include "PWM.h"
+#include "Power.h"
+#include "Timer.h"
+#include "Counters.h"
+#include "Trace.h"
+
+// PWM state definitions
+typedef enum _PWMState {	
+	OFF, FADING, HOLDING
+} PWMState;
+
+static unsigned int prevPWM[4];		/*!< previous pwm values */
+static unsigned int newPWM[4];		/*!< new pwm values */
+static unsigned int fadeCount;		/*!< count down fade value in 5mS increments */
+static unsigned int counter;		/*!< counter used for fade/hold count down */
+static unsigned int holdCount;		/*!< count down hold value in 5mS increments */
+static PWMState pwmState;			/*!< current PWM state */
+static BOOL holdEnded;				/*!< a hold ran out and no ramp has followed yet */
+static unsigned int holdEnd;		/*!< tick the hold ran out */
+
+#define STREAMTIMEOUT	TIMER_HZ				/*!< streaming ends after 1 second without frames */
+
+static unsigned char frames[2][5];	/*!< double-buffered streamed frames (RGBW, fade) */
+static unsigned char frameWrite;	/*!< buffer the next frame is written to */
+static unsigned char frameLatch;	/*!< buffer holding the pending frame */
+static BOOL framePending;			/*!< a frame is waiting to be latched */
+static BOOL streaming;				/*!< frames are being streamed */
+static BOOL streamTimedOut;			/*!< streaming stopped because frames ceased */
+static unsigned int streamTimer;	/*!< ticks since the last latched frame */
+
+//#define SETPWM1(pwm) 	{ CCP3CONbits.CCP3M = 0b1100; CCPR3L = pwm >> 2; CCP3CONbits.DC3B = pwm & 0x03;}
+//#define SETPWM2(pwm) 	{ CCP1CONbits.CCP1M = 0b1100; CCPR1L = pwm >> 2; CCP1CONbits.DC1B = pwm & 0x03;}
+//#define SETPWM3(pwm) 	{ CCP2CONbits.CCP2M = 0b1100; CCPR2L = pwm >> 2; CCP2CONbits.DC2B = pwm & 0x03;}
+//#define SETPWM4(pwm) 	{ CCP4CONbits.CCP4M = 0b1100; CCPR4L = pwm >> 2; CCP4CONbits.DC4B = pwm & 0x03;}
+#define SETPWM1(pwm) 	{ CCP3CONbits.CCP3M = 0b1100; CCPR3L = pwm; CCP3CONbits.DC3B = 0;}
+#define SETPWM2(pwm) 	{ CCP1CONbits.CCP1M = 0b1100; CCPR1L = pwm; CCP1CONbits.DC1B = 0;}
+#define SETPWM3(pwm) 	{ CCP2CONbits.CCP2M = 0b1100; CCPR2L = pwm; CCP2CONbits.DC2B = 0;}
+#define SETPWM4(pwm) 	{ CCP4CONbits.CCP4M = 0b1100; CCPR4L = pwm; CCP4CONbits.DC4B = 0;}
+
+//********************************************************************************
+/**
+* \details  PWM fade and hold timing, called every system tick from the
+*			tick interrupt.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+static void Tick (void) {
+    unsigned char i;
+    unsigned char done;
+
+    if (streaming) {
+        if (framePending) {
+            // Latch the newest streamed frame
+            for (i=CH1; i<=CH4; i++) newPWM[i] = frames[frameLatch][i];
+            fadeCount = frames[frameLatch][4];
+            framePending = FALSE;
+            streamTimer = 0;
+            holdCount = 0;
+            counter = fadeCount;
+            pwmState = FADING;
+            if (fadeCount == 0) {
+                // no fade -- jump straight to the new levels
+                for (i=CH1; i<=CH4; i++) prevPWM[i] = newPWM[i];
+                SETPWM1(prevPWM[CH1]);
+                SETPWM2(prevPWM[CH2]);
+                SETPWM3(prevPWM[CH3]);
+                SETPWM4(prevPWM[CH4]);
+                TRACE_PWM(prevPWM[CH1], prevPWM[CH2], prevPWM[CH3], prevPWM[CH4]);
+                pwmState = OFF;
+            }
+        } else if (++streamTimer >= STREAMTIMEOUT) {
+            // Host has stopped streaming
+            streaming = FALSE;
+            streamTimedOut = TRUE;
+        }
+    }
+
+    switch (pwmState) {
+        case FADING:
+            if (counter == 0) {
+                // Fade the PWM values
+                done = 0;
+                for (i=CH1; i<=CH4; i++) {
+                    if (prevPWM[i] < newPWM[i]) prevPWM[i]++;
+                    else if (prevPWM[i] > newPWM[i]) prevPWM[i]--;
+                    else done++;
+                }
+
+                // Update the PWM outputs with new values
+                SETPWM1(prevPWM[CH1]);
+                SETPWM2(prevPWM[CH2]);
+                SETPWM3(prevPWM[CH3]); 
+                SETPWM4(prevPWM[CH4]);
+                TRACE_PWM(prevPWM[CH1], prevPWM[CH2], prevPWM[CH3], prevPWM[CH4]);
+
+                if (done == 4) {
+                    // change to holding state
+                    counter = holdCount;
+                    pwmState = HOLDING;
+                } else {
+                    counter = fadeCount;
+                }
+            }
+            break;
+        case HOLDING:
+            if (counter == 0) {
+                    pwmState = OFF;		// finished holding
+                    holdEnd = (unsigned int)Timer_Ticks;
+                    holdEnded = TRUE;
+            }
+            break;
+        default:
+            // OFF state
+            break;
+    }
+    if (counter > 0) counter--;
+}
+
+//********************************************************************************
+/**
+* \details  PWM timer and I/O port initialization.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+void PWM_Init (void) {
+	prevPWM[0] = 0; prevPWM[1] = 0; prevPWM[2] = 0; prevPWM[3] = 0;
+	
+//	APFCON1 = 0x00;				// PWM2 output on pin RC3
+	ANSELA = 0;				// All analog inputs are digital
+	ANSELB = 0;
+	ANSELC = 0;
+	
+	// Set up PWM registers
+	TRISCbits.TRISC3 = 1;			// disable PWM output until set up
+	TRISAbits.TRISA2 = 1;			// disable PWM output until set up
+	TRISCbits.TRISC5 = 1;			// disable PWM output until set up
+	TRISCbits.TRISC6 = 1;			// disable PWM output until set up
+	
+	// PWM1 initialization -- initially off
+	CCP1CONbits.CCP1M = 0b1100;		// PWM mode
+	CCP1CONbits.DC1B = 0b00;		// Lowest 2 bits of PWM duty cycle
+	CCPR1L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
+	CCPTMRS0bits.C1TSEL = 0b00;		// Use Timer2 for this PWM
+	
+	// PWM2 initialization -- initially off
+	CCP2CONbits.CCP2M = 0b1100;		// PWM mode
+	CCP2CONbits.DC2B = 0b00;		// Lowest 2 bits of PWM duty cycle
+	CCPR2L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
+	CCPTMRS0bits.C2TSEL = 0b00;		// Use Timer2 for this PWM
+	
+	// PWM3 initialization -- initially off
+	CCP3CONbits.CCP3M = 0b1100;		// PWM mode
+	CCP3CONbits.DC3B = 0b00;		// Lowest 2 bits of PWM duty cycle
+	CCPR3L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
+	CCPTMRS0bits.C3TSEL = 0b00;		// Use Timer2 for this PWM
+	
+	// PWM4 initialization -- initially off
+	CCP4CONbits.CCP4M = 0b1100;		// PWM mode
+	CCP4CONbits.DC4B = 0b00;		// Lowest 2 bits of PWM duty cycle
+	CCPR4L = 0x00;				// Upper 8 bits of PWM duty cycle (50% duty cycle)
+	CCPTMRS1bits.C4TSEL = 0b00;		// Use Timer2 for this PWM
+	
+	// Set up pwm Timer 2 registers
+	PR2 = 0xFF;				// PWM period value
+	PIR1bits.TMR2IF = 0;			// Clear Timer2 interrupt flag bit
+	T2CONbits.T2CKPS = Timer_Shift ? 0b10 : 0b01;	// Set up Timer2 prescale to /16 on the PLL, /4 otherwise
+	T2CONbits.TMR2ON = 1;			// Enable Timer2
+	
+	// Turn on the PWM outputs
+	TRISCbits.TRISC3 = 0;			// enable PWM output
+	TRISAbits.TRISA2 = 0;			// enable PWM output
+	TRISCbits.TRISC5 = 0;			// enable PWM output
+	TRISCbits.TRISC6 = 0;			// enable PWM output
+	
+	counter = 0;
+	streaming = FALSE;
+	framePending = FALSE;
+	streamTimedOut = FALSE;
+	pwmState = OFF;				// prevent PWM action
+	holdEnded = FALSE;
+	
+	// Fade and hold updates every system tick
+	Timer_Start(Tick, 1, 1, TIMER_ISR);
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE iff the PWM state machine is currently performing a
+*			PWM fade or hold function.  Although the PWM pulses are hardware-based,
+*			the fading and hold features require software timers.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+BOOL PWM_Busy (void) {
+	return (pwmState != OFF);
+}		
+
+//********************************************************************************
+/**
+* \details  Turns the outputs off for a sleep.  The fade or hold stays where
+*			it is since the system tick has already been suspended.  The zero
+*			duty cycles are latched at the end of the next PWM period, before
+*			the clock stops.
+*/ 
+//********************************************************************************
+void PWM_Suspend (void) {
+	SETPWM1(0);
+	SETPWM2(0);
+	SETPWM3(0);
+	SETPWM4(0);
+	TRACE_PWM(0, 0, 0, 0);
+	Power_DelayMs(3);
+}
+
+//********************************************************************************
+/**
+* \details  Restores the outputs and carries on with the frozen fade or hold.
+*/ 
+//********************************************************************************
+void PWM_Resume (void) {
+	SETPWM1(prevPWM[CH1]);
+	SETPWM2(prevPWM[CH2]);
+	SETPWM3(prevPWM[CH3]);
+	SETPWM4(prevPWM[CH4]);
+	TRACE_PWM(prevPWM[CH1], prevPWM[CH2], prevPWM[CH3], prevPWM[CH4]);
+}
+
+//********************************************************************************
+/**
+* \details  Override the active PWM fade/hold functions by setting fixed PWM 
+*			outputs for the four channels.  The pwm value is applied during the 
+*			next PWM period.  Function returns immmediately.  PWM values range 
+*			from 0 to PWM_MAX where PWM_MAX represents 100% duty cycle.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+void PWM_Set (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4) {
+	// .	
+	streaming = FALSE;	// Fixed outputs end any streaming
+	pwmState = OFF;	// Stop ramping now
+	holdEnded = FALSE;
+	Power_DelayMs(10);	// Wait for next interrupt
+	
+	prevPWM[CH1] = pwm1; SETPWM1(pwm1);
+	prevPWM[CH2] = pwm2; SETPWM2(pwm2);
+	prevPWM[CH3] = pwm3; SETPWM3(pwm3);
+	prevPWM[CH4] = pwm4; SETPWM4(pwm4);
+	TRACE_PWM(pwm1, pwm2, pwm3, pwm4);
+}	
+
+//********************************************************************************
+/**
+* \details  Abandons the active fade or hold and leaves the outputs at their
+*			current levels so a new ramp can start right away.
+*/ 
+//********************************************************************************
+void PWM_Stop (void) {
+	streaming = FALSE;
+	pwmState = OFF;
+	holdEnded = FALSE;
+}	
+
+//********************************************************************************
+/**
+* \details 	Ramps from the previous pwm values for all channels to the passed pwm
+*			value over the fade time which has units of 10 milliseconds.  The hold
+*			time has units of 50 milliseconds.  The total fade/hold function takes 
+*			fade*5 + hold*50 milliseconds.  This function returns immediately and
+*			will prevent another PWM fade/hold event until the current event has
+*			completed.  See also the \em PWM_Busy function.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+void PWM_Ramp (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4, 
+			   unsigned char fade, unsigned char hold) {
+	unsigned int gap;
+	
+	if (pwmState != OFF) return;			// don't add a new ramp until the current one is finished
+	if (holdEnded) {
+		// ticks the outputs sat between the segments
+		gap = (unsigned int)Timer_GetTicks() - holdEnd;
+		if (gap > 0) COUNT(segmentGaps);
+		COUNT_MAX(segmentGapMax, gap);
+		holdEnded = FALSE;
+	}
+
+	// Initialize the next ramping stage
+	newPWM[CH1] = pwm1;
+	newPWM[CH2] = pwm2;
+	newPWM[CH3] = pwm3;
+	newPWM[CH4] = pwm4;
+	holdCount = 10*(unsigned int)hold;
+	fadeCount = fade;
+	
+	// Start next ramping now
+	counter = fadeCount;
+	pwmState = FADING;
+}	
+
+//********************************************************************************
+/**
+* \details 	Queues a streamed frame of four PWM levels and a fade rate.  The
+*			frame is written to the idle half of a double buffer and latched by
+*			the next PWM tick, so a frame is never applied half written.  A fade
+*			of zero jumps straight to the new levels; otherwise, the levels ramp
+*			as in \em PWM_Ramp without any hold.  A newer frame that arrives before
+*			the tick simply replaces the pending one.  If no frame arrives for one
+*			second, streaming stops; see \em PWM_StreamTimedOut.
+*/ 
+//********************************************************************************
+void PWM_Frame (unsigned char pwm[], unsigned char fade) {
+	unsigned char i;
+	
+	for (i=CH1; i<=CH4; i++) frames[frameWrite][i] = pwm[i];
+	frames[frameWrite][4] = fade;
+	frameLatch = frameWrite;		// single byte writes are atomic for the interrupt
+	framePending = TRUE;
+	frameWrite ^= 1;
+	if (!streaming) {
+		streamTimedOut = FALSE;
+		streaming = TRUE;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE iff streamed frames are currently driving the outputs.
+*/ 
+//********************************************************************************
+BOOL PWM_Streaming (void) {
+	return streaming;
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE once after the streaming watchdog has expired so the
+*			caller can fall back to sequence playback.
+*/ 
+//********************************************************************************
+BOOL PWM_StreamTimedOut (void) {
+	if (streamTimedOut) {
+		streamTimedOut = FALSE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+//********************************************************************************
+/**
+* \details  Changes the Timer2 prescaler for a new system clock so the PWM
+*			frequency stays the same.  Called with the interrupts disabled as
+*			the clock switches.
+*/ 
+//********************************************************************************
+void PWM_SetClock (BOOL fast) {
+	T2CONbits.T2CKPS = fast ? 0b10 : 0b01;		// 900Hz PWM either way
+}
@@ -1,32 +1,53 @@
-#ifndef _PWM_H_
-#define _PWM_H_
-
-#include "system.h"
-
-#define CH1	  	0
-#define CH2		1
-#define CH3		2
-#define CH4		3
-
-#define PWM_MAX	255
-
-extern void PWM_Init (void);
-
-extern BOOL PWM_Busy (void);
-
-extern void PWM_interrupt (void);
-
-extern void PWM_Set (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4);
-// Set the pwm value for channel ch.  The pwm value is
-// applied during the next PWM period.  Function returns
-// immmediately.  pwm value ranges from 0 to PWM_MAX where
-// PWM_MAX represents 100% modulation.
-
-extern void PWM_Ramp (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4, 
-					  unsigned char fade, unsigned char hold);
-// Ramps from the previous pwm value for channel ch to the passed pwm
-// value over the fade time which has units of 10 milliseconds.  The hold
-// time has units of 50 milliseconds.  This function takes fade*10 + hold*50 
-// milliseconds before it returns.
-
+#ifndef _PWM_H_
+#define _PWM_H_
+
+#include "system.h"
+
+#define CH1	  	0
+#define CH2		1
+#define CH3		2
+#define CH4		3
+
+#define PWM_MAX	255
+
+extern void PWM_Init (void);
+
+extern BOOL PWM_Busy (void);
+
+extern void PWM_Suspend (void);
+// Turns the outputs off before a sleep.  Call with the system tick suspended.
+
+extern void PWM_Resume (void);
+// Restores the outputs and continues the frozen fade or hold.
+
+extern void PWM_Set (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4);
+// Set the pwm value for channel ch.  The pwm value is
+// applied during the next PWM period.  Function returns
+// immmediately.  pwm value ranges from 0 to PWM_MAX where
+// PWM_MAX represents 100% modulation.
+
+extern void PWM_Stop (void);
+// Abandons the active fade or hold leaving the outputs at their current levels.
+
+extern void PWM_Ramp (unsigned char pwm1, unsigned char pwm2, unsigned char pwm3, unsigned char pwm4, 
+					  unsigned char fade, unsigned char hold);
+// Ramps from the previous pwm value for channel ch to the passed pwm
+// value over the fade time which has units of 10 milliseconds.  The hold
+// time has units of 50 milliseconds.  This function takes fade*10 + hold*50 
+// milliseconds before it returns.
+
+extern void PWM_Frame (unsigned char pwm[], unsigned char fade);
+// Queues a streamed frame of four pwm levels and a fade rate which is latched by the
+// next PWM tick.  A fade of 0 sets the levels immediately.  Streaming stops if no frame
+// arrives for one second.
+
+extern BOOL PWM_Streaming (void);
+// Returns TRUE while streamed frames are driving the outputs.
+
+extern BOOL PWM_StreamTimedOut (void);
+// Returns TRUE once after streaming stopped because the frames ceased.
+
+extern void PWM_SetClock (BOOL fast);
+// Rescales Timer2 for the slow or the 4x PLL clock.  Interrupts must be disabled.
+
 #endif
\ No newline at end of file
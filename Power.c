@@ -0,0 +1,261 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Power.c
+* \details  This module implements the idle mode that is entered whenever the
+*			scheduler has no task due.  The SLEEP instruction is executed with
+*			IDLEN set, so only the CPU clock stops while the oscillator, Timer2
+*			and the CCP modules keep generating the PWM outputs.  Any enabled
+*			interrupt wakes the core: the Timer4 system tick or a received
+*			RS-485 character.  The pushbuttons on RA0 and RA1 have no
+*			interrupt-on-change, so they are sampled by a tick timer as before.
+*			The share of time spent idle and the wake-up latency are measured
+*			with the system time stamps.
+*
+*			The clock is also managed here.  The core normally runs straight from
+*			the 3.6864MHz crystal, but bit-banged I2C and SBUS parsing are CPU
+*			bound, so while any module holds a \em Power_Boost the 4x PLL is
+*			switched in for 14.7456MHz.  The PLL is dropped again once nothing has
+*			needed it for 200mS so a stream of short jobs does not pay the PLL
+*			lock time each time.  Every clocked peripheral is rescaled in the same
+*			instant as the clock changes: Timer2 keeps the 900Hz PWM, Timer4 the
+*			5mS tick, and SPBRG keeps 9600 baud.  The
+*			clock only changes while the UART is idle, so no character is lost.
+*
+*			\em Power_Sleep suspends the whole board.  RAM is kept in sleep, so
+*			the sequence, the fade and the hold simply freeze where they are;
+*			each module only parks the hardware it owns and the pin set-up that
+*			sleep changes is kept in a retained block until the wake-up.  Any
+*			character on the bus wakes the processor, and the watchdog polls
+*			the pushbuttons every 128mS since RA0 and RA1 cannot interrupt.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Power.h"
+#include "PWM.h"
+#include "RS485.h"
+#include "Timer.h"
+#include "DataEE.h"
+#include "Pushbuttons.h"
+
+#define HOLDOFF		(40)				/*!< ticks on the PLL after the last release - 200mS */
+#define PLLWAIT		(2000)				/*!< PLLRDY polls before giving up on the PLL */
+
+static unsigned long idleCounts;		/*!< phase counts spent idle */
+static unsigned long totalCounts;		/*!< phase counts measured */
+static unsigned int lastStamp;			/*!< time stamp at the last wake-up */
+static unsigned char maxLatency;		/*!< longest tick to wake-up delay */
+static BOOL fast;						/*!< running on the 4x PLL */
+static unsigned char holds;				/*!< boosts not yet released */
+static unsigned long releaseTick;		/*!< tick of the last release */
+
+typedef struct _Retained {
+	unsigned char trisA, trisB;			/*!< pin directions */
+	unsigned char wpuB;					/*!< PORTB pull-ups */
+	unsigned char fvrCon;				/*!< voltage reference */
+} Retained;
+
+static persistent Retained retained;	/*!< set-up restored after a sleep */
+
+//********************************************************************************
+/**
+* \details  Rescales the clocked peripherals for the new clock.  Called with
+*			the interrupts disabled, in the same critical section as the clock
+*			change, so no interrupt sees a half-changed set.
+*/ 
+//********************************************************************************
+static void Rescale (BOOL on) {
+	Timer_SetClock(on);
+	PWM_SetClock(on);
+	RS485_SetClock(on);
+	fast = on;
+}
+
+static BOOL SerialIdle (void) {
+	// nothing is being received or shifted out
+	return BAUDCONbits.RCIDL && TXSTAbits.TRMT;
+}
+
+//********************************************************************************
+/**
+* \details  Switches to the 4x PLL.  The clock changes as soon as the PLL has
+*			locked, so once PLLRDY is seen the UART is checked again and the
+*			peripherals are rescaled with the interrupts disabled.  A character
+*			that started during the lock wait backs the switch out.  The switch
+*			is also skipped while the UART is busy or if the PLL does not lock;
+*			the next boost tries again.
+*/ 
+//********************************************************************************
+static void ClockUp (void) {
+	unsigned int wait = PLLWAIT;
+	
+	if (!SerialIdle()) return;
+	OSCTUNEbits.PLLEN = 1;
+	while (!OSCCON2bits.PLLRDY) {
+		if (--wait == 0) {
+			OSCTUNEbits.PLLEN = 0;		// PLL failed to lock
+			return;
+		}
+	}
+	di();
+	if (SerialIdle()) Rescale(TRUE);
+	else OSCTUNEbits.PLLEN = 0;			// the UART became busy; stay on the crystal
+	ei();
+}
+
+static void ClockDown (void) {
+	di();
+	OSCTUNEbits.PLLEN = 0;				// back to the crystal immediately
+	Rescale(FALSE);
+	ei();
+}
+
+//********************************************************************************
+/**
+* \details  Selects the IDLE mode and clears the statistics.
+*/ 
+//********************************************************************************
+void Power_Init (void) {
+	OSCCONbits.IDLEN = 1;				// SLEEP enters IDLE; peripherals keep running
+	holds = 0;
+	Power_ClearStats();
+}
+
+//********************************************************************************
+/**
+* \details  Idles the core until the next interrupt.  An interrupt that arrives
+*			just before the SLEEP only delays the caller to the next Timer4
+*			period which always wakes the core within 1.25mS.  The PLL is
+*			dropped first once it has not been needed for a while.
+*/ 
+//********************************************************************************
+void Power_Idle (void) {
+	unsigned int start, end;
+	unsigned char sub, latency;
+	
+	if (fast && (holds == 0) && Timer_TickReached(releaseTick + HOLDOFF) && SerialIdle()) ClockDown();
+	sub = Timer_SubTick;
+	start = Timer_Stamp();
+	SLEEP();
+	NOP();
+	latency = TMR4 >> Timer_Shift;		// phase counts since the timer woke us
+	end = Timer_Stamp();
+	
+	if ((Timer_SubTick != sub) && (latency > maxLatency)) maxLatency = latency;
+	idleCounts += end - start;
+	totalCounts += end - lastStamp;
+	lastStamp = end;
+}
+
+//********************************************************************************
+/**
+* \details  Returns the idle percentage and the longest wake-up latency.
+*/ 
+//********************************************************************************
+void Power_GetStats (unsigned char *idle, unsigned char *latency) {
+	if (totalCounts < 100) *idle = 0;
+	else *idle = idleCounts / (totalCounts / 100);
+	*latency = maxLatency;
+}
+
+void Power_ClearStats (void) {
+	idleCounts = 0;
+	totalCounts = 0;
+	maxLatency = 0;
+	lastStamp = Timer_Stamp();
+}
+
+//********************************************************************************
+/**
+* \details  Runs the core on the 4x PLL until the matching \em Power_Release.
+*			Boosts nest.
+*/ 
+//********************************************************************************
+void Power_Boost (void) {
+	holds++;
+	if (!fast) ClockUp();
+}
+
+void Power_Release (void) {
+	if (holds > 0) holds--;
+	if (holds == 0) releaseTick = Timer_GetTicks();
+}
+
+//********************************************************************************
+/**
+* \details  Returns to the crystal clock at once and drops all boosts; used
+*			before a deep sleep.
+*/ 
+//********************************************************************************
+void Power_ClockDown (void) {
+	holds = 0;
+	if (!fast) return;
+	while (!SerialIdle());
+	ClockDown();
+}
+
+//********************************************************************************
+/**
+* \details  Busy-waits \em ms milliseconds at either clock.  The compiler's
+*			\em __delay_ms is calibrated for the crystal clock only.
+*/ 
+//********************************************************************************
+void Power_DelayMs (unsigned int ms) {
+	while (ms > 0) {
+		if (fast) __delay_ms(4);		// 1mS on the PLL
+		else __delay_ms(1);
+		ms--;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Sleeps until a character arrives or a pushbutton is pressed and
+*			then carries on from the exact point where playback stopped.  The
+*			button that asked for the sleep has to be released first.
+*/ 
+//********************************************************************************
+void Power_Sleep (void) {
+	while (PushButtons_Down()) continue;
+	Power_DelayMs(100);					// let the contacts settle
+	Power_ClockDown();
+	DataEE_Flush();						// no EEPROM write left to wake us
+	
+	// park the modules and the pins
+	Timer_Suspend();
+	PWM_Suspend();
+	RS485_Suspend();
+	retained.trisA = TRISA;
+	retained.trisB = TRISB;
+	retained.wpuB = WPUB;
+	retained.fvrCon = FVRCON;
+	TRISBbits.TRISB4 = 1;				// change SDA to input temporarily
+	TRISBbits.TRISB6 = 1;				// change SCL to input temporarily
+	TRISBbits.TRISB5 = 1;				// pulled up receive input
+	WPUBbits.WPUB5 = 1;
+	FVRCON = 0;							// disable voltage reference
+
+	OSCCONbits.IDLEN = 0;				// full sleep rather than idle
+	WDTCONbits.SWDTEN = 1;				// wake every 128mS to look at the buttons
+	do {
+		SLEEP();
+		NOP();
+	} while (!RS485_CharReady() && !PushButtons_Down());
+	WDTCONbits.SWDTEN = 0;
+	OSCCONbits.IDLEN = 1;
+	
+	// restore the pins and the modules
+	FVRCON = retained.fvrCon;
+	WPUB = retained.wpuB;
+	TRISB = retained.trisB;
+	TRISA = retained.trisA;
+	RS485_Resume();
+	PWM_Resume();
+	PushButtons_Resume();
+	Timer_Resume();
+}
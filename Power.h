@@ -0,0 +1,37 @@
+#ifndef _POWER_H_
+#define _POWER_H_
+
+#include "system.h"
+
+extern void Power_Init (void);
+// Selects IDLE as the SLEEP instruction mode so the PWM keeps running while the core sleeps.
+
+extern void Power_Idle (void);
+// Stops the core until the next interrupt: the Timer4 tick or a received character.
+// Called whenever no task is due.
+
+extern void Power_Sleep (void);
+// Suspends everything until a character arrives or a pushbutton is pressed, then resumes
+// playback where it stopped.
+
+extern void Power_Boost (void);
+// Switches to the 4x PLL until the matching Power_Release.  Call around CPU-bound work.
+
+extern void Power_Release (void);
+// Ends a Power_Boost.  The PLL is dropped from Power_Idle once no boost has been held for
+// 200mS.
+
+extern void Power_ClockDown (void);
+// Drops any boosts and returns to the crystal clock immediately.
+
+extern void Power_DelayMs (unsigned int ms);
+// Waits for 'ms' milliseconds at either clock speed.
+
+extern void Power_GetStats (unsigned char *idle, unsigned char *latency);
+// Returns the percentage of time spent idle and the longest wake-up latency after a timer
+// interrupt in phase counts (about 17uS each), including the interrupt service time.
+
+extern void Power_ClearStats (void);
+// Restarts the idle statistics.
+
+#endif
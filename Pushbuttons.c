@@ -1,203 +1,221 @@
-//************************************************************************************
-//
-// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
-// You are permitted to modify and use this code for personal use only.
-//
-//************************************************************************************
-/**
-* \file   	Pushbuttons.c
-* \details  This module implements the push button interface.  The two pushbuttons
-*		 	are debounced and a toggle or held state is determined based on how long
-*			the pushbutton is held down.  If held down for 5 seconds, a \em HOLD state
-*			is entered; otherwise, a \em PRESSED state is set.  Each pushbutton has
-*			an independent state machine.  Both state machines are sequenced by the
-*			\em Scan function which is invoked periodically every 10mS by an shared
-*			interrupt routine in the PWM module.  
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//************************************************************************************
-
-#include "Types.h"
-#include "Pushbuttons.h"
-
-// Pushbutton state definitions
-typedef enum _PBState {	
-	INACTIVE, DOWNTIMING, PRESSED, HOLD, RELEASECHECK, RELEASECHECK2, UPTIMING, UPTIMING2, WASPRESSED
-} PBState;
-
-#define DEBOUNCETIME	(10)			/*!<  100mS with 10mS scan */
-#define HOLDTIME	(500)			/*!<  5 Sec with 10mS scan */
-#define PB1		(PORTAbits.RA0)		/*!<  PB1 bit input */
-#define PB2		(PORTAbits.RA1)		/*!<  PB2 bit input */
-#define UP		(1)
-#define DOWN		(0)
-
-static PBState b1State, b2State;		/*!<  PB1 & PB2 states */
-static BOOL b1Pressed, b2Pressed;
-static unsigned int b1Timer, b2Timer;
-
-//********************************************************************************
-/**
-* \details  Initialize the Pushbuttons state variables and I/O registers.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PushButtons_Init (void) {
-    TRISAbits.TRISA1 = 1;		// set to input for PB2
-//    WPUAbits.WPUA1 = 1;		// set pull-up for PB2
-    TRISAbits.TRISA0 = 1;		// set to input for PB1
-//    WPUAbits.WPUA0 = 1;		// set pull-up for PB1
-//    OPTION_REGbits.nWPUEN = 0;	// enable pull-ups
-	
-    b1State = INACTIVE;		// initialize the button state
-    b2State = INACTIVE;
-    b1Timer = DEBOUNCETIME;		// set up timers
-    b2Timer = DEBOUNCETIME;
-}
-
-//********************************************************************************
-/**
-* \details  Internal pushbutton scan function.  This code is reused for each
-*			pushbutton.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-static void Scan (PBState* state, unsigned int* tim, unsigned char pb) {
-	unsigned int timer = *tim;
-	
-	switch (*state) {
-		case INACTIVE:
-			if (pb == DOWN) {
-				// start debouncing the down transition
-				timer = DEBOUNCETIME;
-				*state = DOWNTIMING;
-			}
-			break;
-		case DOWNTIMING:
-			if (timer > 0) timer--;
-			else {
-				*state = PRESSED;
-				timer = HOLDTIME;
-			}	
-			break;
-			
-		// Normal WasPressed/Release recovery
-		case UPTIMING:
-			if (timer > 0) timer--;
-			else *state = WASPRESSED;
-			break;
-		case RELEASECHECK:
-			if (pb == UP) {
-				// start debouncing the up transition
-				timer = DEBOUNCETIME;
-				*state = UPTIMING;
-			}
-			break;
-			
-		// These two states are for the Hold recovery to avoid a
-		// WasPressed output after a Hold output
-		case UPTIMING2:
-			if (timer > 0) timer--;
-			else *state = INACTIVE;
-			break;
-		case RELEASECHECK2:
-			if (pb == UP) {
-				// start debouncing the up transition
-				timer = DEBOUNCETIME;
-				*state = UPTIMING2;
-			}
-			break;
-			
-		case PRESSED:
-			// check for held status
-			if (pb == DOWN && timer > 0) {
-				// check how long button is pressed
-				timer--;
-				if (timer == 0) *state = HOLD;
-			} else *state = RELEASECHECK; 		// button was released before 5 seconds
-			break;	
-		default:
-			// Hold or WasPressed state		
-			break;
-	}
-	*tim = timer;	
-}		
-
-//********************************************************************************
-/**
-* \details  Interrupt-driven pushbutton scan function.  See also the PWM module
-*			for details on the interrupt handler that calls this function.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PushButtons_Scan (void) {
-	// Routine should be called every 10 milliseconds
-	Scan(&b1State, &b1Timer, PB1);		// push button 1 state machine/scanning
-	Scan(&b2State, &b2Timer, PB2);		// push button 2 state machine/scanning		
-}
-
-//********************************************************************************
-/**
-* \details  Clears the pushbutton state machine for the \em button.  It is 
-*			necessary to call this function to acknowledge that the pushbutton 
-*			state has been seen and to reset the state machine to capture the 
-*			next pushbutton event.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-void PushButtons_Clear (unsigned char button) {
-	// Clear any latched conditions
-	if (button & BUTTON1) {
-		if (b1State == HOLD) b1State = RELEASECHECK2;	// release hold state
-		else b1State = INACTIVE;			// release was pressed state
-	}
-	if (button & BUTTON2) {
-		if (b2State == HOLD) b2State = RELEASECHECK2;	// release hold state
-		else b2State = INACTIVE;			// release was pressed state
-	}
-}	
-
-//********************************************************************************
-/**
-* \details  Returns \em TRUE iff the \em button is in a \em PRESSED state.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-BOOL PushButtons_Pressed (unsigned char button) {
-	if ((button & BUTTON1) && (b1State == WASPRESSED)) return TRUE;
-	if ((button & BUTTON2) && (b2State == WASPRESSED)) return TRUE;
-	return FALSE;	
-}
-
-//********************************************************************************
-/**
-* \details  Returns \em TRUE iff the \em button is in a \em HOLD state.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-BOOL PushButtons_Held (unsigned char button) {
-	if ((button & BUTTON1) && (b1State == HOLD)) return TRUE;
-	if ((button & BUTTON2) && (b2State == HOLD)) return TRUE;
-	return FALSE;	
-}
-
-//********************************************************************************
-/**
-* \details  Returns \em TRUE iff the \em button is either in a \em PRESSED or
-*			\em HOLD state.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//********************************************************************************
-BOOL PushButtons_Active (unsigned char button) {
-	return (PushButtons_Pressed(button) || PushButtons_Held(button));	
-}
-	
-
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Pushbuttons.c
+* \details  This module implements the push button and cue input interface.  The
+*			two pushbuttons on RA0 and RA1 and the four cue inputs on RB0 to RB3
+*			are sampled together every 10mS by a system tick timer, so the timing
+*			no longer depends on what the main loop is doing.  All inputs are
+*			debounced at once with a vertical counter: bit \em n of two counter
+*			bytes forms a 2-bit counter for input \em n, and an input only changes
+*			state after four samples in a row disagree with it.  If an input is
+*			held down for 5 seconds, a \em HOLD state is entered; otherwise, a
+*			\em PRESSED state is latched on release.  The press, hold, and release
+*			edges are also posted to a small event queue for \em PushButtons_GetEvent.  
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Pushbuttons.h"
+#include "Timer.h"
+
+#define HOLDTIME	(500)			/*!<  5 Sec with 10mS scan */
+#define INPUTS		(6)				/*!<  pushbuttons and cue inputs */
+#define ALLINPUTS	((1 << INPUTS)-1)
+#define BUTTONS		(BUTTON1|BUTTON2)
+#define QUEUESIZE	(8)				/*!<  events held, a power of two */
+
+static unsigned char state;			/*!<  debounced inputs, 1 = down */
+static unsigned char count0, count1;	/*!<  vertical debounce counters */
+static unsigned char timing;		/*!<  inputs counting towards a hold */
+static unsigned char pressed;		/*!<  latched short presses */
+static unsigned char held;			/*!<  latched holds */
+static unsigned char spent;			/*!<  inputs whose release is not a press */
+static unsigned int holdTimer[INPUTS];
+static unsigned char queue[QUEUESIZE];	/*!<  edge events */
+static volatile unsigned char head, tail;
+
+static void Tick (void);
+
+//********************************************************************************
+/**
+* \details  Returns the raw inputs as a mask with a 1 for each input that is
+*			down.  All inputs are active low.
+*/ 
+//********************************************************************************
+static unsigned char Sample (void) {
+	return ~((PORTA & 0x03) | ((PORTB & 0x0F) << 2)) & ALLINPUTS;
+}
+
+static void Post (unsigned char event) {
+	unsigned char next = (head + 1) & (QUEUESIZE-1);
+	
+	if (next != tail) {				// the newest event is dropped when full
+		queue[head] = event;
+		head = next;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Initialize the Pushbuttons state variables and I/O registers.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+void PushButtons_Init (void) {
+    TRISAbits.TRISA1 = 1;		// set to input for PB2
+    TRISAbits.TRISA0 = 1;		// set to input for PB1
+    TRISB |= 0x0F;			// RB0-RB3 are the cue inputs
+    WPUB = 0x0F;			// with weak pull-ups
+    INTCON2bits.RBPU = 0;		// enable PORTB pull-ups
+	
+    state = 0;				// initialize the input state
+    count0 = 0xFF; count1 = 0xFF;
+    timing = 0; pressed = 0; held = 0; spent = 0;
+    head = 0; tail = 0;
+    Timer_Start(Tick, 2, 2, TIMER_ISR);	// scan every 10mS
+}
+
+//********************************************************************************
+/**
+* \details  Interrupt-driven input scan.  The vertical counter of each input
+*			that differs from its debounced state counts down, the others are
+*			reset; the inputs whose counters roll over change state.  The hold
+*			timers only run for inputs that are down and not yet held.
+*/ 
+//********************************************************************************
+static void Tick (void) {
+	unsigned char changed, i, bit;
+	
+	changed = state ^ Sample();
+	count0 = ~(count0 & changed);
+	count1 = count0 ^ (count1 & changed);
+	changed &= count0 & count1;			// counters that rolled over
+	state ^= changed;
+	
+	if ((changed | timing) == 0) return;
+	for (i=0, bit=1; i<INPUTS; i++, bit<<=1) {
+		if (changed & bit) {
+			if (state & bit) {
+				holdTimer[i] = HOLDTIME;
+				timing |= bit;
+				Post(PB_PRESSED | i);
+			} else {
+				if (!(spent & bit)) pressed |= bit;	// released before 5 seconds
+				timing &= ~bit;
+				spent &= ~bit;
+				Post(PB_RELEASED | i);
+			}
+		} else if ((timing & bit) && (--holdTimer[i] == 0)) {
+			timing &= ~bit;
+			held |= bit;
+			spent |= bit;						// no press after a hold
+			Post(PB_HELD | i);
+		}
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Clears the pushbutton state machine for the \em button.  It is 
+*			necessary to call this function to acknowledge that the pushbutton 
+*			state has been seen and to reset the state machine to capture the 
+*			next pushbutton event.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+void PushButtons_Clear (unsigned char button) {
+	// Clear any latched conditions
+	TMR4IE = 0;				// hold off the scan
+	pressed &= ~button;
+	held &= ~button;
+	TMR4IE = 1;
+}	
+
+//********************************************************************************
+/**
+* \details  Returns the oldest queued event or \em PB_NOEVENT.  \em PB_INPUT
+*			and \em PB_KIND take the event apart.
+*/ 
+//********************************************************************************
+unsigned char PushButtons_GetEvent (void) {
+	unsigned char event;
+	
+	if (tail == head) return PB_NOEVENT;
+	event = queue[tail];
+	tail = (tail + 1) & (QUEUESIZE-1);
+	return event;
+}
+
+void PushButtons_Flush (void) {
+	tail = head;
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE while either pushbutton is held down, without any
+*			debouncing.  Used to poll the buttons while asleep.
+*/ 
+//********************************************************************************
+BOOL PushButtons_Down (void) {
+	return (Sample() & BUTTONS) != 0;
+}
+
+//********************************************************************************
+/**
+* \details  Restarts the debouncing after a sleep.  An input that is still
+*			down woke the processor; it must be released before it counts
+*			again so the wake-up press is not taken as a command.
+*/ 
+//********************************************************************************
+void PushButtons_Resume (void) {
+	state = Sample();
+	count0 = 0xFF; count1 = 0xFF;
+	spent = state;
+	timing = 0; pressed = 0; held = 0;
+	PushButtons_Flush();
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE iff the \em button is in a \em PRESSED state.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+BOOL PushButtons_Pressed (unsigned char button) {
+	return (pressed & button) != 0;	
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE iff the \em button is in a \em HOLD state.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+BOOL PushButtons_Held (unsigned char button) {
+	return (held & button) != 0;	
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE iff the \em button is either in a \em PRESSED or
+*			\em HOLD state.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//********************************************************************************
+BOOL PushButtons_Active (unsigned char button) {
+	return (PushButtons_Pressed(button) || PushButtons_Held(button));	
+}
+	
+
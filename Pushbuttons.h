@@ -1,21 +1,42 @@
-#ifndef _PUSHBUTTONS_H_
-#define _PUSHBUTTONS_H_
-
-#include "system.h"
-
-#define BUTTON1		(1)
-#define BUTTON2		(2)
-
-void PushButtons_Init (void);
-
-void PushButtons_Scan (void);
-
-void PushButtons_Clear (unsigned char button);
-
-BOOL PushButtons_Active (unsigned char button);
-
-BOOL PushButtons_Pressed (unsigned char button);
-
-BOOL PushButtons_Held (unsigned char button);
-
-#endif
+#ifndef _PUSHBUTTONS_H_
+#define _PUSHBUTTONS_H_
+
+#include "system.h"
+
+#define BUTTON1		(1)
+#define BUTTON2		(2)
+#define CUE1		(4)			// cue inputs on RB0-RB3
+#define CUE2		(8)
+#define CUE3		(16)
+#define CUE4		(32)
+
+#define PB_CUEFIRST	(2)			// input number of CUE1
+
+#define PB_NOEVENT	(0xFF)
+#define PB_PRESSED	(0x10)		// input went down
+#define PB_HELD		(0x20)		// input has been down for 5 seconds
+#define PB_RELEASED	(0x30)		// input came back up
+#define PB_INPUT(event)	((event) & 0x0F)	// input number: 0 for BUTTON1 to 5 for CUE4
+#define PB_KIND(event)	((event) & 0xF0)
+
+void PushButtons_Init (void);
+
+void PushButtons_Clear (unsigned char button);
+
+BOOL PushButtons_Active (unsigned char button);
+
+BOOL PushButtons_Pressed (unsigned char button);
+
+BOOL PushButtons_Held (unsigned char button);
+
+BOOL PushButtons_Down (void);
+
+void PushButtons_Resume (void);
+
+unsigned char PushButtons_GetEvent (void);
+// Returns the oldest press, hold, or release event or PB_NOEVENT.
+
+void PushButtons_Flush (void);
+// Discards the queued events.
+
+#endif
@@ -1,110 +1,222 @@
-//************************************************************************************
-//
-// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
-// You are permitted to modify and use this code for personal use only.
-//
-//************************************************************************************
-/**
-* \file   	RS485.c
-* \details  This module implements the hardware-level serial port code that manages
-*			the external RS-485 driver chip and internal UART.  The receive buffer
-*			is defined here but is written to by the shared interrupt routine in the
-*			PWM module.  This code also automatically handles the half-duplex RS-485
-*			mode switches between receive and transmit operation. 
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//************************************************************************************
-
-#include "Types.h"
-#include "RS485.h"
-
-#define BAUD		9600
-#define HIGH_SPEED 	1
-
-#if HIGH_SPEED == 1
-#define SPEED 0x4
-#else
-#define SPEED 0
-#endif
-
-#define RX_PIN TRISB5
-#define TX_PIN TRISB7
-
-#define Enable_Transmit()	LATCbits.LATC0 = 1; LATCbits.LATC4 = 1; __delay_ms(5); TxActive=TRUE;
-#define Enable_Receive()	__delay_ms(5); LATCbits.LATC0 = 0; LATCbits.LATC4 = 0; TxActive=FALSE;
-
-static BOOL TxActive;
-unsigned char RS485_RxBuf[256];		// receive buffer
-unsigned char RS485_RdPtr;			// read pointer
-unsigned char RS485_WtPtr;			// write pointer (interrupt)
-
-/* Serial initialization */
-void RS485_Init (void) {
-	// Set up RS485 control pins
-	TRISCbits.TRISC4 = 0;			// Set up RS-485 enable pins
-	TRISCbits.TRISC0 = 0;
-	Enable_Receive();
-	
-	// Set up hardware UART
-	RX_PIN = 1;
-	TX_PIN = 0;
-	SPBRG = (_XTAL_FREQ/(16UL * BAUD) - 1);   
-	RCSTA = 0x90;
-	TXSTA = (SPEED|0x20);
-	
-	// Clear receive buffer
-	RS485_ClearBuffer();
-	
-	// Enable receive interrupt
-	RCIE = 1;
-}
-
-void putch(unsigned char byte) 
-{
-	/* output one byte */
-	while (!TXIF)	/* set when register is empty */
-		continue;
-	TXREG = byte;
-}
-
-unsigned char getch() {
-	/* retrieve one byte */
-	while (RS485_RdPtr == RS485_WtPtr)	/* check for received characters */
-		continue;
-	return RS485_RxBuf[RS485_RdPtr++];	
-}
-
-unsigned char getche(void)
-{
-	unsigned char c;
-	putch(c = getch());
-	return c;
-}
-
-void RS485_WriteChar(unsigned char ch) {
-	if (!TxActive) Enable_Transmit();
-	putch(ch);
-}
-	
-void RS485_Write(unsigned char buffer[], unsigned int size) {
-	unsigned int index = 0;
-	if (!TxActive) Enable_Transmit();
-	while (size > 0) { putch(buffer[index++]); size--; }
-}
-
-BOOL RS485_CharReady (void) {
-	if (TxActive) Enable_Receive();
-	return (RS485_RdPtr != RS485_WtPtr);		/* check for received characters */
-}		
-
-unsigned char RS485_ReadChar(void) {
-	return getch();
-}
-	
-void RS485_Read(unsigned char buffer[], unsigned int size) {
-	unsigned int index = 0;
-	while (size > 0) { buffer[index++] = getch(); size--; }
-}	
-
-
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	RS485.c
+* \details  This module implements the hardware-level serial port code that manages
+*			the external RS-485 driver chip and internal UART.  The receive buffer
+*			is filled by \em RS485_interrupt from the shared interrupt routine.
+*			This code also automatically handles the half-duplex RS-485
+*			mode switches between receive and transmit operation. 
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "RS485.h"
+#include "Power.h"
+#include "Timer.h"
+#include "Counters.h"
+
+#define BAUD		9600
+#define HIGH_SPEED 	1
+
+#if HIGH_SPEED == 1
+#define SPEED 0x4
+#else
+#define SPEED 0
+#endif
+
+#define RX_PIN TRISBbits.TRISB5
+#define TX_PIN TRISBbits.TRISB7
+
+#define Enable_Transmit()	{ LATCbits.LATC0 = 1; LATCbits.LATC4 = 1; Power_DelayMs(5); TxActive=TRUE; }
+#define Enable_Receive()	{ Power_DelayMs(5); LATCbits.LATC0 = 0; LATCbits.LATC4 = 0; TxActive=FALSE; }
+
+static BOOL TxActive;
+unsigned char RS485_RxBuf[256];		// receive buffer
+unsigned char RS485_RdPtr;			// read pointer
+unsigned char RS485_WtPtr;			// write pointer (interrupt)
+volatile unsigned char RS485_Lines;	// complete frames waiting in the buffer (interrupt)
+static BOOL overflow;				// the buffer filled up and the frame arriving is cut short (interrupt)
+
+#define STAMPS		4				// frames waiting whose <LF> time is kept; a power of two
+static unsigned long stampTick[STAMPS];	// system tick when each frame's <LF> arrived (interrupt)
+static unsigned int stampPhase[STAMPS];	// tick phase when each frame's <LF> arrived (interrupt)
+static unsigned char stampFrame[STAMPS];	// frame number each stamp belongs to (interrupt)
+static unsigned char frames;		// frames received, modulo 256 (interrupt)
+
+/* Serial initialization */
+void RS485_Init (void) {
+	// Set up RS485 control pins
+	TRISCbits.TRISC4 = 0;			// Set up RS-485 enable pins
+	TRISCbits.TRISC0 = 0;
+	Enable_Receive();
+	
+	// Set up hardware UART
+	RX_PIN = 1;
+	TX_PIN = 0;
+	SPBRG = (_XTAL_FREQ/(16UL * BAUD) - 1);   
+	RCSTA = 0x90;
+	TXSTA = (SPEED|0x20);
+	
+	// Clear receive buffer
+	RS485_ClearBuffer();
+	
+	// Enable receive interrupt
+	RCIE = 1;
+}
+
+//********************************************************************************
+/**
+* \details  Receive interrupt service.  The character is added to the buffer
+*			and the end of each frame is time-stamped.  Once the buffer is full
+*			the rest of the frame arriving is dropped, but its <LF> is kept as
+*			soon as there is room so the parser sees a short frame and not two
+*			run together.  The UART stops receiving after an overrun until it
+*			is reset, which is done once the characters it still holds have
+*			been read.
+*/ 
+//********************************************************************************
+void RS485_interrupt (void) {
+	unsigned char ch;
+	BOOL full;
+	
+	if (RCSTAbits.FERR) COUNT(rxFraming);	// the error belongs to the character about to be read
+	ch = RCREG;
+	COUNT(rxBytes);
+	full = ((unsigned char)(RS485_WtPtr + 1) == RS485_RdPtr);
+	if (full && !overflow) {
+		overflow = TRUE;
+		COUNT(rxOverruns);
+	}
+	if (!overflow || ((ch == 0x0A) && !full)) {
+		overflow = FALSE;
+		if ((RS485_RxBuf[RS485_WtPtr++] = ch) == 0x0A) RS485_LineIn();
+	}
+	if (RCSTAbits.OERR && !RCIF) {
+		RCSTAbits.CREN = 0;
+		RCSTAbits.CREN = 1;
+		COUNT(rxOverruns);
+	}
+}
+
+void RS485_LineIn (void) {
+	// stamp the frame just ended unless the frames waiting ahead of it hold every stamp
+	unsigned char slot = frames & (STAMPS-1);
+	
+	if (RS485_Lines < STAMPS) {
+		stampTick[slot] = Timer_Ticks;
+		stampPhase[slot] = Timer_Phase();
+		stampFrame[slot] = frames;
+	}
+	frames++;
+	RS485_Lines++;
+}
+
+void RS485_SetClock (BOOL fast) {
+	// Keep the baud rate when the system clock changes -- only while the UART is idle
+	if (fast) SPBRG = (4*_XTAL_FREQ/(16UL * BAUD) - 1);
+	else SPBRG = (_XTAL_FREQ/(16UL * BAUD) - 1);
+}
+
+void putch(unsigned char byte) 
+{
+	/* output one byte */
+	while (!TXIF)	/* set when register is empty */
+		continue;
+	TXREG = byte;
+}
+
+unsigned char getch() {
+	/* retrieve one byte */
+	while (RS485_RdPtr == RS485_WtPtr)	/* check for received characters */
+		NOP();
+	return RS485_RxBuf[RS485_RdPtr++];	
+}
+
+unsigned char getche(void)
+{
+	unsigned char c;
+	putch(c = getch());
+	return c;
+}
+
+void RS485_WriteChar(unsigned char ch) {
+	if (!TxActive) Enable_Transmit();
+	putch(ch);
+}
+	
+void RS485_Write(unsigned char buffer[], unsigned int size) {
+	unsigned int index = 0;
+	if (!TxActive) Enable_Transmit();
+	while (size > 0) { putch(buffer[index++]); size--; }
+}
+
+void RS485_Suspend (void) {
+	// Listen for the falling edge of a start bit while asleep
+	if (TxActive) Enable_Receive();
+	RS485_ClearBuffer();
+	BAUDCONbits.WUE = 1;
+}
+
+void RS485_Resume (void) {
+	// Drop the character that woke us -- it was never clocked in
+	Power_DelayMs(2);
+	BAUDCONbits.WUE = 0;
+	RS485_ClearBuffer();
+}
+
+void RS485_ClearBuffer (void) {
+	RCIE = 0;
+	RS485_RdPtr = 0; RS485_WtPtr = 0; RS485_Lines = 0;
+	overflow = FALSE;
+	RCIE = 1;
+}
+
+BOOL RS485_CharReady (void) {
+	if (TxActive) Enable_Receive();
+	return (RS485_RdPtr != RS485_WtPtr);		/* check for received characters */
+}		
+
+BOOL RS485_FrameReady (void) {
+	// a whole frame has arrived or a long frame has half filled the buffer
+	return (RS485_Lines != 0) || ((unsigned char)(RS485_WtPtr - RS485_RdPtr) >= sizeof(RS485_RxBuf)/2);
+}
+
+void RS485_FrameDone (void) {
+	// the parser has read up to and including the <LF> of a frame
+	RCIE = 0;
+	if (RS485_Lines > 0) RS485_Lines--;
+	RCIE = 1;
+}
+
+BOOL RS485_FrameStamp (unsigned long *tick, unsigned int *phase) {
+	// when the <LF> of the frame being parsed arrived; FALSE if it was not stamped
+	unsigned char frame, slot;
+	BOOL stamped;
+	
+	RCIE = 0;
+	frame = frames - RS485_Lines;
+	slot = frame & (STAMPS-1);
+	stamped = (RS485_Lines != 0) && (stampFrame[slot] == frame);
+	*tick = stampTick[slot];
+	*phase = stampPhase[slot];
+	RCIE = 1;
+	return stamped;
+}
+
+unsigned char RS485_ReadChar(void) {
+	return getch();
+}
+	
+void RS485_Read(unsigned char buffer[], unsigned int size) {
+	unsigned int index = 0;
+	while (size > 0) { buffer[index++] = getch(); size--; }
+}	
+
+
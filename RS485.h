@@ -1,21 +1,30 @@
-#ifndef _RS485_H_
-#define _RS485_H_
-
-#include "system.h"
-
-extern unsigned char RS485_RxBuf[256];		// receive buffer
-extern unsigned char RS485_RdPtr;			// read pointer
-extern unsigned char RS485_WtPtr;			// write pointer (interrupt)
-
-void RS485_Init (void);
-
-#define RS485_ClearBuffer()		RS485_RdPtr = 0; RS485_WtPtr = 0
-BOOL RS485_CharReady (void);
-
-void RS485_WriteChar(unsigned char ch);
-void RS485_Write(unsigned char buffer[], unsigned int size);
-
-unsigned char RS485_ReadChar(void);
-void RS485_Read(unsigned char buffer[], unsigned int size);
-
-#endif
+#ifndef _RS485_H_
+#define _RS485_H_
+
+#include "system.h"
+
+extern unsigned char RS485_RxBuf[256];		// receive buffer
+extern unsigned char RS485_RdPtr;			// read pointer
+extern unsigned char RS485_WtPtr;			// write pointer (interrupt)
+extern volatile unsigned char RS485_Lines;	// complete frames waiting in the buffer (interrupt)
+
+void RS485_Init (void);
+void RS485_interrupt (void);		// receive interrupt service
+void RS485_LineIn (void);			// a frame's <LF> is in the buffer (interrupt)
+
+void RS485_ClearBuffer (void);
+void RS485_SetClock (BOOL fast);
+void RS485_Suspend (void);
+void RS485_Resume (void);
+BOOL RS485_CharReady (void);
+BOOL RS485_FrameReady (void);
+void RS485_FrameDone (void);
+BOOL RS485_FrameStamp (unsigned long *tick, unsigned int *phase);
+
+void RS485_WriteChar(unsigned char ch);
+void RS485_Write(unsigned char buffer[], unsigned int size);
+
+unsigned char RS485_ReadChar(void);
+void RS485_Read(unsigned char buffer[], unsigned int size);
+
+#endif
@@ -1,371 +1,627 @@
-//************************************************************************************
-//
-// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
-// You are permitted to modify and use this code for personal use only.
-//
-//************************************************************************************
-/**
-* \file   	SBUS.c
-* \details  This module implements the Simple Bus Exchange Protocol (SBUS) which is 
-*			loosely based on the ASCII Modbus protocol.  The overall message format
-*			consists of a start character ":", followed by a two-character hexadecimal
-*			(single byte) device address, and then a two-character hexadecimal message 
-*			type, followed by four or more characters of hexadecimal command-dependent 
-*			data, and, one byte of checksum which is currently not used and
-*			always set to "00", which is finally terminated by a <CR><LF>.  Every 
-*			message generates a reply which repeats the 
-*			first part of the sent message and then follows with the length word or 
-*			an error code.  Only the device whose address matches the message will
-*			reply.  A broadcast address of "FF" is responded to by all devices so it
-*			is the user's responsibility to only use the broadcast mode when only
-*			a single device is on the RS-485 bus to avoid bus contention.
-*
-*			For example, to request a status report, the following ASCII string
-*			(without quotes) would be sent: ":FF60FFFF00"<CR><LF> and this reply is 
-*			received: ":FF60FFFF00050501680000003DFF003D00"<CR><LF>.  Refer to the 
-*			user manual or code for more details on the protocol commands.
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//************************************************************************************
-
-#include <string.h>
-#include "SBUS.h"
-#include "RS485.h"
-#include "Sequences.h"
-#include "EEPROM.h"
-#include "MemoryMap.h"
-#include "NightSense.h"
-#include "Macros.h"
-#include "PWM.h"
-
-#define CR			(0x0D)
-#define LF			(0x0A)
-#define READSEGS	(0x10)
-#define WRITESEGS	(0x20)
-#define RUNSEGS		(0x30)
-#define ERASESEGS	(0x40)
-#define CONFIGURE	(0x50)
-#define REPORT		(0x60)
-#define READMACROS	(0x70)
-#define WRITEMACROS	(0x80)
-#define DISPLAY		(0x90)
-
-#define TIMEOUT		(500)		// time-out between characters in mS
-#define ERROR		(0xFFFF)
-#define ERRSTATUS	(0xEF00)
-
-extern unsigned int activeSequence;			// active sequence to play (defined in main.c)
-extern unsigned int maxAddress, minAddress;	// sequence start and end address (defined in main.c)
-extern BOOL override;						// override outputs via SBUS (defined in main.c)
-extern BOOL playMacros;						// play EEPROM macros if TRUE (defined in main.c)
-
-static unsigned char parameters[256];
-static unsigned char deviceAdd;	
-
-void SBUS_Init (void) {
-	RS485_Init();
-	deviceAdd = eeprom_read(DEVICEADD);		// protocol address 
-}
-
-static BOOL checkChar (unsigned char expectedChar) {
-	unsigned int timer = TIMEOUT;
-	unsigned char ch = 0x00;
-	
-	while (timer > 0 && ch != expectedChar) {
-		if (RS485_CharReady()) {
-			ch = RS485_ReadChar();
-			timer = TIMEOUT;
-		}	
-		__delay_ms(1); timer--;
-	}
-	return (ch == expectedChar);	
-}
-
-static BOOL getChar (unsigned char * receivedChar) {
-	unsigned int timer = TIMEOUT;
-	
-	while (timer > 0) {
-		if (RS485_CharReady()) {
-			*receivedChar = RS485_ReadChar();
-			return TRUE;
-		}	
-		__delay_ms(1); timer--;
-	}
-	return FALSE;	
-}
-
-static unsigned char toHex (unsigned char nibble) {
-	if (nibble < 10) return ('0' + nibble);
-	else return (('A' - 10) + nibble);
-}
-
-static unsigned char fromHex (unsigned char hex) {
-	if (hex >= 'A' && hex <= 'F') return (hex - ('A' - 10));
-	else if (hex >= 'a' && hex <= 'f') return (hex - ('a' - 10));
-	else if (hex >= '0' && hex <= '9') return (hex - '0');
-	else return 0;
-}	
-
-static unsigned int getByte (void) {
-	unsigned char ch;
-	unsigned char byte;
-	
-	if (getChar(&byte)) {
-		if (getChar(&ch)) return ((fromHex(byte) << 4) | fromHex(ch));
-	}
-	return ERROR;	
-}
-
-static unsigned int getWord (void) {
-	unsigned int word = getByte();
-	unsigned int result;
-	
-	if (word == ERROR) return ERROR;
-	result = getByte();
-	if (result == ERROR) return ERROR;
-	return ((word << 8) | result);	
-}
-
-static void sendByte (unsigned char byte) {
-	unsigned char buf[2];
-	
-	buf[0] = toHex(byte >> 4);
-	buf[1] = toHex(byte & 0x0F);
-	RS485_Write(buf, 2); 
-}
-
-static void sendWord (unsigned int word) {
-	sendByte(word >> 8);
-	sendByte(word & 0xFF);
-}
-
-static void sendPrefix (unsigned char id, unsigned char cmd, unsigned int address) {
-	RS485_WriteChar(':');
-	sendByte(id);
-	sendByte(cmd);
-	sendWord(address);
-	cmd = address >> 8;
-}
-
-static void sendString (const unsigned char str[]) {
-	RS485_Write((unsigned char *)str, strlen(str)); 
-}
-
-static void endOfMessage (void) {
-	sendString("00\r\n");   // end of message
-}
-
-static unsigned int readParameters (void) {
-	unsigned int command, length;
-
-	length = 0;
-	for (;;) {
-		command = getByte();
-		if (command == ERROR || length>255) break;
-		parameters[length++] = command;
-	}
-	return (length-2);
-}
-
-static sendReportItem (unsigned int item) {
-	unsigned int length;
-	unsigned char onTime, offTime;
-	BOOL flag;
-	
-	NightSense_GetParam(&flag, &length, &onTime, &offTime);
-	switch (item) {
-		case STATEADD: sendByte(flag); break;
-		case OFFTIMEADD: sendByte(offTime); break;
-		case ONTIMEADD: sendByte(onTime); break;
-		case DURATIONADD: sendWord(length); break;
-		case STARTSEQADD:
-		case TOTALSEQADD: sendWord(ReadWord(item)); break;
-		case DEVICEADD: sendByte(deviceAdd); break;
-		case (DEVICEADD+1): sendWord(Seq_Count()); break;
-		default: break;
-	}
-}
-
-static sendAllReportItems () {
-	unsigned int item;
-	
-	for (item=STATEADD; item<(DEVICEADD+2); item++) {
-		sendReportItem(item);
-	}
-}							
-
-void SBUS_Process_Command (void) {
-	unsigned char ch, onTime, offTime, deviceID;
-	BOOL flag;
-	unsigned int command, address, length, index, i, size;
-	
-	if (RS485_CharReady()) {
-		ch = RS485_ReadChar();
-		if (ch == ':') {
-			// valid start of command
-			deviceID = getByte();
-			if (deviceID == 0xFF || deviceID == deviceAdd) {
-				// received valid starting byte 'FF' or should be our internal address
-				command = getByte();	// retrieve the next command byte
-				address = getWord(); 	// retrieve the address
-				switch (command) {
-					case READSEGS:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF	
-									
-						// read EEPROM or FLASH contents
-						sendPrefix(deviceID, READSEGS, address); sendWord(length);
-						if (command != ERROR) {
-							while (length > 0) {
-								size = Seq_CopyToBuffer(address, parameters);
-								if (size == 0) break;
-								sendByte(size);
-								for (i=0; i<size; i++) sendByte(parameters[i]);  // send sequence data
-								address++; length--;
-							}
-						} else sendWord(ERRSTATUS | READSEGS);
-						break;
-						
-					case WRITESEGS:
-						length = readParameters();
-						
-						// write the seqences to memory
-						sendPrefix(deviceID, WRITESEGS, address);
-						if (length >= BYTESPERSEQ) {
-							index = 0;							
-							while (length >= BYTESPERSEQ) {
-								// extract RGBW, hold, fade and add to or create a sequence
-								if (address != 0xFFFF) {
-									if (!Seq_AddTo(address, &parameters[index+2], parameters[index+1], parameters[index])) 
-										break;
-								} else {
-									if (!Seq_New(&parameters[index+2], parameters[index+1], parameters[index]))
-										break;
-									address = Seq_GetActive();  // any more blocks will be added to this sequence
-								}
-								length -= BYTESPERSEQ; index += BYTESPERSEQ;	
-							}	
-							if (length == 0) sendWord(index);
-							else sendWord(ERRSTATUS | WRITESEGS);
-						} else sendWord(ERRSTATUS | WRITESEGS);						
-						break;
-						
-					case RUNSEGS:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// set up the run parameters
-						sendPrefix(deviceID, RUNSEGS, address);
-						if (Seq_Find(address) == FIND_OK && Seq_Find(address+length-1) == FIND_OK) {
-							WriteWord (STARTSEQADD, address);
-							WriteWord (TOTALSEQADD, length);
-							minAddress = address;
-							maxAddress = address+length-1;
-							sendWord(length);
-							activeSequence = minAddress;
-							override = FALSE;
-						} else sendWord(ERRSTATUS | RUNSEGS);
-						break;
-						
-					case DISPLAY:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// set up the run parameters
-						sendPrefix(deviceID, DISPLAY, address);
-						override = TRUE;
-						PWM_Set (address >> 8, address & 0xFF, length >> 8, length & 0xFF);
-						sendWord(length);
-						break;
-						
-					case ERASESEGS:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// erase the segments in this range
-						sendPrefix(deviceID, ERASESEGS, address);
-						if (Seq_Delete_Range (address, length)) sendWord(length);						
-						else sendWord(ERRSTATUS | ERASESEGS);	
-						break;
-						
-					case CONFIGURE:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// update the configuration parameter
-						sendPrefix(deviceID, CONFIGURE, address);
-						switch (address) {
-							case STATEADD: NightSense_Enable(length != 0); break;
-							case OFFTIMEADD: NightSense_SetOffDelay(length); break;
-							case ONTIMEADD: NightSense_SetOnDelay(length); break;
-							case DURATIONADD: NightSense_SetDuration(length); break;
-							case STARTSEQADD:
-							case TOTALSEQADD: WriteWord(address, length); break;
-							case DEVICEADD: eeprom_write(address, length); deviceAdd = length; break;
-							default: address = 0xFFFF;	
-						}	
-						if (address == 0xFFFF) sendWord(ERRSTATUS | CONFIGURE); 
-						else sendWord(length);
-						break;
-						
-					case REPORT:
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// reply with this configuration parameter
-						sendPrefix(deviceID, REPORT, address);
-						if (address == 0xFFFF) sendAllReportItems();
-						else sendReportItem(address);
-						break;
-						
-					case READMACROS:
-						length = getWord();
-						checkChar(LF);		// skip the LRC, CR, and LF
-						
-						// set up the run parameters
-						sendPrefix(deviceID, READMACROS, address);
-						if (address == 0xFFFF) length = Macros_Count();
-						if (length <= Macros_Count()) {
-							sendWord(length);
-							for (i=0; i<length; i++) {
-								sendWord(Macros_Read(i));
-							}	
-						} else sendWord(ERRSTATUS | READMACROS);
-						break;
-						
-					case WRITEMACROS:
-						length = readParameters();
-						
-						// Write macros to EEPROM
-						sendPrefix(deviceID, WRITEMACROS, address);
-						if ((address == 0) && ((length>>1) < MAXMACROS)) {
-							sendWord(length); address = length;
-							while (length >= 2) {
-								Macros_Add(((unsigned int)parameters[length] << 8) | parameters[length+1]);
-								length -= 2;
-							}
-							if (address > 0) {
-								activeSequence = 0;
-								minAddress = activeSequence;
-								maxAddress = activeSequence+Macros_Count()-1;
-								WriteWord(STARTSEQADD, PLAYMACROS);	 	// enable macro playback
-								playMacros = TRUE;
-							}							
-						} else sendWord(ERRSTATUS | WRITEMACROS);	
-						break;
-						
-					default:
-						checkChar(LF);	// ignore command
-						break;
-				}
-				endOfMessage();						
-			}	
-		} else {
-			// ignore everything up to next LF or time-out
-			checkChar(LF);
-		}
-	}
-	RS485_ClearBuffer();
-}	
-	
-
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	SBUS.c
+* \details  This module implements the Simple Bus Exchange Protocol (SBUS) which is 
+*			loosely based on the ASCII Modbus protocol.  The overall message format
+*			consists of a start character ":", followed by a two-character hexadecimal
+*			(single byte) device address, and then a two-character hexadecimal message 
+*			type, followed by four or more characters of hexadecimal command-dependent 
+*			data, and, one byte of checksum which is currently not used and
+*			always set to "00", which is finally terminated by a <CR><LF>.  Every 
+*			message generates a reply which repeats the 
+*			first part of the sent message and then follows with the length word or 
+*			an error code.  Only the device whose address matches the message will
+*			reply.  A broadcast address of "FF" is responded to by all devices so it
+*			is the user's responsibility to only use the broadcast mode when only
+*			a single device is on the RS-485 bus to avoid bus contention.
+*
+*			For example, to request a status report, the following ASCII string
+*			(without quotes) would be sent: ":FF60FFFF00"<CR><LF> and this reply is 
+*			received: ":FF60FFFF00050501680000003DFF003D00"<CR><LF>.  Refer to the 
+*			user manual or code for more details on the protocol commands.
+*
+*			Besides the unicast and broadcast commands there are quiet and group
+*			addresses, bulk image transfer, live streaming, bus time sync and
+*			run-time statistics; each command, REPORT item and STATS page is
+*			described with the command table in SBUS.h.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//************************************************************************************
+
+#include <string.h>
+#include "SBUS.h"
+#include "RS485.h"
+#include "Sequences.h"
+#include "EEPROM.h"
+#include "MemoryMap.h"
+#include "NightSense.h"
+#include "Macros.h"
+#include "PWM.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Timer.h"
+#include "Journal.h"
+#include "IsrStats.h"
+#include "Counters.h"
+#include "Trace.h"
+
+#define CR			(0x0D)
+#define LF			(0x0A)
+
+#define SYNCOFFSET	(GROUPADD+1)	// REPORT items for the time sync
+#define SYNCSLEW	(GROUPADD+2)
+
+
+#define STATSTASKS	(0x0000)	// STATS pages
+#define STATSIDLE	(0x0001)
+#define STATSISR	(0x0002)
+#define STATSCOUNTS	(0x0003)
+#define STATSTRACE	(0x0004)
+#define STATSRESET	(0x0001)	// STATS length flag to clear the page
+
+#define BROADCAST	(0xFF)		// all devices, with reply
+#define QUIETCAST	(0xFE)		// all devices, no reply
+#define GROUPCAST	(0xE0)		// E0-E7: members of groups 0-7, no reply
+
+#define TIMEOUT		(TIMER_HZ/2)	// time-out between characters in ticks - 500mS
+#define ERROR		(0xFFFF)
+#define ERRSTATUS	(0xEF00)
+
+extern unsigned int activeSequence;			// active sequence to play (defined in main.c)
+extern unsigned int maxAddress, minAddress;	// sequence start and end address (defined in main.c)
+extern BOOL override;						// override outputs via SBUS (defined in main.c)
+extern BOOL playMacros;						// play EEPROM macros if TRUE (defined in main.c)
+extern BOOL restart;						// restart playback at minAddress (defined in main.c)
+extern BOOL startPending;					// wait for startTick before restarting (defined in main.c)
+extern unsigned long startTick;				// scheduled start tick (defined in main.c)
+
+static unsigned char parameters[256];
+static unsigned char deviceAdd;	
+static unsigned char groups;			// group membership bitmask
+static BOOL quiet;						// suppress the reply to group and quiet broadcasts
+static BOOL bulkActive;					// bulk transfer in progress
+static unsigned int bulkTarget;			// BULKSEQS or BULKMACROS
+static unsigned int bulkTotal;			// total image size in bytes
+static unsigned int bulkOffset;			// next expected image offset
+static unsigned int streamSeq;			// sequence number of the last streamed frame
+static BOOL badFrame;					// the frame being parsed is malformed
+static BOOL frameOpen;					// the <LF> ending the frame has not been read
+
+void SBUS_Init (void) {
+	RS485_Init();
+	deviceAdd = ReadWord(DEVICEADD);		// protocol address 
+	groups = ReadWord(GROUPADD);			// group membership
+}
+
+static BOOL checkChar (unsigned char expectedChar) {
+	unsigned long deadline = Timer_GetTicks() + TIMEOUT;
+	unsigned char ch = 0x00;
+	
+	while (ch != expectedChar) {
+		if (RS485_CharReady()) {
+			ch = RS485_ReadChar();
+			frameOpen = (ch != LF);
+			deadline = Timer_GetTicks() + TIMEOUT;
+		} else if (Timer_TickReached(deadline)) {
+			COUNT(parseTimeouts);
+			badFrame = TRUE;
+			frameOpen = FALSE;
+			break;
+		} else Power_Idle();				// the next character or tick wakes us
+	}
+	return (ch == expectedChar);	
+}
+
+static BOOL getChar (unsigned char * receivedChar) {
+	unsigned long deadline = Timer_GetTicks() + TIMEOUT;
+	
+	if (!frameOpen) {
+		badFrame = TRUE;				// the frame ended early; the next one is not ours to read
+		return FALSE;
+	}
+	while (!RS485_CharReady()) {
+		if (Timer_TickReached(deadline)) {
+			COUNT(parseTimeouts);
+			badFrame = TRUE;			// the rest of the frame never came
+			frameOpen = FALSE;
+			return FALSE;
+		}
+		Power_Idle();					// the next character or tick wakes us
+	}
+	*receivedChar = RS485_ReadChar();
+	frameOpen = (*receivedChar != LF);
+	return TRUE;
+}
+
+static unsigned char toHex (unsigned char nibble) {
+	if (nibble < 10) return ('0' + nibble);
+	else return (('A' - 10) + nibble);
+}
+
+static unsigned char fromHex (unsigned char hex) {
+	if (hex >= 'A' && hex <= 'F') return (hex - ('A' - 10));
+	else if (hex >= 'a' && hex <= 'f') return (hex - ('a' - 10));
+	else if (hex >= '0' && hex <= '9') return (hex - '0');
+	badFrame = TRUE;
+	return 0;
+}	
+
+static unsigned int getByte (void) {
+	unsigned char ch;
+	unsigned char byte;
+	
+	if (getChar(&byte)) {
+		if (getChar(&ch)) return ((fromHex(byte) << 4) | fromHex(ch));
+	}
+	return ERROR;	
+}
+
+static unsigned int getWord (void) {
+	unsigned int word = getByte();
+	unsigned int result;
+	
+	if (word == ERROR) return ERROR;
+	result = getByte();
+	if (result == ERROR) return ERROR;
+	return ((word << 8) | result);	
+}
+
+static void sendByte (unsigned char byte) {
+	unsigned char buf[2];
+	
+	if (quiet) return;
+	buf[0] = toHex(byte >> 4);
+	buf[1] = toHex(byte & 0x0F);
+	RS485_Write(buf, 2); 
+}
+
+static void sendWord (unsigned int word) {
+	sendByte(word >> 8);
+	sendByte(word & 0xFF);
+}
+
+static void sendPrefix (unsigned char id, unsigned char cmd, unsigned int address) {
+	if (quiet) return;
+	RS485_WriteChar(':');
+	sendByte(id);
+	sendByte(cmd);
+	sendWord(address);
+	cmd = address >> 8;
+}
+
+static void sendString (const unsigned char str[]) {
+	if (quiet) return;
+	RS485_Write((unsigned char *)str, strlen(str)); 
+}
+
+static void endOfMessage (void) {
+	sendString("00\r\n");   // end of message
+}
+
+static unsigned int readParameters (void) {
+	// Read hexadecimal bytes up to the terminating <CR>.  Returns the number of data bytes
+	// received, not counting the trailing checksum byte.  A frame that is too long for the
+	// buffer, has an odd number of digits or stops short is read to its end and marked bad.
+	unsigned char hi = 0, lo = 0;
+	unsigned int length = 0;
+
+	while (getChar(&hi) && (hi != CR) && getChar(&lo) && (lo != CR)) {
+		if (length < sizeof(parameters)) parameters[length++] = (fromHex(hi) << 4) | fromHex(lo);
+		else badFrame = TRUE;
+	}
+	if (hi != CR) badFrame = TRUE;
+	if (length == 0) return 0;
+	return (length-1);
+}
+
+static void skipFrame (void) {
+	// skip the LRC, CR, and LF unless the frame has already ended
+	if (frameOpen) checkChar(LF);
+}
+
+static BOOL bulkWrite (unsigned int offset, unsigned int size) {
+	if (bulkTarget == BULKSEQS) return Seq_WriteImage(offset, parameters, size);
+	return Macros_WriteImage(offset, parameters, size);
+}
+
+static BOOL bulkFinish (void) {
+	// The whole image has arrived -- switch playback over to it if it holds anything to play.
+	// A bad image leaves the playback mode as it was and the transfer has to start over.
+	unsigned int total;
+	
+	bulkActive = FALSE;
+	if (bulkTarget == BULKSEQS) {
+		if (!Seq_CheckImage(bulkTotal) || ((total = Seq_Count()) == 0)) return FALSE;
+		WriteWord(STARTSEQADD, 0x0000);		// enable normal playback
+		WriteWord(TOTALSEQADD, total);
+		playMacros = FALSE;
+	} else {
+		Macros_EndImage(bulkTotal);
+		if ((total = Macros_Count()) == 0) return FALSE;
+		WriteWord(STARTSEQADD, PLAYMACROS);	// enable macro playback
+		playMacros = TRUE;
+	}
+	activeSequence = 0;
+	minAddress = activeSequence;
+	maxAddress = activeSequence+total-1;
+	override = FALSE;
+	return TRUE;
+}
+
+static sendReportItem (unsigned int item) {
+	unsigned int length;
+	unsigned char onTime, offTime;
+	int offset, remaining;
+	BOOL flag;
+	
+	NightSense_GetParam(&flag, &length, &onTime, &offTime);
+	Timer_GetSync(&offset, &remaining);
+	switch (item) {
+		case STATEADD: sendByte(flag); break;
+		case OFFTIMEADD: sendByte(offTime); break;
+		case ONTIMEADD: sendByte(onTime); break;
+		case DURATIONADD: sendWord(length); break;
+		case STARTSEQADD:
+		case TOTALSEQADD: sendWord(ReadWord(item)); break;
+		case DEVICEADD: sendByte(deviceAdd); break;
+		case (DEVICEADD+1): sendWord(Seq_Count()); break;
+		case GROUPADD: sendByte(groups); break;
+		case SYNCOFFSET: sendWord(offset); break;
+		case SYNCSLEW: sendWord(remaining); break;
+		default: break;
+	}
+}
+
+static BOOL sendStats (unsigned int page) {
+	unsigned char task;
+	unsigned int period, maxRun, late;
+	unsigned char idle, latency;
+	unsigned char source;
+	unsigned int count, average, longest, overruns;
+	CountersBlock counters;
+	unsigned int *counter = (unsigned int *)&counters;
+	TraceEntry entry;
+	unsigned char entries;
+	unsigned int lost;
+	
+	switch (page) {
+		case STATSTASKS:
+			sendByte(Sched_Count());
+			for (task=0; task<Sched_Count(); task++) {
+				Sched_GetStats(task, &period, &maxRun, &late);
+				sendWord(period); sendWord(maxRun); sendWord(late);
+			}
+			break;
+		case STATSIDLE:
+			Power_GetStats(&idle, &latency);
+			sendByte(idle); sendByte(latency);
+			break;
+		case STATSISR:
+			if (!IsrStats_Get(ISR_TICK, &count, &average, &longest, &overruns)) return FALSE;
+			sendByte(ISR_SOURCES);
+			for (source=0; source<ISR_SOURCES; source++) {
+				IsrStats_Get(source, &count, &average, &longest, &overruns);
+				sendWord(count); sendWord(average); sendWord(longest); sendWord(overruns);
+			}
+			break;
+		case STATSCOUNTS:
+			if (!Counters_Get(&counters)) return FALSE;
+			sendByte(COUNTERS_SIZE);
+			for (source=0; source<COUNTERS_SIZE; source++) sendWord(counter[source]);
+			break;
+		case STATSTRACE:
+			if (!Trace_Open(&entries, &lost)) return FALSE;
+			sendByte(entries); sendWord(lost);
+			for (source=0; source<entries; source++) {
+				Trace_Get(source, &entry);
+				sendWord(entry.tick);
+				sendByte(entry.level[0]); sendByte(entry.level[1]);
+				sendByte(entry.level[2]); sendByte(entry.level[3]);
+			}
+			Trace_Close();
+			break;
+		default: return FALSE;
+	}
+	return TRUE;
+}
+
+static void clearStats (unsigned int page) {
+	switch (page) {
+		case STATSTASKS: Sched_ClearStats(); break;
+		case STATSIDLE: Power_ClearStats(); break;
+		case STATSISR: IsrStats_Clear(); break;
+		case STATSCOUNTS: Counters_Clear(); break;
+		case STATSTRACE: Trace_Clear(); break;
+		default: break;
+	}
+}
+
+static sendAllReportItems () {
+	unsigned int item;
+	
+	for (item=STATEADD; item<=SYNCSLEW; item++) {
+		sendReportItem(item);
+	}
+}							
+
+void SBUS_Process_Command (void) {
+	unsigned char ch, onTime, offTime, deviceID;
+	BOOL flag;
+	unsigned int command, address, length, index, i, size;
+	unsigned long lfTick;
+	unsigned int lfPhase;
+	SeqCursor cursor;
+	
+	// only parse once a frame has arrived so the task never waits on the bus
+	if (RS485_CharReady() && RS485_FrameReady()) {
+		Power_Boost();			// parse and reply on the PLL
+		ch = RS485_ReadChar();
+		if (ch == ':') {
+			// valid start of command
+			badFrame = FALSE; frameOpen = TRUE;
+			deviceID = getByte();
+			quiet = (deviceID == QUIETCAST) || ((deviceID & 0xF8) == GROUPCAST);
+			if (badFrame) {
+				skipFrame();
+				COUNT(droppedFrames);
+			} else if (deviceID == BROADCAST || deviceID == QUIETCAST || deviceID == deviceAdd ||
+				(((deviceID & 0xF8) == GROUPCAST) && (groups & (1 << (deviceID & 0x07))))) {
+				// received valid starting byte 'FF', a broadcast, one of our groups, or our internal address
+				command = getByte();	// retrieve the next command byte
+				address = getWord(); 	// retrieve the address
+				
+				// read the whole frame before acting on any of it
+				switch (command) {
+					case WRITESEGS:
+					case WRITEMACROS:
+					case RUNAT:
+					case BULKDATA:
+					case STREAM:
+						length = readParameters(); break;
+					case REPORT:
+						length = 0; break;
+					default:
+						length = getWord(); break;
+				}
+				skipFrame();
+				if (badFrame) {
+					// a damaged frame is dropped without a reply
+					COUNT(droppedFrames);
+					command = ERROR; quiet = TRUE;
+				}
+				
+				switch (command) {
+					case READSEGS:
+						// stream the EEPROM contents in one pass
+						sendPrefix(deviceID, READSEGS, address); sendWord(length);
+						if (Seq_Open(&cursor, address) == FIND_OK) {
+							while (length > 0) {
+								size = 0;
+								while ((size <= sizeof(parameters)-BYTESPERSEQ) && Seq_ReadSegment(&cursor, &parameters[size]))
+									size += BYTESPERSEQ;
+								sendByte(size);
+								for (i=0; i<size; i++) sendByte(parameters[i]);  // send sequence data
+								length--;
+								if (!Seq_NextSequence(&cursor)) break;
+							}
+						}
+						break;
+						
+					case WRITESEGS:
+						// write the seqences to memory
+						sendPrefix(deviceID, WRITESEGS, address);
+						if (length >= BYTESPERSEQ) {
+							index = 0;							
+							while (length >= BYTESPERSEQ) {
+								// extract RGBW, hold, fade and add to or create a sequence
+								if (address != 0xFFFF) {
+									if (!Seq_AddTo(address, &parameters[index+2], parameters[index+1], parameters[index])) 
+										break;
+								} else {
+									if (!Seq_New(&parameters[index+2], parameters[index+1], parameters[index]))
+										break;
+									address = Seq_GetActive();  // any more blocks will be added to this sequence
+								}
+								length -= BYTESPERSEQ; index += BYTESPERSEQ;	
+							}	
+							Seq_Commit();
+							if (length == 0) sendWord(index);
+							else sendWord(ERRSTATUS | WRITESEGS);
+						} else sendWord(ERRSTATUS | WRITESEGS);						
+						break;
+						
+					case RUNSEGS:
+						// set up the run parameters
+						sendPrefix(deviceID, RUNSEGS, address);
+						if ((length != 0) && Seq_Find(address) == FIND_OK && Seq_Find(address+length-1) == FIND_OK) {
+							WriteWord (STARTSEQADD, address);
+							WriteWord (TOTALSEQADD, length);
+							minAddress = address;
+							maxAddress = address+length-1;
+							sendWord(length);
+							activeSequence = minAddress;
+							override = FALSE;
+							restart = TRUE;		// abandon the playing sequence
+						} else sendWord(ERRSTATUS | RUNSEGS);
+						break;
+						
+					case DISPLAY:
+						// set up the run parameters
+						sendPrefix(deviceID, DISPLAY, address);
+						override = TRUE;
+						PWM_Set (address >> 8, address & 0xFF, length >> 8, length & 0xFF);
+						sendWord(length);
+						break;
+						
+					case ERASESEGS:
+						// erase the segments in this range
+						sendPrefix(deviceID, ERASESEGS, address);
+						flag = Seq_Delete_Range (address, length);
+						Seq_Commit();
+						if (flag) sendWord(length);						
+						else sendWord(ERRSTATUS | ERASESEGS);	
+						break;
+						
+					case CONFIGURE:
+						// update the configuration parameter
+						sendPrefix(deviceID, CONFIGURE, address);
+						switch (address) {
+							case STATEADD: NightSense_Enable(length != 0); break;
+							case OFFTIMEADD: NightSense_SetOffDelay(length); break;
+							case ONTIMEADD: NightSense_SetOnDelay(length); break;
+							case DURATIONADD: NightSense_SetDuration(length); break;
+							case STARTSEQADD:
+							case TOTALSEQADD: WriteWord(address, length); break;
+							case DEVICEADD: 
+								if (length >= GROUPCAST) address = 0xFFFF;	// reserved for broadcasts
+								else { WriteWord(address, length); deviceAdd = length; }
+								break;
+							case GROUPADD: WriteWord(address, length); groups = length; break;
+							default: address = 0xFFFF;	
+						}	
+						if (address == 0xFFFF) sendWord(ERRSTATUS | CONFIGURE); 
+						else sendWord(length);
+						break;
+						
+					case REPORT:
+						// reply with this configuration parameter
+						sendPrefix(deviceID, REPORT, address);
+						if (address == 0xFFFF) sendAllReportItems();
+						else sendReportItem(address);
+						break;
+						
+					case READMACROS:
+						// set up the run parameters
+						sendPrefix(deviceID, READMACROS, address);
+						if (address == 0xFFFF) length = Macros_Count();
+						if (length <= Macros_Count()) {
+							sendWord(length);
+							for (i=0; i<length; i++) {
+								sendWord(Macros_Read(i));
+							}	
+						} else sendWord(ERRSTATUS | READMACROS);
+						break;
+						
+					case WRITEMACROS:
+						// Write macros to EEPROM
+						sendPrefix(deviceID, WRITEMACROS, address);
+						if ((address == 0) && ((length & 1) == 0) && ((length>>1) < MAXMACROS)) {
+							sendWord(length); address = length;
+							for (index=0; index+1<length; index+=2) {
+								Macros_Add(((unsigned int)parameters[index] << 8) | parameters[index+1]);
+							}
+							if (address > 0) {
+								activeSequence = 0;
+								minAddress = activeSequence;
+								maxAddress = activeSequence+Macros_Count()-1;
+								WriteWord(STARTSEQADD, PLAYMACROS);	 	// enable macro playback
+								playMacros = TRUE;
+							}							
+						} else sendWord(ERRSTATUS | WRITEMACROS);	
+						break;
+						
+					case TIMESYNC:
+						// discipline the local tick against the master tick count at this frame's <LF>
+						sendPrefix(deviceID, TIMESYNC, address);
+						if (RS485_FrameStamp(&lfTick, &lfPhase)) {
+							Timer_Sync(((unsigned long)address << 16) | length, lfTick, lfPhase);
+							sendWord(length);
+						} else sendWord(ERRSTATUS | TIMESYNC);
+						break;
+						
+					case RUNAT:
+						// start sequences 'address' onwards at a scheduled tick
+						sendPrefix(deviceID, RUNAT, address);
+						if (length == 6) {
+							length = ((unsigned int)parameters[0] << 8) | parameters[1];
+							if ((length != 0) && Seq_Find(address) == FIND_OK && Seq_Find(address+length-1) == FIND_OK) {
+								startTick = ((unsigned long)parameters[2] << 24) | ((unsigned long)parameters[3] << 16) |
+											((unsigned int)parameters[4] << 8) | parameters[5];
+								minAddress = address;
+								maxAddress = address+length-1;
+								activeSequence = minAddress;
+								playMacros = FALSE;
+								override = FALSE;
+								startPending = TRUE;
+								restart = TRUE;		// abandon the playing sequence
+								sendWord(length);
+							} else sendWord(ERRSTATUS | RUNAT);
+						} else sendWord(ERRSTATUS | RUNAT);
+						break;
+						
+					case STATS:
+						// reply with this statistics page
+						sendPrefix(deviceID, STATS, address);
+						if (sendStats(address)) {
+							if (length & STATSRESET) clearStats(address);
+						} else sendWord(ERRSTATUS | STATS);
+						break;
+						
+					case BULKSTART:
+						// prepare to receive an image of 'length' bytes
+						sendPrefix(deviceID, BULKSTART, address);
+						bulkActive = FALSE;
+						if ((length != 0) && (((address == BULKSEQS) && (length <= Seq_ImageLimit())) || 
+							((address == BULKMACROS) && ((length & 1) == 0) && ((length>>1) <= MAXMACROS)))) {
+							bulkTarget = address; bulkTotal = length; bulkOffset = 0;
+							bulkActive = TRUE;
+							if (address == BULKSEQS) override = TRUE;	// stop playback while the sequences are replaced
+							sendWord(length);
+						} else sendWord(ERRSTATUS | BULKSTART);
+						break;
+						
+					case BULKDATA:
+						// write the chunk at image offset 'address'
+						sendPrefix(deviceID, BULKDATA, address);
+						flag = bulkActive && (address <= bulkOffset) && ((unsigned long)address + length <= bulkTotal) &&
+							   bulkWrite(address, length);
+						if (flag) {
+							if (address + length > bulkOffset) bulkOffset = address + length;
+							if ((bulkOffset == bulkTotal) && !bulkFinish()) {
+								flag = FALSE; bulkOffset = 0;		// refused whole; start over
+							}
+						}
+						if (flag) {
+							sendWord(bulkOffset);					// acknowledge with the next expected offset
+						} else {
+							sendWord(ERRSTATUS | BULKDATA);
+							sendWord(bulkOffset);					// where the host should resume
+						}
+						break;
+						
+					case STREAM:
+						// latch the frame unless it is older than the last one
+						if ((length >= 4) && (!PWM_Streaming() || 
+							((((address - streamSeq) & 0x8000) == 0) && (address != streamSeq)))) {
+							streamSeq = address;
+							override = TRUE;
+							PWM_Frame(parameters, (length > 4) ? parameters[4] : 0);
+						}
+						quiet = TRUE;		// never answered
+						break;
+						
+					default:
+						break;		// ignore command
+				}
+				endOfMessage();						
+			} else {
+				skipFrame();		// another device's frame
+			}
+		} else {
+			// ignore everything up to next LF or time-out
+			if (ch != LF) checkChar(LF);
+			COUNT(droppedFrames);
+		}
+		quiet = FALSE;
+		RS485_FrameDone();		// frames that arrived meanwhile wait their turn
+		Power_Release();
+	}
+}	
+	
+
@@ -1,10 +1,60 @@
-#ifndef _SBUS_H_
-#define _SBUS_H_
-
-#include "system.h"
-
-void SBUS_Init (void);
-
-void SBUS_Process_Command(void);
-
-#endif
+#ifndef _SBUS_H_
+#define _SBUS_H_
+
+#include "system.h"
+
+// SBUS command table.  A frame is ':', the device address, the command, the address word,
+// any command data and a "00" checksum, all as hex, and <CR><LF>.  The reply repeats the
+// first three fields.  FF reaches every device, FE every device with no reply, and E0-E7
+// the members of groups 0-7 (a CONFIGURE bitmask) with no reply.  The whole frame is read
+// before it is acted on; one that is not hex, has an odd number of digits, overflows the
+// 256-byte parameter buffer or pauses for more than 500mS is dropped without a reply.
+// Frames that arrive meanwhile are queued and handled in turn.  A device asleep from its
+// pushbutton loses the character that wakes it, so send a lone <LF> and wait 10mS first.
+#define READSEGS	(0x10)		// address first sequence, length count; streams the segments
+#define WRITESEGS	(0x20)		// address sequence or FFFF for a new one, data segments
+#define RUNSEGS		(0x30)		// address first sequence, length count; restarts playback
+#define ERASESEGS	(0x40)		// address first sequence, length last sequence
+#define CONFIGURE	(0x50)		// address item (MemoryMap.h keys), length value
+#define REPORT		(0x60)		// address item or FFFF for all; items 0C and 0D are the last
+								// sync offset and the part still being slewed out
+#define READMACROS	(0x70)		// length count, or address FFFF for all
+#define WRITEMACROS	(0x80)		// address 0000, data macro words replacing the macros
+#define DISPLAY		(0x90)		// address and length the four levels, held until the next RUNSEGS
+#define BULKSTART	(0xA0)		// address target (BULKSEQS, BULKMACROS), length image bytes
+#define BULKDATA	(0xB0)		// address byte offset, data chunk; replies with the next expected
+								// offset, or an error and that offset for a chunk beyond it.
+								// Chunks at or below it are taken again, and an empty chunk
+								// only asks where to resume.  An image with nothing to play
+								// is refused with offset 0 when complete and the playback
+								// mode is left as it was
+#define STREAM		(0xC0)		// address frame number, data four levels and an optional fade;
+								// never answered, older frames are dropped and playback
+								// resumes one second after the last frame
+#define TIMESYNC	(0xD0)		// address and length the master's tick count, high word first,
+								// at the end of the frame; the local tick is slewed to match.
+								// An error if more than three frames were waiting ahead of it
+#define RUNAT		(0xE0)		// address first sequence, data count word and tick long word
+#define STATS		(0xF0)		// address page, length bit 0 clears the page once it is sent
+
+// STATS pages
+//   0000  each scheduled task: period in ticks, longest run in phase counts (about 17uS)
+//         and late starts
+//   0001  percentage of time idle and the longest wake-up after a timer interrupt in phase
+//         counts
+//   0002  each interrupt source (tick, low voltage, EEPROM, receive): service count, average
+//         and longest service in instruction cycles, and overruns (tick only); ISRSTATS builds
+//   0003  count of words that follow, then the CountersBlock of Counters.h in order; absent
+//         from builds without COUNTERS
+//   0004  PWM output trace: entry count, changes lost since the last clear, then each entry
+//         as the low word of its tick and the four levels, oldest first; clearing drops only
+//         the entries sent; TRACE builds
+
+#define BULKSEQS	(0x0000)	// bulk transfer targets
+#define BULKMACROS	(0x0001)
+
+void SBUS_Init (void);
+
+void SBUS_Process_Command(void);
+
+#endif
@@ -0,0 +1,103 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Scheduler.c
+* \details  This module implements a small run-to-completion task scheduler that
+*			is clocked by the system tick.  Each task has a period and a deadline in
+*			ticks.  \em Sched_Run starts every task that is due, in the order the
+*			tasks were added, and each task returns as soon as its work is done so
+*			that a slow service can no longer starve the others.  The longest run
+*			time and the number of late starts are kept for every task so that the
+*			timing can be checked over SBUS.
+*/ 
+//************************************************************************************
+
+#include "Scheduler.h"
+#include "Timer.h"
+
+typedef struct _Task {
+	TaskProc proc;					/*!< task function */
+	unsigned int period;			/*!< ticks between runs */
+	unsigned char deadline;			/*!< allowed lateness in ticks */
+	BOOL enabled;					/*!< task may run */
+	unsigned int due;				/*!< tick the task is next due */
+	unsigned int maxRun;			/*!< longest run in phase counts */
+	unsigned int late;				/*!< starts after the deadline */
+} Task;
+
+static Task tasks[MAXTASKS];
+static unsigned char taskCount;
+
+void Sched_Init (void) {
+	taskCount = 0;
+}
+
+unsigned char Sched_Add (TaskProc proc, unsigned int period, unsigned char deadline) {
+	Task *task = &tasks[taskCount];
+	
+	if (taskCount >= MAXTASKS) return MAXTASKS;
+	task->proc = proc;
+	task->period = period;
+	task->deadline = deadline;
+	task->enabled = TRUE;
+	task->due = (unsigned int)Timer_GetTicks();
+	task->maxRun = 0;
+	task->late = 0;
+	return taskCount++;
+}
+
+void Sched_Enable (unsigned char task, BOOL on) {
+	if (task >= taskCount) return;
+	tasks[task].enabled = on;
+	tasks[task].due = (unsigned int)Timer_GetTicks();
+}
+
+BOOL Sched_Run (void) {
+	unsigned char i;
+	unsigned int now, lateness, start, run;
+	BOOL ran = FALSE;
+	Task *task;
+	
+	for (i=0; i<taskCount; i++) {
+		task = &tasks[i];
+		now = (unsigned int)Timer_GetTicks();
+		lateness = now - task->due;
+		if (!task->enabled || (lateness & 0x8000)) continue;		// not due yet
+		
+		// run the task and account for its timing
+		if (lateness > task->deadline) task->late++;
+		start = Timer_Stamp();
+		task->proc();
+		run = Timer_Stamp() - start;
+		if (run > task->maxRun) task->maxRun = run;
+		ran = TRUE;
+		
+		// schedule the next run -- missed periods are skipped, not run back-to-back
+		task->due += task->period;
+		if (((unsigned int)Timer_GetTicks() - task->due) < 0x8000) task->due = now + task->period;
+	}
+	return ran;
+}
+
+unsigned char Sched_Count (void) {
+	return taskCount;
+}
+
+void Sched_GetStats (unsigned char task, unsigned int *period, unsigned int *maxRun, unsigned int *late) {
+	*period = tasks[task].period;
+	*maxRun = tasks[task].maxRun;
+	*late = tasks[task].late;
+}
+
+void Sched_ClearStats (void) {
+	unsigned char i;
+	
+	for (i=0; i<taskCount; i++) {
+		tasks[i].maxRun = 0;
+		tasks[i].late = 0;
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "system.h"
+
+#define MAXTASKS	6				// size of the task table
+
+typedef void (*TaskProc)(void);
+
+extern void Sched_Init (void);
+// Empties the task table.
+
+extern unsigned char Sched_Add (TaskProc proc, unsigned int period, unsigned char deadline);
+// Adds the task 'proc' which runs every 'period' system ticks (5mS) and should start no more than
+// 'deadline' ticks after it becomes due.  The task identifier is returned.
+
+extern void Sched_Enable (unsigned char task, BOOL on);
+// Enables or suspends the 'task'.  An enabled task becomes due immediately.
+
+extern BOOL Sched_Run (void);
+// Runs each task that is due once, to completion, in the order they were added.
+// TRUE is returned if any task ran.
+
+extern unsigned char Sched_Count (void);
+// Returns the number of tasks in the table.
+
+extern void Sched_GetStats (unsigned char task, unsigned int *period, unsigned int *maxRun, unsigned int *late);
+// Returns the 'period' of the 'task', its longest run time in phase counts (about 17uS each),
+// and how many times it started after its deadline.
+
+extern void Sched_ClearStats (void);
+// Clears the run time and deadline statistics of all the tasks.
+
+#endif
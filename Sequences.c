@@ -1,251 +1,442 @@
-//************************************************************************************
-//
-// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
-// You are permitted to modify and use this code for personal use only.
-//
-//************************************************************************************
-/**
-* \file   	Sequences.c
-* \details  The PWM sequence management is controlled by this module.  Using the
-*			contained routines it is possible to define, delete, and read sequences
-*			which are stored in external EEPROM.  Each sequence consists of of one
-*			or more entries of fade, hold, and PWM settings for four channels. 
-* \author   Michael Griebling
-* \date   	10 Nov 2011
-*/ 
-//************************************************************************************
-
-#include "Sequences.h"
-#include "EEPROM.h" 
-
-static unsigned int activeSeq;		// active sequence address
-static unsigned int activeIndex;	// address of sequence in FLASH/EEPROM
-static unsigned int lastSeq;		// last sequence address in FLASH/EEPROM
-static unsigned int lastIndex;		// address of last sequence
-static BOOL EEPROMPresent;			// set to TRUE if EEPROM is present
-
-unsigned char MAGIC[] = {0x55, 0xAA};	// special value to check for EEPROM initialization
-
-void Seq_Init (void) {
-	// Initializes the sequence buffers, points to the first sequence (0), and verifies that EEPROM is
-	// present and how many sequences are stored there.
-	unsigned char buffer[2];
-	unsigned int lastAdd;
-	
-	EEPROM_Init();
-	activeSeq = 0; activeIndex = 0;
-	EEPROMPresent = FALSE;
-	if (EEPROM_Present()) {
-		// Check if EEPROM needs initialization
-		lastAdd = EEPROM_GetSize() - 2;
-		EEPROMPresent = TRUE;
-		EEPROM_Read(lastAdd, buffer, 2);
-		if ((buffer[0] != MAGIC[0]) || (buffer[1] != MAGIC[1])) {
-			Seq_DeleteAll();					// erase all sequences
-			EEPROM_Write(lastAdd, MAGIC, 2);	// initialize EEPROM
-		}
-	}	
-}
-
-static unsigned int SkipToEnd (unsigned int add) {
-	// Moves to the end of the active sequence
-	unsigned char eechar;
-	
-	eechar = EEPROM_ReadChar(add);
-	while (eechar != ENDMARK) {
-		add += BYTESPERSEQ;
-		eechar = EEPROM_ReadChar(add);
-	}	
-	return add;
-}
-
-FindResult Seq_Find (unsigned int seqNumber) {
-	unsigned int add = 0;
-	unsigned int seq;
-	
-	// Check if any sequences are defined
-	if (EEPROM_ReadChar(0) == ENDMARK) {
-		lastIndex = 0; lastSeq = 0; 
-		return NO_SEQUENCES;
-	}	
-	
-	// Look for sequence
-	for (seq=0; seq<seqNumber; seq++) {
-		add = SkipToEnd(add);
-		
-		if (EEPROM_ReadChar(add+1) == ENDMARK) {
-			// update the last sequence variables
-			lastSeq = seq; 
-			lastIndex = add;
-			if (seq == 0) return AT_LAST_SEQUENCE;
-			
-			// find the start of the sequence
-			add--;
-			while (EEPROM_ReadChar(add) != ENDMARK) add -= BYTESPERSEQ;
-			lastIndex = add+1;
-			return AT_LAST_SEQUENCE;
-		}
-		add++;	// skip end of sequence marker	
-	}
-	activeSeq = seqNumber;
-	activeIndex = add;
-	return FIND_OK;
-}
-
-unsigned int Seq_CopyToBuffer (unsigned int seqNumber, unsigned char buffer[]) {
-	unsigned int seqStart, seqEnd, i;
-	
-	if (Seq_Find(seqNumber) == FIND_OK) {
-		seqStart = activeIndex; seqEnd = SkipToEnd(seqStart);
-		i = 0;
-		while (seqStart < seqEnd) buffer[i++] = EEPROM_ReadChar(seqStart++);
-		return i;
-	}
-	return 0;	
-}	
-
-unsigned int Seq_GetActive (void) {
-	return activeSeq;
-}
-
-BOOL Seq_Next (BOOL repeat) {
-	if (EEPROM_ReadChar(activeIndex+BYTESPERSEQ) != ENDMARK) {
-		activeIndex += BYTESPERSEQ;
-	} else {
-		if (repeat) {
-			// repeat the active sequence
-			Seq_Find(activeSeq);
-		} else {
-			// advance to the next sequence	
-			if (EEPROM_ReadChar(activeIndex+(BYTESPERSEQ+1)) == ENDMARK) return FALSE;
-			activeIndex += BYTESPERSEQ+1; activeSeq++;
-		}		
-	}
-	return TRUE;	
-}
-
-unsigned char Seq_GetPWM (unsigned char ch) {
-	// Gets the PWM level for the active sequence associated with channel 'ch' where ch ranges from 0 to 3.
-	// If no sequence is active, sequence 0 is accessed.
-	return EEPROM_ReadChar(activeIndex+ch+2);
-}
-
-unsigned char Seq_GetHold (void) {
-	// Gets the hold time for the active sequence. If no sequence is active, sequence 0 is accessed.
-	return EEPROM_ReadChar(activeIndex+1);
-}	
-
-unsigned char Seq_GetFade (void) {
-	// Gets the fade rate for the active sequence. If no sequence is active, sequence 0 is accessed.
-	return EEPROM_ReadChar(activeIndex);
-}
-
-static void MoveBlock (unsigned int srcAdd, unsigned int destAdd, unsigned int total) {
-	// Non-overlapping block move
-	unsigned char buffer[64];
-	
-	while (total > sizeof(buffer)) {
-		EEPROM_Read(srcAdd, buffer, sizeof(buffer)); srcAdd += sizeof(buffer);
-		EEPROM_Write(destAdd, buffer, sizeof(buffer)); destAdd += sizeof(buffer);
-		total -= sizeof(buffer);		
-	}
-	if (total > 0) {
-		EEPROM_Read(srcAdd, buffer, total); 
-		EEPROM_Write(destAdd, buffer, total);
-	}	
-}	
-
-static void MoveBytes (unsigned int srcAdd, unsigned int destAdd, unsigned int total) {
-	// Shift a 'total' number of bytes from the srcAdd to the destAdd in EEPROM.  Overlapping
-	// memory areas are handled properly.  Any bytes moved beyond the end of memory are lost.
-	unsigned int overlap = destAdd - srcAdd;
-	if (destAdd > srcAdd && total > overlap) {
-		MoveBlock(destAdd, destAdd+overlap, total - overlap);
-		total = overlap;
-	}	
-	if (total > 0) MoveBlock(srcAdd, destAdd, total);
-}		
-
-BOOL Seq_AddTo (unsigned int seqNumber, unsigned char rgbw[], unsigned char hold, unsigned char fade) {
-	// Adds to the sequence 'seqNumber'.  If the sequence doesn't exist or isn't writeable, a FALSE is returned.
-	unsigned int sadd, eadd, size;
-	unsigned char buffer[8];
-	
-	if (EEPROMPresent) {
-		// set up the sequence contents
-		buffer[0] = fade; buffer[1] = hold;
-		buffer[2] = rgbw[0]; buffer[3] = rgbw[1];
-		buffer[4] = rgbw[2]; buffer[5] = rgbw[3];
-		buffer[6] = ENDMARK; size = BYTESPERSEQ+1;
-		
-		// make room for sequence
-		if (Seq_Find(seqNumber) == FIND_OK) {
-			// make room for new sequence data
-			sadd = SkipToEnd(activeIndex);
-			Seq_Find(EEMAX);									// move to very last sequence
-			if (lastIndex > (EEPROM_GetSize() - 256)) return FALSE;
-			eadd = SkipToEnd(lastIndex);
-			MoveBytes(sadd, sadd+BYTESPERSEQ, eadd-sadd+2);		// make room for new addition
-		} else {
-			// add data to the end of all the sequences
-			sadd = SkipToEnd(lastIndex);
-			if (sadd != 0) sadd++;
-			buffer[7] = ENDMARK; size++;
-		}
-		
-		// write the new sequence addition
-		EEPROM_Write(sadd, buffer, size);
-		return TRUE;
-	}
-	return FALSE;	
-}
-
-BOOL Seq_Delete_Range (unsigned int seqStart, unsigned int seqEnd) {
-	// Deletes the range of sequences from 'seqStart' to 'seqEnd'.  If the sequence doesn't exist or isn't 
-	// writeable, a FALSE is returned.
-	unsigned int startAdd, endAdd, lastAdd;
-	
-	if ((seqEnd >= seqStart) && EEPROMPresent) {
-		if (Seq_Find(seqStart) == FIND_OK) {
-			startAdd = activeIndex;
-			if (Seq_Find(seqEnd) == FIND_OK) {
-				// need to move all following sequences to startAdd
-				endAdd = SkipToEnd(activeIndex);
-				Seq_Find(EEMAX); lastAdd = SkipToEnd(lastIndex);	// go to last address in sequence
-				if (lastAdd > endAdd) {
-					MoveBytes(endAdd+1, startAdd, lastAdd-endAdd+1);
-					return TRUE;
-				}	
-			} 
-			// deleting everything from StartAdd to end
-			// mark end of all sequences at startAdd
-			EEPROM_WriteChar(startAdd, ENDMARK);
-			return TRUE;
-		}		
-	}
-	return FALSE;	
-}
-
-BOOL Seq_DeleteAll (void) {
-	// Just write two markers at the beginning of EEPROM
-	EEPROM_WriteChar(0, ENDMARK);
-	EEPROM_WriteChar(1, ENDMARK);
-	return TRUE;	
-}		
-
-BOOL Seq_New (unsigned char rgbw[], unsigned char hold, unsigned char fade) {
-	// Creates a new sequence in EEPROM.  Sequences stored in EEPROM are numbered from 
-	// EESTART to EEMAX. A TRUE is returned once the new sequence has been created and 
-	// initialized. The created or overwritten sequence becomes active.  Flash sequences
-	// cannot be altered with this function.
-	return Seq_AddTo(EEMAX, rgbw, hold, fade);
-}
-
-unsigned int Seq_Count (void) {
-	// Returns a count of all sequences in EEPROM
-	unsigned int total = 0;
-	
-	if (Seq_Find(EEMAX) != NO_SEQUENCES) total = lastSeq + 1;
-	return total;
-}	
-
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Sequences.c
+* \details  The PWM sequence management is controlled by this module.  Using the
+*			contained routines it is possible to define, delete, and read sequences
+*			which are stored in external EEPROM.  Each sequence consists of of one
+*			or more entries of fade, hold, and PWM settings for four channels. 
+*
+*			Walking the sequences over I2C is slow, so the sequence count, the
+*			start of the last sequence, and the end of the data are cached in
+*			RAM and kept in a small header in the last EEPROM page together with
+*			a generation number and a checksum.  At power-up the header is
+*			checked in one read and the store is only scanned if it is invalid.
+*			The header is invalidated before every change to the store and
+*			written again once the change is complete, so a reset part way
+*			through a change forces a rescan.
+* \author   Michael Griebling
+* \date   	10 Nov 2011
+*/ 
+//************************************************************************************
+
+#include "Sequences.h"
+#include "EEPROM.h" 
+#include "Counters.h"
+
+static unsigned int activeSeq;		// active sequence address
+static unsigned int activeIndex;	// address of sequence in FLASH/EEPROM
+static unsigned int lastSeq;		// last sequence address in FLASH/EEPROM
+static unsigned int lastIndex;		// address of last sequence
+static BOOL EEPROMPresent;			// set to TRUE if EEPROM is present
+static unsigned int seqCount;		// number of sequences in EEPROM
+static unsigned int endIndex;		// address of the final pair of ENDMARKs
+static BOOL cacheValid;				// seqCount, lastSeq, lastIndex, and endIndex are up to date
+static BOOL headerValid;			// the EEPROM header matches the cache
+static unsigned char generation;	// header generation, bumped on every write
+
+#define HEADERADD	(EEPROM_GetSize()-64)	// header at the start of the last EEPROM page
+#define HEADERSIZE	9
+#define HEADERMARK	0xA5
+
+unsigned char MAGIC[] = {0x55, 0xAA};	// special value to check for EEPROM initialization
+
+static unsigned int SkipToEnd (unsigned int add);
+static FindResult Locate (unsigned int seqNumber, unsigned int *index);
+
+static void Scan (void) {
+	// Walk the whole store to rebuild the cache
+	unsigned int add;
+	
+	cacheValid = FALSE;
+	if (Locate(EEMAX, &add) == NO_SEQUENCES) {
+		seqCount = 0; endIndex = 0;
+	} else {
+		seqCount = lastSeq + 1;
+		endIndex = SkipToEnd(lastIndex);
+	}
+	cacheValid = TRUE;
+}
+
+static void WriteHeader (void) {
+	// Save the cache in the EEPROM header as mark, generation, count, last index, end index, checksum
+	unsigned char header[HEADERSIZE];
+	unsigned char i, sum = 0;
+	
+	header[0] = HEADERMARK; header[1] = ++generation;
+	header[2] = seqCount >> 8; header[3] = seqCount & 0xFF;
+	header[4] = lastIndex >> 8; header[5] = lastIndex & 0xFF;
+	header[6] = endIndex >> 8; header[7] = endIndex & 0xFF;
+	for (i=0; i<HEADERSIZE-1; i++) sum += header[i];
+	header[HEADERSIZE-1] = -sum;
+	EEPROM_Write(HEADERADD, header, HEADERSIZE);
+	headerValid = TRUE;
+}
+
+static BOOL ReadHeader (void) {
+	// Load the cache from the EEPROM header.  FALSE is returned if the header can't be trusted.
+	unsigned char header[HEADERSIZE];
+	unsigned char i, sum = 0;
+	
+	EEPROM_Read(HEADERADD, header, HEADERSIZE);
+	for (i=0; i<HEADERSIZE; i++) sum += header[i];
+	if ((header[0] != HEADERMARK) || (sum != 0)) return FALSE;
+	generation = header[1];
+	seqCount = ((unsigned int)header[2] << 8) | header[3];
+	lastIndex = ((unsigned int)header[4] << 8) | header[5];
+	endIndex = ((unsigned int)header[6] << 8) | header[7];
+	if ((seqCount == 0) != (endIndex == 0)) return FALSE;
+	
+	// the end of the data must be where the header says
+	EEPROM_Read(endIndex, header, 2);
+	if ((header[0] != ENDMARK) || (header[1] != ENDMARK)) return FALSE;
+	lastSeq = (seqCount == 0) ? 0 : seqCount - 1;
+	return TRUE;
+}
+
+static void Invalidate (void) {
+	// Called before the store changes so a reset part way through forces a rescan
+	if (headerValid) EEPROM_WriteChar(HEADERADD, 0x00);
+	headerValid = FALSE;
+}
+
+void Seq_Init (void) {
+	// Initializes the sequence buffers, points to the first sequence (0), and verifies that EEPROM is
+	// present and how many sequences are stored there.
+	unsigned char buffer[2];
+	unsigned int lastAdd;
+	
+	EEPROM_Init();
+	activeSeq = 0; activeIndex = 0;
+	EEPROMPresent = FALSE;
+	cacheValid = FALSE; headerValid = FALSE;
+	if (EEPROM_Present()) {
+		// Check if EEPROM needs initialization
+		lastAdd = EEPROM_GetSize() - 2;
+		EEPROMPresent = TRUE;
+		EEPROM_Read(lastAdd, buffer, 2);
+		if ((buffer[0] != MAGIC[0]) || (buffer[1] != MAGIC[1])) {
+			Seq_DeleteAll();					// erase all sequences
+			EEPROM_Write(lastAdd, MAGIC, 2);	// initialize EEPROM
+		} else if (ReadHeader()) {
+			cacheValid = TRUE; headerValid = TRUE;
+		} else {
+			Scan(); WriteHeader();				// header missing or stale
+		}
+	}	
+}
+
+static unsigned int SkipToEnd (unsigned int add) {
+	// Moves to the end of the active sequence
+	unsigned char eechar;
+	
+	eechar = EEPROM_ReadChar(add);
+	while (eechar != ENDMARK) {
+		add += BYTESPERSEQ;
+		eechar = EEPROM_ReadChar(add);
+	}	
+	return add;
+}
+
+static FindResult Locate (unsigned int seqNumber, unsigned int *index) {
+	// Walk the sequences from the start of EEPROM to find the address of 'seqNumber'
+	unsigned int add = 0;
+	unsigned int seq, start;
+	
+	// The last sequence and anything beyond it are known without a walk
+	if (cacheValid) {
+		if (seqCount == 0) return NO_SEQUENCES;
+		if (seqNumber > lastSeq) return AT_LAST_SEQUENCE;
+		if (seqNumber == lastSeq) { *index = lastIndex; return FIND_OK; }
+	}
+	
+	// Check if any sequences are defined
+	if (EEPROM_ReadChar(0) == ENDMARK) {
+		lastIndex = 0; lastSeq = 0; 
+		return NO_SEQUENCES;
+	}	
+	
+	// Look for sequence
+	for (seq=0; seq<seqNumber; seq++) {
+		start = add;
+		add = SkipToEnd(add);
+		
+		if (EEPROM_ReadChar(add+1) == ENDMARK) {
+			// update the last sequence variables -- a level of 255 is not an ENDMARK
+			// so the start is remembered rather than searched for backwards
+			lastSeq = seq; 
+			lastIndex = start;
+			return AT_LAST_SEQUENCE;
+		}
+		add++;	// skip end of sequence marker	
+	}
+	*index = add;
+	return FIND_OK;
+}
+
+FindResult Seq_Find (unsigned int seqNumber) {
+	unsigned int add;
+	FindResult result = Locate(seqNumber, &add);
+	
+	if (result == FIND_OK) {
+		activeSeq = seqNumber;
+		activeIndex = add;
+	}
+	return result;
+}
+
+FindResult Seq_Open (SeqCursor *cursor, unsigned int seqNumber) {
+	// Position the cursor at the first segment of 'seqNumber' without disturbing the active sequence
+	FindResult result = Locate(seqNumber, &cursor->index);
+	
+	cursor->seq = seqNumber;
+	return result;
+}
+
+BOOL Seq_ReadSegment (SeqCursor *cursor, unsigned char segment[]) {
+	// One sequential read fetches the fade, hold, and RGBW bytes of the next segment
+	EEPROM_Read(cursor->index, segment, BYTESPERSEQ);
+	if (segment[0] == ENDMARK) return FALSE;
+	cursor->index += BYTESPERSEQ;
+	COUNT(segmentsRead);
+	return TRUE;
+}
+
+BOOL Seq_NextSequence (SeqCursor *cursor) {
+	// Skip any unread segments and step over the end of sequence marker
+	unsigned char marks[2];
+	
+	EEPROM_Read(cursor->index, marks, 2);
+	if (marks[0] != ENDMARK) {
+		cursor->index = SkipToEnd(cursor->index);
+		marks[1] = EEPROM_ReadChar(cursor->index+1);
+	}
+	if (marks[1] == ENDMARK) return FALSE;	// end of all sequences
+	cursor->index++; cursor->seq++;
+	return TRUE;
+}
+
+unsigned int Seq_CopyToBuffer (unsigned int seqNumber, unsigned char buffer[]) {
+	SeqCursor cursor;
+	unsigned int i = 0;
+	
+	if (Seq_Open(&cursor, seqNumber) == FIND_OK) {
+		while (Seq_ReadSegment(&cursor, &buffer[i])) i += BYTESPERSEQ;
+	}
+	return i;	
+}	
+
+unsigned int Seq_GetActive (void) {
+	return activeSeq;
+}
+
+BOOL Seq_Next (BOOL repeat) {
+	if (EEPROM_ReadChar(activeIndex+BYTESPERSEQ) != ENDMARK) {
+		activeIndex += BYTESPERSEQ;
+	} else {
+		if (repeat) {
+			// repeat the active sequence
+			Seq_Find(activeSeq);
+		} else {
+			// advance to the next sequence	
+			if (EEPROM_ReadChar(activeIndex+(BYTESPERSEQ+1)) == ENDMARK) return FALSE;
+			activeIndex += BYTESPERSEQ+1; activeSeq++;
+		}		
+	}
+	return TRUE;	
+}
+
+unsigned char Seq_GetPWM (unsigned char ch) {
+	// Gets the PWM level for the active sequence associated with channel 'ch' where ch ranges from 0 to 3.
+	// If no sequence is active, sequence 0 is accessed.
+	return EEPROM_ReadChar(activeIndex+ch+2);
+}
+
+unsigned char Seq_GetHold (void) {
+	// Gets the hold time for the active sequence. If no sequence is active, sequence 0 is accessed.
+	return EEPROM_ReadChar(activeIndex+1);
+}	
+
+unsigned char Seq_GetFade (void) {
+	// Gets the fade rate for the active sequence. If no sequence is active, sequence 0 is accessed.
+	return EEPROM_ReadChar(activeIndex);
+}
+
+static void MoveBlock (unsigned int srcAdd, unsigned int destAdd, unsigned int total) {
+	// Non-overlapping block move
+	unsigned char buffer[64];
+	
+	while (total > sizeof(buffer)) {
+		EEPROM_Read(srcAdd, buffer, sizeof(buffer)); srcAdd += sizeof(buffer);
+		EEPROM_Write(destAdd, buffer, sizeof(buffer)); destAdd += sizeof(buffer);
+		total -= sizeof(buffer);		
+	}
+	if (total > 0) {
+		EEPROM_Read(srcAdd, buffer, total); 
+		EEPROM_Write(destAdd, buffer, total);
+	}	
+}	
+
+static void MoveBytes (unsigned int srcAdd, unsigned int destAdd, unsigned int total) {
+	// Shift a 'total' number of bytes from the srcAdd to the destAdd in EEPROM.  Overlapping
+	// memory areas are handled properly.  Any bytes moved beyond the end of memory are lost.
+	unsigned int overlap = destAdd - srcAdd;
+	if (destAdd > srcAdd && total > overlap) {
+		MoveBlock(destAdd, destAdd+overlap, total - overlap);
+		total = overlap;
+	}	
+	if (total > 0) MoveBlock(srcAdd, destAdd, total);
+}		
+
+BOOL Seq_AddTo (unsigned int seqNumber, unsigned char rgbw[], unsigned char hold, unsigned char fade) {
+	// Adds to the sequence 'seqNumber'.  If the sequence doesn't exist or isn't writeable, a FALSE is returned.
+	unsigned int sadd, eadd, size;
+	unsigned char buffer[8];
+	
+	if (EEPROMPresent) {
+		// set up the sequence contents
+		buffer[0] = fade; buffer[1] = hold;
+		buffer[2] = rgbw[0]; buffer[3] = rgbw[1];
+		buffer[4] = rgbw[2]; buffer[5] = rgbw[3];
+		buffer[6] = ENDMARK; size = BYTESPERSEQ+1;
+		if (!cacheValid) Scan();
+		
+		// make room for sequence
+		if (Seq_Find(seqNumber) == FIND_OK) {
+			// make room for new sequence data
+			sadd = SkipToEnd(activeIndex);
+			eadd = endIndex;									// end of the very last sequence
+			if (eadd + BYTESPERSEQ + 2 > Seq_ImageLimit()) return FALSE;
+			Invalidate();
+			MoveBytes(sadd, sadd+BYTESPERSEQ, eadd-sadd+2);		// make room for new addition
+			if (seqNumber < lastSeq) lastIndex += BYTESPERSEQ;
+			endIndex += BYTESPERSEQ;
+		} else {
+			// add data to the end of all the sequences
+			sadd = endIndex;
+			if (sadd != 0) sadd++;
+			buffer[7] = ENDMARK; size++;
+			if (sadd + size > Seq_ImageLimit()) return FALSE;
+			Invalidate();
+			if (seqCount != 0) lastSeq++;
+			lastIndex = sadd;
+			endIndex = sadd + BYTESPERSEQ;
+			seqCount++;
+		}
+		
+		// write the new sequence addition -- the header waits for Seq_Commit
+		EEPROM_Write(sadd, buffer, size);
+		return TRUE;
+	}
+	return FALSE;	
+}
+
+BOOL Seq_Delete_Range (unsigned int seqStart, unsigned int seqEnd) {
+	// Deletes the range of sequences from 'seqStart' to 'seqEnd'.  If the sequence doesn't exist or isn't 
+	// writeable, a FALSE is returned.
+	unsigned int startAdd, endAdd, lastAdd;
+	
+	if ((seqEnd >= seqStart) && EEPROMPresent) {
+		if (Seq_Find(seqStart) == FIND_OK) {
+			startAdd = activeIndex;
+			Invalidate();
+			if (Seq_Find(seqEnd) == FIND_OK) {
+				// need to move all following sequences to startAdd
+				endAdd = SkipToEnd(activeIndex);
+				Seq_Find(EEMAX); lastAdd = SkipToEnd(lastIndex);	// go to last address in sequence
+				if (lastAdd > endAdd) {
+					MoveBytes(endAdd+1, startAdd, lastAdd-endAdd+1);
+					Scan();
+					return TRUE;
+				}	
+			} 
+			// deleting everything from StartAdd to end
+			// mark end of all sequences at startAdd
+			EEPROM_WriteChar(startAdd, ENDMARK);
+			Scan();
+			return TRUE;
+		}		
+	}
+	return FALSE;	
+}
+
+void Seq_Commit (void) {
+	// Save the cache in the header once, after all the changes of a command
+	if (EEPROMPresent && cacheValid && !headerValid) WriteHeader();
+}
+
+BOOL Seq_DeleteAll (void) {
+	// Just write two markers at the beginning of EEPROM
+	Invalidate();
+	EEPROM_WriteChar(0, ENDMARK);
+	EEPROM_WriteChar(1, ENDMARK);
+	seqCount = 0; lastSeq = 0; lastIndex = 0; endIndex = 0;
+	cacheValid = TRUE;
+	WriteHeader();
+	return TRUE;	
+}		
+
+BOOL Seq_New (unsigned char rgbw[], unsigned char hold, unsigned char fade) {
+	// Creates a new sequence in EEPROM.  Sequences stored in EEPROM are numbered from 
+	// EESTART to EEMAX. A TRUE is returned once the new sequence has been created and 
+	// initialized. The created or overwritten sequence becomes active.  Flash sequences
+	// cannot be altered with this function.
+	return Seq_AddTo(EEMAX, rgbw, hold, fade);
+}
+
+BOOL Seq_WriteImage (unsigned int offset, const unsigned char buffer[], unsigned int size) {
+	// Writes part of a raw sequence image straight to EEPROM at 'offset'.  The image has to stay
+	// clear of the last EEPROM page which holds the initialization marker.
+	if (!EEPROMPresent || ((unsigned long)offset + size > Seq_ImageLimit())) return FALSE;
+	Invalidate();
+	cacheValid = FALSE;						// rebuilt by the next Seq_Count
+	if (size > 0) EEPROM_Write(offset, buffer, size);
+	return TRUE;
+}
+
+BOOL Seq_CheckImage (unsigned int size) {
+	// Walk the image as Scan does but stop at its end rather than run off into the rest of EEPROM.
+	// A good image leaves the cache and header rebuilt.
+	unsigned int add = 0, start = 0, count = 0;
+	
+	if (!EEPROMPresent || (size < 2) || (EEPROM_ReadChar(0) == ENDMARK)) return FALSE;
+	while (add + 2 <= size) {
+		if (EEPROM_ReadChar(add) != ENDMARK) {
+			add += BYTESPERSEQ;
+		} else if (EEPROM_ReadChar(add+1) != ENDMARK) {
+			add++;			// skip end of sequence marker
+			start = add; count++;
+		} else {
+			seqCount = count + 1; lastSeq = count; lastIndex = start; endIndex = add;
+			cacheValid = TRUE;
+			WriteHeader();
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+unsigned int Seq_ImageLimit (void) {
+	// Largest raw sequence image that fits in EEPROM
+	return EEPROM_GetSize() - 256;
+}
+
+unsigned int Seq_Count (void) {
+	// Returns a count of all sequences in EEPROM
+	if (!EEPROMPresent) return 0;
+	if (!cacheValid) {
+		Scan(); WriteHeader();
+	}
+	return seqCount;
+}	
+
+unsigned char Seq_Generation (void) {
+	// Returns the header generation which changes whenever the sequence store is written
+	Seq_Count();
+	return generation;
+}
+
@@ -0,0 +1,330 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Timer.c
+* \details  This module owns the one system tick that every other module uses.
+*			Timer4 interrupts several times per 5mS tick since the 8-bit timer
+*			cannot count a whole tick; the periods are counted here so the tick,
+*			and the phase within it, are the same at either clock speed.  The
+*			tick is kept in step with the bus master by \em Timer_Sync.
+*
+*			Modules ask for callbacks through a small hashed timer wheel.  Each
+*			running timer hangs off the wheel slot of the tick it expires on, so
+*			a tick only looks at the few timers in its own slot.  A callback is
+*			made in the interrupt or, for anything that may take a while, from
+*			\em Timer_Run in the main loop.  Periodic timers are re-armed from
+*			their expiry tick, not from when the callback ran, so they never
+*			drift.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Timer.h"
+
+#define	SCALE		16							/*!< Timer 4 prescaler */
+#define	PRCOUNT		TIMER_SUBCOUNTS				/*!< Timer 4 counts per period */
+#define	SUBTICKS	(TIMER_TICKCOUNTS/PRCOUNT)	/*!< periods per tick at the slow clock */
+#define STEPMAX		(0x7FFFL)					/*!< offsets beyond what slew holds (0.57S) are stepped */
+
+#define MAXTIMERS	8							/*!< size of the timer table */
+#define WHEELSIZE	8							/*!< wheel slots, a power of two */
+
+typedef struct _Timer {
+	TimerProc proc;					/*!< callback */
+	unsigned int expiry;			/*!< tick of the next call */
+	unsigned int period;			/*!< ticks between calls or 0 for one call */
+	unsigned char flags;			/*!< TIMER_ISR or TIMER_TASK */
+	unsigned char next;				/*!< next timer in the same slot */
+	BOOL active;					/*!< timer is in use */
+	unsigned char pending;			/*!< TIMER_TASK calls not yet made */
+} Timer;
+
+static Timer timers[MAXTIMERS];
+static unsigned char wheel[WHEELSIZE];	/*!< first timer of each slot */
+
+unsigned long Timer_Ticks;			/*!< free-running tick count disciplined by Timer_Sync */
+volatile unsigned char Timer_SubTick;	/*!< Timer4 periods elapsed in the current tick */
+volatile unsigned char Timer_Shift;	/*!< 0 at the slow clock, 2 on the 4x PLL */
+static int slew;					/*!< phase counts still to absorb (+ve: local clock is behind) */
+static int syncOffset;				/*!< offset found by the last sync in phase counts */
+static BOOL synced;					/*!< a sync has been received */
+
+static void Link (unsigned char t) {
+	unsigned char slot = timers[t].expiry & (WHEELSIZE-1);
+	
+	timers[t].next = wheel[slot];
+	wheel[slot] = t;
+}
+
+static void Unlink (unsigned char t) {
+	unsigned char slot = timers[t].expiry & (WHEELSIZE-1);
+	unsigned char i = wheel[slot];
+	
+	if (i == t) { wheel[slot] = timers[t].next; return; }
+	while (i != NOTIMER) {
+		if (timers[i].next == t) { timers[i].next = timers[t].next; return; }
+		i = timers[i].next;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Walks the wheel slot of the new tick and fires the timers that are
+*			due in it.  A re-armed timer goes to the head of its new slot, which
+*			never disturbs the rest of the walk.
+*/ 
+//********************************************************************************
+static void Expire (void) {
+	unsigned int now = (unsigned int)Timer_Ticks;
+	unsigned char t = wheel[now & (WHEELSIZE-1)];
+	unsigned char next;
+	Timer *timer;
+	
+	while (t != NOTIMER) {
+		timer = &timers[t];
+		next = timer->next;
+		if (timer->expiry == now) {
+			Unlink(t);
+			if (timer->period != 0) {
+				timer->expiry += timer->period;
+				Link(t);
+			} else if (timer->flags & TIMER_ISR) timer->active = FALSE;
+			if (timer->flags & TIMER_ISR) timer->proc();
+			else if (timer->pending < 255) timer->pending++;
+		}
+		t = next;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Timer4 interrupt service.  Only the last period of a tick advances
+*			the tick; it is also lengthened or shortened by one phase count
+*			until any sync offset has been slewed out.
+*/ 
+//********************************************************************************
+void Timer_interrupt (void) {
+    if (++Timer_SubTick < (SUBTICKS << Timer_Shift)) {
+        if (Timer_SubTick == (SUBTICKS << Timer_Shift)-1) {
+            // Slew the last period by one phase count until the sync offset is absorbed
+            if (slew > 0) {
+                PR4 = PRCOUNT-1-(1 << Timer_Shift); slew--;
+            } else if (slew < 0) {
+                PR4 = PRCOUNT-1+(1 << Timer_Shift); slew++;
+            }
+        }
+        return;
+    }
+    Timer_SubTick = 0;
+    PR4 = PRCOUNT-1;
+    Timer_Ticks++;
+    Expire();
+}
+
+//********************************************************************************
+/**
+* \details  Timer4 set-up for the system tick.
+*/ 
+//********************************************************************************
+void Timer_Init (void) {
+	unsigned char i;
+	
+	for (i=0; i<MAXTIMERS; i++) timers[i].active = FALSE;
+	for (i=0; i<WHEELSIZE; i++) wheel[i] = NOTIMER;
+	Timer_Ticks = 0;
+	Timer_SubTick = 0;
+	slew = 0; syncOffset = 0;
+	synced = FALSE;
+	
+	PR4 = PRCOUNT-1;			// tick period
+	TMR4IF = 0;				// Clear Timer4 interrupt flag bit
+	T4CONbits.T4CKPS = 0b11;		// Set up Timer4 prescale to /16
+	TMR4IE = 1;				// Enable Timer4 interrupts
+	PEIE = 1;				// Also enable peripheral interrupts for Timer4 use
+	T4CONbits.TMR4ON = 1;			// Enable Timer4
+	ei();					// Global interrupts enabled
+}
+
+unsigned char Timer_Start (TimerProc proc, unsigned int delay, unsigned int period, unsigned char flags) {
+	unsigned char t;
+	Timer *timer;
+	
+	for (t=0; t<MAXTIMERS; t++) {
+		timer = &timers[t];
+		if (!timer->active) {
+			timer->proc = proc;
+			timer->period = period;
+			timer->flags = flags;
+			timer->pending = 0;
+			timer->active = TRUE;
+			if (delay == 0) delay = 1;
+			TMR4IE = 0;
+			timer->expiry = (unsigned int)Timer_Ticks + delay;
+			Link(t);
+			TMR4IE = 1;
+			return t;
+		}
+	}
+	return NOTIMER;
+}
+
+void Timer_Cancel (unsigned char timer) {
+	if ((timer >= MAXTIMERS) || !timers[timer].active) return;
+	TMR4IE = 0;
+	Unlink(timer);
+	timers[timer].active = FALSE;
+	timers[timer].pending = 0;
+	TMR4IE = 1;
+}
+
+//********************************************************************************
+/**
+* \details  Makes the main loop calls of the timers that have expired.  Calls
+*			that fell due more than once since the last run are all made, so a
+*			periodic count such as the night sense minute never loses a period.
+*/ 
+//********************************************************************************
+void Timer_Run (void) {
+	unsigned char t;
+	Timer *timer;
+	
+	for (t=0; t<MAXTIMERS; t++) {
+		timer = &timers[t];
+		while (timer->pending > 0) {
+			TMR4IE = 0;
+			timer->pending--;
+			if ((timer->pending == 0) && (timer->period == 0)) timer->active = FALSE;
+			TMR4IE = 1;
+			timer->proc();
+		}
+	}
+}
+
+void Timer_Suspend (void) {
+	TMR4IE = 0;				// the tick stops while asleep
+}
+
+void Timer_Resume (void) {
+	TMR4IE = 1;
+}
+
+//********************************************************************************
+/**
+* \details  Returns the free-running tick count.  Ticks occur every 5mS and
+*			are kept in step with the bus master by \em Timer_Sync.
+*/ 
+//********************************************************************************
+unsigned long Timer_GetTicks (void) {
+	unsigned long ticks;
+	
+	TMR4IE = 0;
+	ticks = Timer_Ticks;
+	TMR4IE = 1;
+	return ticks;
+}
+
+//********************************************************************************
+/**
+* \details  Returns a 16-bit time stamp in phase counts (about 17uS each) made
+*			from the tick count and the position within the tick.  The difference
+*			of two stamps measures intervals of up to a second such as task run
+*			times.
+*/ 
+//********************************************************************************
+unsigned int Timer_Stamp (void) {
+	unsigned int ticks;
+	unsigned char sub, count;
+	
+	TMR4IE = 0;
+	ticks = (unsigned int)Timer_Ticks;
+	sub = Timer_SubTick;
+	count = TMR4;
+	if (TMR4IF && count < PRCOUNT/2) {
+		// timer wrapped, period not counted yet
+		if (++sub == (SUBTICKS << Timer_Shift)) { sub = 0; ticks++; }
+	}
+	TMR4IE = 1;
+	return ticks * TIMER_TICKCOUNTS + (((unsigned int)sub * PRCOUNT + count) >> Timer_Shift);
+}
+
+//********************************************************************************
+/**
+* \details  Returns \em TRUE once the tick count has reached \em tick.
+*/ 
+//********************************************************************************
+BOOL Timer_TickReached (unsigned long tick) {
+	return ((Timer_GetTicks() - tick) & 0x80000000UL) == 0;
+}
+
+//********************************************************************************
+/**
+* \details  Changes the number of Timer4 periods per tick for a new system
+*			clock so the tick and the phase counts stay the same.  The position
+*			within the current tick is carried over.  Called with the interrupts
+*			disabled as the clock switches.
+*/ 
+//********************************************************************************
+void Timer_SetClock (BOOL fast) {
+	unsigned int phase = ((unsigned int)Timer_SubTick * PRCOUNT + TMR4) >> Timer_Shift;
+	
+	Timer_Shift = fast ? 2 : 0;
+	phase <<= Timer_Shift;
+	Timer_SubTick = phase / PRCOUNT;
+	TMR4 = phase % PRCOUNT;
+	PR4 = PRCOUNT-1;
+}
+
+//********************************************************************************
+/**
+* \details  Disciplines the local tick against the bus master.  The \em master
+*			tick count was sent in a frame that ended at local tick \em tick plus
+*			\em phase counts.  The first sync or an offset too big for the int
+*			\em slew (0x7FFF counts, about 0.57 seconds) steps the tick count;
+*			smaller offsets are slewed by lengthening or shortening each tick
+*			period by one phase count (about 0.35%) until the offset has been
+*			absorbed, so playback never jumps.  A step moves
+*			the running timers with the tick so they keep their delays.
+*/ 
+//********************************************************************************
+void Timer_Sync (unsigned long master, unsigned long tick, unsigned int phase) {
+	long offset = (long)(master - tick) * TIMER_TICKCOUNTS - phase;
+	unsigned int step;
+	unsigned char t;
+	
+	TMR4IE = 0;
+	if (!synced || (offset > STEPMAX) || (offset < -STEPMAX)) {
+		step = (unsigned int)(master - tick);
+		for (t=0; t<MAXTIMERS; t++) {
+			if (timers[t].active && (timers[t].pending == 0 || timers[t].period != 0)) {
+				Unlink(t); timers[t].expiry += step; Link(t);
+			}
+		}
+		Timer_Ticks += master - tick;		// jump to the master time
+		slew = -(int)phase;					// and slew out the fraction
+		synced = TRUE;
+	} else {
+		slew = (int)offset;
+	}
+	TMR4IE = 1;
+	if (offset > 0x7FFF) syncOffset = 0x7FFF;
+	else if (offset < -0x7FFF) syncOffset = -0x7FFF;
+	else syncOffset = (int)offset;
+}
+
+//********************************************************************************
+/**
+* \details  Reports the offset found by the last sync and the part of it that
+*			still has to be slewed out, both in phase counts of 1/(200*288)
+*			seconds.
+*/ 
+//********************************************************************************
+void Timer_GetSync (int *offset, int *remaining) {
+	*offset = syncOffset;
+	TMR4IE = 0;
+	*remaining = slew;
+	TMR4IE = 1;
+}
@@ -0,0 +1,65 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "system.h"
+
+#define TIMER_HZ		200			// system ticks per second - 5mS
+#define TIMER_SUBCOUNTS	72			// Timer4 counts in each of the periods that make up a tick
+#define TIMER_TICKCOUNTS	288			// phase counts per tick (about 17uS each)
+
+#define TIMER_TASK		0x00		// callback runs from Timer_Run in the main loop
+#define TIMER_ISR		0x01		// callback runs in the tick interrupt
+#define NOTIMER			0xFF		// no timer available
+
+typedef void (*TimerProc)(void);
+
+extern unsigned long Timer_Ticks;			// free-running tick count (interrupt)
+extern volatile unsigned char Timer_SubTick;	// Timer4 periods elapsed in the current tick (interrupt)
+extern volatile unsigned char Timer_Shift;	// 0 at the slow clock, 2 on the 4x PLL
+
+#define Timer_Phase()	((((unsigned int)Timer_SubTick * TIMER_SUBCOUNTS) + TMR4) >> Timer_Shift)
+// Position within the current tick in phase counts.  Use in the interrupt or with it disabled.
+
+extern void Timer_Init (void);
+// Starts the system tick on Timer4 with no timers running.
+
+extern void Timer_interrupt (void);
+// Timer4 interrupt service.
+
+extern unsigned char Timer_Start (TimerProc proc, unsigned int delay, unsigned int period, unsigned char flags);
+// Calls 'proc' once 'delay' ticks from now and then every 'period' ticks, or only once if 'period'
+// is zero.  'flags' selects the interrupt (TIMER_ISR) or the main loop (TIMER_TASK) for the call.
+// The timer identifier is returned or NOTIMER if the table is full.
+
+extern void Timer_Cancel (unsigned char timer);
+// Stops the 'timer' and frees it.
+
+extern void Timer_Run (void);
+// Makes the TIMER_TASK calls that have fallen due.  Scheduled as a task.
+
+extern void Timer_Suspend (void);
+extern void Timer_Resume (void);
+// Stops and restarts the tick around a sleep.
+
+extern unsigned long Timer_GetTicks (void);
+// Returns the free-running tick count.
+
+extern unsigned int Timer_Stamp (void);
+// Returns a time stamp in phase counts for measuring short intervals.
+
+extern BOOL Timer_TickReached (unsigned long tick);
+// Returns TRUE once the tick count has reached 'tick'.
+
+extern void Timer_SetClock (BOOL fast);
+// Rescales Timer4 for the slow or the 4x PLL clock.  Interrupts must be disabled.
+
+extern void Timer_Sync (unsigned long master, unsigned long tick, unsigned int phase);
+// Disciplines the tick count against the 'master' tick count received in a frame that
+// ended at local 'tick' plus 'phase' phase counts.  Offsets over 0x7FFF phase counts
+// (about 0.57 seconds) are stepped, smaller ones are slewed out over the following ticks.
+
+extern void Timer_GetSync (int *offset, int *remaining);
+// Returns the offset found by the last sync and the part still being slewed out in
+// phase counts (about 17uS each).
+
+#endif
@@ -0,0 +1,114 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	Trace.c
+* \details  This module records what the PWM outputs actually did so that the
+*			fade and hold times of a show can be checked against its sequence
+*			data.  PWM.c passes the four levels to \em Trace_Record each time it
+*			writes the duty cycle registers and a change is kept in a ring
+*			buffer with the tick it happened on.  SBUS sends the buffer as a
+*			STATS page; reading it with the clear flag set drains it, so a host
+*			that polls often enough sees every change.  host/tracecheck compares
+*			the entries with the timeline the sequence data should give.
+*
+*			The trace is only built in when TRACE is defined in Trace.h;
+*			otherwise the TRACE_PWM marks in PWM.c expand to nothing and the
+*			STATS page reports an error.  The stamps are the low word of the
+*			tick count, which wraps after about five and a half minutes, longer
+*			than any single fade.
+*/ 
+//************************************************************************************
+
+#include "Types.h"
+#include "Trace.h"
+#include "Timer.h"
+
+#ifdef TRACE
+
+static TraceEntry entries[TRACE_ENTRIES];
+static unsigned char first;			/*!< oldest entry */
+static unsigned char count;			/*!< entries held */
+static unsigned char opened;		/*!< entries reported by the last Trace_Open */
+static unsigned int lost;			/*!< changes not recorded since the last clear */
+static unsigned char last[4];		/*!< levels of the last change */
+static BOOL held;					/*!< the trace is being read */
+
+//********************************************************************************
+/**
+* \details  Records a change of the outputs.  The tick interrupt is held off
+*			while the entry is added, since the levels are also set from the
+*			main loop, and left as it was found because PWM_Suspend calls this
+*			with the tick suspended.
+*/ 
+//********************************************************************************
+void Trace_Record (unsigned char ch1, unsigned char ch2, unsigned char ch3, unsigned char ch4) {
+	unsigned char ie = TMR4IE;
+	TraceEntry *entry;
+
+	TMR4IE = 0;
+	if ((ch1 != last[0]) || (ch2 != last[1]) || (ch3 != last[2]) || (ch4 != last[3])) {
+		last[0] = ch1; last[1] = ch2; last[2] = ch3; last[3] = ch4;
+		if (held) {
+			if (lost < 0xFFFF) lost++;
+		} else {
+			if (count == TRACE_ENTRIES) {
+				// overwrite the oldest
+				if (++first == TRACE_ENTRIES) first = 0;
+				count--;
+				if (opened > 0) opened--;
+				if (lost < 0xFFFF) lost++;
+			}
+			entry = &entries[(first + count) % TRACE_ENTRIES];
+			entry->tick = (unsigned int)Timer_Ticks;
+			entry->level[0] = ch1; entry->level[1] = ch2;
+			entry->level[2] = ch3; entry->level[3] = ch4;
+			count++;
+		}
+	}
+	TMR4IE = ie;
+}
+
+#endif
+
+BOOL Trace_Open (unsigned char *size, unsigned int *dropped) {
+#ifdef TRACE
+	TMR4IE = 0;
+	held = TRUE;
+	opened = count;
+	*size = count;
+	*dropped = lost;
+	TMR4IE = 1;
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void Trace_Get (unsigned char index, TraceEntry *entry) {
+#ifdef TRACE
+	*entry = entries[(first + index) % TRACE_ENTRIES];
+#endif
+}
+
+void Trace_Close (void) {
+#ifdef TRACE
+	TMR4IE = 0;
+	held = FALSE;
+	TMR4IE = 1;
+#endif
+}
+
+void Trace_Clear (void) {
+#ifdef TRACE
+	TMR4IE = 0;
+	first = (first + opened) % TRACE_ENTRIES;
+	count -= opened;
+	opened = 0;
+	lost = 0;
+	TMR4IE = 1;
+#endif
+}
@@ -0,0 +1,45 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include "system.h"
+
+//#define TRACE			/* define this variable to record the PWM outputs for timing checks */
+
+#define TRACE_ENTRIES	(32)		// changes the ring buffer holds
+
+typedef struct _TraceEntry {
+	unsigned int tick;				// low word of Timer_Ticks when the outputs changed
+	unsigned char level[4];			// CH1 to CH4 levels from then on
+} TraceEntry;
+
+#ifdef TRACE
+
+// Records the output levels after each change of the PWM registers
+#define TRACE_PWM(ch1, ch2, ch3, ch4)	Trace_Record(ch1, ch2, ch3, ch4)
+
+extern void Trace_Record (unsigned char ch1, unsigned char ch2, unsigned char ch3, unsigned char ch4);
+// Adds an entry unless the levels are the same as last time.  The oldest entry is overwritten
+// once the buffer is full.  May be called in the tick interrupt or with it enabled.
+
+#else
+
+#define TRACE_PWM(ch1, ch2, ch3, ch4)
+
+#endif
+
+extern BOOL Trace_Open (unsigned char *size, unsigned int *dropped);
+// Holds the trace while it is read and returns the number of entries and the number of changes
+// lost since the last clear because the buffer was full or held.  Returns FALSE if the trace
+// was not built in.
+
+extern void Trace_Get (unsigned char index, TraceEntry *entry);
+// Copies entry 'index' of the held trace, oldest first.
+
+extern void Trace_Close (void);
+// Lets the trace record again.
+
+extern void Trace_Clear (void);
+// Drops the entries reported by the last Trace_Open, and the lost count, so that polling with
+// a clear reads every change once.
+
+#endif
@@ -0,0 +1,22 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	GenericTypeDefs.h
+* \details  Host stand-in for the Microchip generic type definitions; only the
+*			types the firmware uses are defined.
+*/ 
+//************************************************************************************
+#ifndef _GENERIC_TYPE_DEFS_H_
+#define _GENERIC_TYPE_DEFS_H_
+
+typedef enum _BOOL { FALSE = 0, TRUE } BOOL;
+
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+
+#endif
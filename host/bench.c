@@ -0,0 +1,248 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	bench.c
+* \details  Benchmarks the sequence store on the simulator.  Synthetic shows
+*			of 1 to 1000 sequences are loaded straight into the 24LC256 model
+*			and each store operation is then run on its own, starting from the
+*			same show, with the firmware held on the PLL as the SBUS task does.
+*			One CSV line is written per show and operation:
+*
+*			  sequences,segments,bytes,operation,i2c_transactions,i2c_bytes,
+*			  write_cycles,bytes_written,us,tx_bytes,host_stack
+*
+*			\em i2c_transactions counts stop conditions and \em i2c_bytes the
+*			bytes both ways; \em us is simulated time.  \em host_stack is the
+*			deepest stack the operation used on the host, which only compares
+*			operations with each other: the PIC18 has a hardware return stack
+*			and XC8 places locals statically, so the firmware's RAM is given
+*			by the compiler's memory summary instead.
+*
+*			  sbus-bench [-s seed] > bench.csv
+*/
+//************************************************************************************
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+#include "RS485.h"
+#include "SBUS.h"
+#include "Power.h"
+
+#define PAINTSIZE	(256*1024)
+#define PAINT		(0xA5)
+
+typedef enum _Fill { SHORT, FULL } Fill;
+
+extern void ConfigureOscillator (void);
+extern void InitApp (void);
+
+static unsigned char image[EE24_BYTES];
+static unsigned int imageSize, segments;
+static unsigned long txBytes;
+static unsigned long seed = 1;
+static volatile uintptr_t stackLow;			/*!< lowest address painted */
+
+static unsigned int Random (unsigned int range) {
+	seed = seed * 1103515245UL + 12345UL;
+	return (unsigned int)((seed >> 16) % range);
+}
+
+static void Tx (unsigned char byte, HostTime now) {
+	(void)byte; (void)now;
+	txBytes++;
+}
+
+//********************************************************************************
+/**
+* \details  Builds a show of \em count sequences.  SHORT shows have 1 to 4
+*			segments per sequence; FULL shows spread segments over the whole
+*			image limit.
+*/
+//********************************************************************************
+static void MakeShow (unsigned int count, Fill fill) {
+	unsigned int limit = Seq_ImageLimit() - 1;
+	unsigned int average = (fill == SHORT) ? 2 : ((limit - count) / count) / BYTESPERSEQ;
+	unsigned int s, n, i, size = 0;
+
+	if (average == 0) average = 1;
+	segments = 0;
+	for (s=0; s<count; s++) {
+		n = 1 + Random(2*average - 1);
+		while ((n > 1) && (size + n*BYTESPERSEQ + 1 + (count - s - 1)*(BYTESPERSEQ+1) > limit)) n--;
+		for (i=0; i<n; i++) {
+			image[size++] = Random(ENDMARK);			// fade
+			image[size++] = Random(256);				// hold
+			image[size++] = Random(256);
+			image[size++] = Random(256);
+			image[size++] = Random(256);
+			image[size++] = Random(256);
+		}
+		image[size++] = ENDMARK;
+		segments += n;
+	}
+	image[size++] = ENDMARK;
+	imageSize = size;
+}
+
+//********************************************************************************
+/**
+* \details  Puts the show into the part as a programmer would and lets the
+*			firmware find it the way it does after a reset.
+*/
+//********************************************************************************
+static void LoadShow (void) {
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	memcpy(EE24_Memory, image, imageSize);
+	EE24_Memory[EE24_BYTES-2] = 0x55;				// MAGIC
+	EE24_Memory[EE24_BYTES-1] = 0xAA;
+	Seq_Init();
+	Seq_Count();
+}
+
+// Fills the stack below the caller so the operation's deepest use can be found
+static void __attribute__((noinline)) PaintStack (void) {
+	volatile unsigned char area[PAINTSIZE];
+	unsigned long i;
+
+	for (i=0; i<PAINTSIZE; i++) area[i] = PAINT;
+	stackLow = (uintptr_t)area;
+}
+
+static unsigned long StackUsed (void) {
+	const unsigned char *low = (const unsigned char *)stackLow;
+	const unsigned char *p = low;
+
+	while ((p < low + PAINTSIZE) && (*p == PAINT)) p++;
+	return (unsigned long)(low + PAINTSIZE - p);
+}
+
+// Queues a whole SBUS frame as if the UART had received it
+static void Frame (const char *text) {
+	size_t i, n = strlen(text);
+
+	for (i=0; i<n; i++) RS485_RxBuf[RS485_WtPtr++] = text[i];
+	RS485_LineIn();
+}
+
+static void Hex (char *out, const unsigned char *data, unsigned int size) {
+	static const char digits[] = "0123456789ABCDEF";
+
+	while (size-- > 0) {
+		*out++ = digits[*data >> 4];
+		*out++ = digits[*data & 0x0F];
+		data++;
+	}
+	*out = '\0';
+}
+
+typedef enum _Operation {
+	FIND_FIRST, FIND_MIDDLE, FIND_LAST, COUNT, COPY_MIDDLE, ADDTO_MIDDLE, ADDTO_LAST,
+	NEW, DELETE_FIRST, DELETE_MIDDLE, WRITESEGS_MIDDLE, READSEGS_MIDDLE, OPERATIONS
+} Operation;
+
+static const char *names[OPERATIONS] = {
+	"Seq_Find first", "Seq_Find middle", "Seq_Find last", "Seq_Count", "Seq_CopyToBuffer middle",
+	"Seq_AddTo middle", "Seq_AddTo last", "Seq_New", "Seq_Delete_Range first", "Seq_Delete_Range middle",
+	"WRITESEGS middle 4 segments", "READSEGS middle"
+};
+
+static void Run (Operation op, unsigned int count) {
+	static unsigned char buffer[EE24_BYTES];
+	static const unsigned char rgbw[4] = { 10, 20, 30, 40 };
+	unsigned char segment[4*BYTESPERSEQ];
+	char frame[80];
+	unsigned int middle = count / 2, i;
+
+	switch (op) {
+	case FIND_FIRST:	Seq_Find(0); break;
+	case FIND_MIDDLE:	Seq_Find(middle); break;
+	case FIND_LAST:		Seq_Find(count - 1); break;
+	case COUNT:			Seq_Count(); break;
+	case COPY_MIDDLE:	Seq_CopyToBuffer(middle, buffer); break;
+	case ADDTO_MIDDLE:	Seq_AddTo(middle, (unsigned char *)rgbw, 5, 5); Seq_Commit(); break;
+	case ADDTO_LAST:	Seq_AddTo(count - 1, (unsigned char *)rgbw, 5, 5); Seq_Commit(); break;
+	case NEW:			Seq_New((unsigned char *)rgbw, 5, 5); Seq_Commit(); break;
+	case DELETE_FIRST:	Seq_Delete_Range(0, 0); Seq_Commit(); break;
+	case DELETE_MIDDLE:	Seq_Delete_Range(middle, middle); Seq_Commit(); break;
+	case WRITESEGS_MIDDLE:
+		for (i=0; i<sizeof(segment); i++) segment[i] = (i % BYTESPERSEQ == 0) ? 5 : i;
+		sprintf(frame, ":FF20%04X", middle);
+		Hex(frame + strlen(frame), segment, sizeof(segment));
+		strcat(frame, "00\r\n");
+		Frame(frame);
+		SBUS_Process_Command();
+		break;
+	case READSEGS_MIDDLE:
+		sprintf(frame, ":FF10%04X0001\r\n", middle);
+		Frame(frame);
+		SBUS_Process_Command();
+		break;
+	default:
+		break;
+	}
+}
+
+static void Measure (Operation op, unsigned int count) {
+	HostTime start;
+	EE24Counts used;
+	unsigned long stack;
+
+	LoadShow();
+	EE24_ClearCounts();
+	txBytes = 0;
+	start = Host_Now();
+	PaintStack();
+	Run(op, count);
+	stack = StackUsed();
+	used = EE24_Counts;
+	printf("%u,%u,%u,%s,%lu,%lu,%lu,%lu,%.0f,%lu,%lu\n", count, segments, imageSize, names[op],
+		   used.stops, used.bytesIn + used.bytesOut, used.writeCycles, used.bytesWritten,
+		   (double)(Host_Now() - start) * 1e6 / HOST_UNITHZ, txBytes, stack);
+}
+
+static void Finish (void) {
+	fflush(stdout);
+}
+
+int main (int argc, char *argv[]) {
+	static const unsigned int counts[] = { 1, 10, 50, 100, 250, 500, 1000 };
+	HostBoard board = { EE24_Bus, NULL, Tx, NULL, NULL, NULL };
+	unsigned int c;
+	Fill fill;
+	Operation op;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:")) != -1) {
+		if (opt == 's') seed = strtoul(optarg, NULL, 0);
+		else {
+			fprintf(stderr, "usage: sbus-bench [-s seed]\n");
+			return 2;
+		}
+	}
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	Host_OnFinish = Finish;
+	Host_Init(&board, 1e6);
+	ConfigureOscillator();
+	InitApp();
+	Power_Boost();						// as the SBUS task does while it works
+
+	printf("sequences,segments,bytes,operation,i2c_transactions,i2c_bytes,write_cycles,bytes_written,us,tx_bytes,host_stack\n");
+	for (fill=SHORT; fill<=FULL; fill++) {
+		for (c=0; c<sizeof(counts)/sizeof(counts[0]); c++) {
+			MakeShow(counts[c], fill);
+			for (op=0; op<OPERATIONS; op++) Measure(op, counts[c]);
+		}
+	}
+	Power_Release();
+	return 0;
+}
@@ -0,0 +1,491 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	bussim.c
+* \details  RS-485 bus of several fixtures on the simulator.  Each node runs
+*			the firmware in a process of its own, since the firmware keeps its
+*			state in globals, with the shipped Sequences.inc in its 24LC256 and
+*			its own device address, 1 to N.  This process is the master and
+*			talks to the nodes through the SBUS library, so what is measured is
+*			what a master using the library would see.
+*
+*			The nodes run in step, one character time (1.04mS) of virtual
+*			time at a go.  A character a node starts to send is on the line
+*			for a character time, so the others take it in during the next
+*			step with its true timing.  The line is half duplex and has no
+*			arbitration: a character that starts while another driver's is on
+*			the line is a collision.  It is counted and the later character
+*			reaches the receivers as the wired-AND of the two; the earlier one
+*			has already gone out intact.  The driver enable of each node is not
+*			modelled, so the 5mS a node holds the line after its reply only
+*			shows through the library's turnaround.
+*
+*			  sbus-bus [-n nodes,...] [-r rounds] [-k chunk] [-g gap] > bus.csv
+*
+*			For every node count (default 1,2,4,8,16,32) the nodes boot and
+*			the master then polls each node \em -r times (default 5) with a
+*			one-item REPORT, uploads the sequence image to node 1 and to all
+*			nodes at once with a quiet broadcast, and finally asks every node
+*			at once with a broadcast REPORT.  One CSV line is written per node
+*			count:
+*
+*			  nodes,latency_ms,latency_max_ms,poll_cycle_ms,upload_s,
+*			  upload_bytes_per_s,broadcast_upload_s,broadcast_repeats,
+*			  collisions,broadcast_collisions
+*
+*			\em latency is from the start of a frame to the end of its reply as
+*			the master reads it, to within one character time, and \em
+*			poll_cycle the time to poll every node once with the turnaround.
+*			\em upload_s is one node in chunks of \em -k bytes (default 128),
+*			so N nodes take N times as long one by one.  \em broadcast_upload
+*			sends every chunk once to FE, \em -g mS apart (default 0), then
+*			asks each node where it got to with an empty chunk and uploads
+*			again to the \em broadcast_repeats nodes that missed a chunk.  \em
+*			collisions is for all of this and should be 0; \em
+*			broadcast_collisions is for the last REPORT alone, which every
+*			node answers at the same time.
+*/
+//************************************************************************************
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+#include "MemoryMap.h"
+#include "Journal.h"
+#include "sbuslib.h"
+
+#define MAXNODES	(32)
+#define MAXCHARS	(4096)					/*!< characters held for a node between steps */
+#define CHARTIME	(10*(HOST_UNITHZ/9600))	/*!< units a character is on the line */
+#define STARTUP		(9.0)					/*!< seconds for the version flashes */
+#define RECENT		(64)					/*!< characters kept to find collisions */
+#define MASTER		(0)
+
+typedef struct _LineChar {
+	HostTime start;
+	unsigned char byte;
+	unsigned char from;						/*!< MASTER or the node */
+} LineChar;
+
+typedef struct _Window {
+	HostTime until;
+	unsigned int count;						/*!< characters that follow */
+} Window;
+
+typedef struct _Queue {
+	LineChar chars[MAXCHARS];
+	unsigned int head, tail;
+} Queue;
+
+extern const unsigned char Sequences[];
+
+static int nodes;
+static int link_[MAXNODES+1];				/*!< socket to each node, or to the bus in a node */
+static pid_t pids[MAXNODES+1];
+static HostTime busNow;						/*!< every node has run up to here */
+static HostTime masterFree;					/*!< the master's transmitter is busy until */
+static Queue masterTx;						/*!< the master's characters not yet on the line */
+static Queue masterRx;						/*!< characters the master has received */
+static LineChar heard[MAXNODES*MAXCHARS/8];	/*!< node characters of the last step */
+static unsigned int heardCount;
+static LineChar recent[RECENT];				/*!< characters last on the line */
+static unsigned int recentNext;
+static unsigned long collisions;
+
+static Queue nodeRx;						/*!< in a node: characters to receive */
+static LineChar nodeTx[MAXCHARS];			/*!< in a node: characters sent this step */
+static unsigned int nodeTxCount;
+
+static void Fail (const char *what) {
+	fprintf(stderr, "sbus-bus: %s\n", what);
+	exit(1);
+}
+
+static int Put (Queue *q, LineChar c) {
+	if (q->tail - q->head == MAXCHARS) return 0;
+	q->chars[q->tail++ % MAXCHARS] = c;
+	return 1;
+}
+
+static int Empty (const Queue *q) {
+	return q->head == q->tail;
+}
+
+static LineChar *First (Queue *q) {
+	return &q->chars[q->head % MAXCHARS];
+}
+
+static void Send (int fd, const void *data, size_t size) {
+	const char *p = data;
+	ssize_t n;
+
+	while (size > 0) {
+		if ((n = write(fd, p, size)) < 0) {
+			if (errno == EINTR) continue;
+			Fail("lost a node");
+		}
+		p += n; size -= n;
+	}
+}
+
+// Reads a whole message; returns 0 at the end of the stream
+static int Receive (int fd, void *data, size_t size) {
+	char *p = data;
+	ssize_t n;
+
+	while (size > 0) {
+		if ((n = read(fd, p, size)) < 0) {
+			if (errno == EINTR) continue;
+			return 0;
+		}
+		if (n == 0) return 0;
+		p += n; size -= n;
+	}
+	return 1;
+}
+
+static long ImageSize (const unsigned char *image) {
+	long i;
+
+	for (i=0; image[i] != ENDMARK; i++) {
+		while (image[i] != ENDMARK) i += BYTESPERSEQ;
+	}
+	return i + 1;
+}
+
+//****************************************************************************
+// Node side
+//****************************************************************************
+
+static void NodeLine (unsigned char byte, HostTime start, HostTime end) {
+	LineChar c;
+
+	(void)end;
+	c.start = start; c.byte = byte; c.from = 0;
+	if (nodeTxCount < MAXCHARS) nodeTx[nodeTxCount++] = c;
+}
+
+static int NodeRx (unsigned char *byte, HostTime *start) {
+	if (Empty(&nodeRx)) return 0;
+	*byte = First(&nodeRx)->byte;
+	*start = First(&nodeRx)->start;
+	nodeRx.head++;
+	return 1;
+}
+
+//********************************************************************************
+/**
+* \details  At the end of each step the node reports what it started to send
+*			and takes the next step with the characters to receive in it.
+*/
+//********************************************************************************
+static HostTime NodeSync (HostTime now) {
+	LineChar c;
+	Window w;
+
+	(void)now;
+	Send(link_[0], &nodeTxCount, sizeof(nodeTxCount));
+	Send(link_[0], nodeTx, nodeTxCount * sizeof(LineChar));
+	nodeTxCount = 0;
+	if (!Receive(link_[0], &w, sizeof(w))) _exit(0);		// the master has finished
+	while (w.count-- > 0) {
+		if (!Receive(link_[0], &c, sizeof(c))) _exit(0);
+		Put(&nodeRx, c);
+	}
+	return w.until;
+}
+
+static unsigned char Night (HostTime now) {
+	(void)now;
+	return 1;
+}
+
+//********************************************************************************
+/**
+* \details  Gives the node its address with a DEVICEADD record in the journal
+*			of its data EEPROM, newer than all the others, in a slot that holds
+*			no parameter's newest record, as \em WriteWord would.
+*/
+//********************************************************************************
+static void SetAddress (unsigned char address) {
+	unsigned char newest[JOURNALKEYS], seq[JOURNALKEYS], *r, next = 0;
+	int live[JOURNALSLOTS], key, slot, found = 0;
+
+	memset(live, 0, sizeof(live));
+	memset(newest, 0xFF, sizeof(newest));
+	for (slot=0; slot<JOURNALSLOTS; slot++) {
+		r = &Host_EEPROM[slot*RECORDSIZE];
+		if ((r[0] >= JOURNALKEYS) || (r[4] != JOURNALCHECK(r[0], r[1], r[2], r[3]))) continue;
+		if ((newest[r[0]] == 0xFF) || ((signed char)(r[1] - seq[r[0]]) > 0)) {
+			newest[r[0]] = slot;
+			seq[r[0]] = r[1];
+		}
+		if (!found || ((signed char)(r[1] - next) >= 0)) next = r[1] + 1;
+		found = 1;
+	}
+	for (key=0; key<JOURNALKEYS; key++) if (newest[key] != 0xFF) live[newest[key]] = 1;
+	for (slot=0; (slot < JOURNALSLOTS) && live[slot]; slot++) ;
+	r = &Host_EEPROM[slot*RECORDSIZE];
+	r[0] = DEVICEADD; r[1] = next; r[2] = 0; r[3] = address;
+	r[4] = JOURNALCHECK(r[0], r[1], r[2], r[3]);
+}
+
+static void Node (int node) {
+	static HostBoard board = { EE24_Bus, NULL, NULL, NodeRx, NULL, Night, NodeLine, NodeSync };
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	memcpy(EE24_Memory, Sequences, ImageSize(Sequences));
+	EE24_Memory[EE24_BYTES-2] = 0x55;				// MAGIC
+	EE24_Memory[EE24_BYTES-1] = 0xAA;
+	Host_Init(&board, 1e9);
+	SetAddress(node);
+	Firmware_main();
+	_exit(0);
+}
+
+//****************************************************************************
+// Bus and master side
+//****************************************************************************
+
+//********************************************************************************
+/**
+* \details  Puts a character on the line.  One that overlaps a character of
+*			another driver is a collision and is received as the wired-AND.
+*/
+//********************************************************************************
+static void OnLine (LineChar *c) {
+	unsigned int i;
+	LineChar *r;
+	int hit = 0;
+
+	for (i=0; i<RECENT; i++) {
+		r = &recent[i];
+		if ((r->start == 0) || (r->from == c->from)) continue;
+		if ((r->start < c->start + CHARTIME) && (c->start < r->start + CHARTIME)) {
+			c->byte &= r->byte;
+			hit = 1;
+		}
+	}
+	if (hit) collisions++;
+	recent[recentNext++ % RECENT] = *c;
+}
+
+//********************************************************************************
+/**
+* \details  Runs every node for one character time, or up to \em until.  Each
+*			node receives what the others started to send in the last step and
+*			what the master starts to send in this one.
+*/
+//********************************************************************************
+static void Step (HostTime until) {
+	static LineChar out[MAXNODES*MAXCHARS/8 + MAXCHARS];
+	HostTime end = (until - busNow > CHARTIME) ? busNow + CHARTIME : until;
+	unsigned int count = 0, i, n;
+	LineChar c;
+	Window w;
+	int node;
+
+	for (i=0; i<heardCount; i++) out[count++] = heard[i];
+	while (!Empty(&masterTx) && (First(&masterTx)->start < end)) {
+		c = *First(&masterTx);
+		masterTx.head++;
+		OnLine(&c);
+		out[count++] = c;
+	}
+	for (node=1; node<=nodes; node++) {
+		for (i=0, n=0; i<count; i++) n += (out[i].from != node);
+		w.until = end; w.count = n;
+		Send(link_[node], &w, sizeof(w));
+		for (i=0; i<count; i++) if (out[i].from != node) Send(link_[node], &out[i], sizeof(LineChar));
+	}
+	heardCount = 0;
+	for (node=1; node<=nodes; node++) {
+		if (!Receive(link_[node], &n, sizeof(n))) Fail("a node stopped");
+		for (i=0; i<n; i++) {
+			if (!Receive(link_[node], &c, sizeof(c))) Fail("a node stopped");
+			c.from = node;
+			OnLine(&c);
+			if (heardCount < sizeof(heard)/sizeof(heard[0])) heard[heardCount++] = c;
+			c.start += CHARTIME;						// the master has it once it is complete
+			Put(&masterRx, c);
+		}
+	}
+	busNow = end;
+}
+
+static int MasterWrite (SbusPort *port, const unsigned char *data, size_t size) {
+	LineChar c;
+
+	(void)port;
+	while (size-- > 0) {
+		c.start = (masterFree > busNow) ? masterFree : busNow;
+		c.byte = *data++;
+		c.from = MASTER;
+		masterFree = c.start + CHARTIME;
+		if (!Put(&masterTx, c)) return 0;
+	}
+	return 1;
+}
+
+static int MasterRead (SbusPort *port, unsigned char *byte, unsigned int ms) {
+	HostTime deadline = busNow + (HostTime)ms * (HOST_UNITHZ/1000);
+
+	(void)port;
+	for (;;) {
+		if (!Empty(&masterRx) && (First(&masterRx)->start <= busNow)) {
+			*byte = First(&masterRx)->byte;
+			masterRx.head++;
+			return 1;
+		}
+		if (busNow >= deadline) return 0;
+		Step(deadline);
+	}
+}
+
+static double MasterClock (SbusPort *port) {
+	(void)port;
+	return (double)busNow / HOST_UNITHZ;
+}
+
+static void Start (int count) {
+	int sv[2], node, other;
+
+	fflush(stdout);
+	nodes = count;
+	busNow = masterFree = 0;
+	masterTx.head = masterTx.tail = masterRx.head = masterRx.tail = 0;
+	heardCount = 0;
+	memset(recent, 0, sizeof(recent));
+	collisions = 0;
+	for (node=1; node<=nodes; node++) {
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) Fail("no socket");
+		if ((pids[node] = fork()) < 0) Fail("no process");
+		if (pids[node] == 0) {
+			for (other=1; other<node; other++) close(link_[other]);
+			close(sv[0]);
+			link_[0] = sv[1];
+			Node(node);
+		}
+		close(sv[1]);
+		link_[node] = sv[0];
+	}
+	// every node reports once at its first instruction
+	for (node=1; node<=nodes; node++) {
+		unsigned int n;
+		if (!Receive(link_[node], &n, sizeof(n)) || (n != 0)) Fail("a node did not start");
+	}
+}
+
+static void Stop (void) {
+	int node;
+
+	for (node=1; node<=nodes; node++) close(link_[node]);
+	for (node=1; node<=nodes; node++) waitpid(pids[node], NULL, 0);
+}
+
+static void Usage (void) {
+	fprintf(stderr, "usage: sbus-bus [-n nodes,...] [-r rounds] [-k chunk] [-g gap]\n");
+	exit(2);
+}
+
+int main (int argc, char *argv[]) {
+	static const int defaults[] = { 1, 2, 4, 8, 16, 32 };
+	int counts[MAXNODES], countCount = 0;
+	unsigned int rounds = 5, chunk = 128, gap = 0, offset, size = ImageSize(Sequences);
+	int opt, c, node, repeats;
+	unsigned int r;
+	HostTime until;
+	double t0, latency, latencyMax, poll, upload, broadcast;
+	unsigned long before, ok;
+	SbusReply *reply = malloc(sizeof(SbusReply));
+	SbusPort port;
+	char *list;
+
+	while ((opt = getopt(argc, argv, "n:r:k:g:")) != -1) {
+		switch (opt) {
+		case 'n':
+			for (list=strtok(optarg, ","); list && (countCount < MAXNODES); list=strtok(NULL, ",")) {
+				if (((counts[countCount] = atoi(list)) < 1) || (counts[countCount] > MAXNODES)) Usage();
+				countCount++;
+			}
+			break;
+		case 'r': rounds = strtoul(optarg, NULL, 0); break;
+		case 'k': chunk = strtoul(optarg, NULL, 0); break;
+		case 'g': gap = strtoul(optarg, NULL, 0); break;
+		default: Usage();
+		}
+	}
+	if ((optind != argc) || (rounds == 0) || (reply == NULL)) Usage();
+	if (countCount == 0) {
+		for (c=0; c<(int)(sizeof(defaults)/sizeof(defaults[0])); c++) counts[countCount++] = defaults[c];
+	}
+
+	memset(&port, 0, sizeof(port));
+	port.write = MasterWrite;
+	port.read = MasterRead;
+	port.clock = MasterClock;
+	printf("nodes,latency_ms,latency_max_ms,poll_cycle_ms,upload_s,upload_bytes_per_s,"
+		   "broadcast_upload_s,broadcast_repeats,collisions,broadcast_collisions\n");
+	for (c=0; c<countCount; c++) {
+		Start(counts[c]);
+		Sbus_InitPort(&port);
+		while (busNow < (HostTime)(STARTUP * HOST_UNITHZ)) Step((HostTime)(STARTUP * HOST_UNITHZ));
+
+		// poll every node
+		latency = latencyMax = 0; ok = 0;
+		t0 = MasterClock(&port);
+		for (r=0; r<rounds; r++) {
+			for (node=1; node<=nodes; node++) {
+				double start = (port.idleFrom > MasterClock(&port)) ? port.idleFrom : MasterClock(&port);
+				double took;
+				if ((Sbus_Report(&port, node, DEVICEADD, reply) != SBUS_OK) || (reply->size != 1) ||
+					(reply->data[0] != node)) continue;
+				took = MasterClock(&port) - start;
+				latency += took;
+				if (took > latencyMax) latencyMax = took;
+				ok++;
+			}
+		}
+		poll = (MasterClock(&port) - t0) / rounds;
+		if (ok != rounds * nodes) fprintf(stderr, "sbus-bus: %d nodes: %lu of %u polls answered\n",
+										  nodes, ok, rounds * nodes);
+
+		// one node, then all of them at once
+		t0 = MasterClock(&port);
+		if (Sbus_Upload(&port, 1, SBUS_BULKSEQS, Sequences, size, chunk, 0) != SBUS_OK)
+			fprintf(stderr, "sbus-bus: %d nodes: upload failed\n", nodes);
+		upload = MasterClock(&port) - t0;
+		t0 = MasterClock(&port);
+		repeats = 0;
+		Sbus_Upload(&port, SBUS_QUIETCAST, SBUS_BULKSEQS, Sequences, size, chunk, gap);
+		for (node=1; node<=nodes; node++) {
+			if ((Sbus_BulkOffset(&port, node, &offset) == SBUS_OK) && (offset == size)) continue;
+			repeats++;
+			if (Sbus_Upload(&port, node, SBUS_BULKSEQS, Sequences, size, chunk, 0) != SBUS_OK)
+				fprintf(stderr, "sbus-bus: %d nodes: node %d upload failed\n", nodes, node);
+		}
+		broadcast = MasterClock(&port) - t0;
+
+		// everyone answers at once
+		before = collisions;
+		Sbus_Report(&port, SBUS_BROADCAST, DEVICEADD, reply);
+		for (until=busNow + HOST_UNITHZ/10; busNow < until; ) Step(until);
+
+		printf("%d,%.1f,%.1f,%.1f,%.2f,%.0f,%.2f,%d,%lu,%lu\n", nodes, ok ? latency * 1000.0 / ok : 0.0,
+			   latencyMax * 1000.0, poll * 1000.0, upload, size / upload, broadcast, repeats, before,
+			   collisions - before);
+		Stop();
+	}
+	free(reply);
+	return 0;
+}
@@ -0,0 +1,367 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	fuzz.c
+* \details  Robustness and throughput harness of the SBUS command parser.
+*			Bytes go into the RS-485 receive ring as the receive interrupt
+*			puts them there and \em SBUS_Process_Command runs whenever the
+*			scheduler would run it, once a frame has ended or the ring is half
+*			full.  Every input starts from the same booted node with the shipped
+*			Sequences.inc in the 24LC256.
+*
+*			  sbus-fuzz [file...]              each file, or stdin, is one input
+*			  sbus-fuzz -r count [-s seed]     random inputs made from valid frames
+*			  sbus-fuzz -w dir                 writes the valid frames as seed files
+*			  sbus-fuzz -b                     throughput of each command as CSV
+*
+*			An input fails if a command takes more than 30 seconds of virtual
+*			time, which only a parser stuck in a loop does, or if it leaves the
+*			player with a sequence range that is empty or does not hold the
+*			active sequence.  A failing input is reported and the run aborts,
+*			so AFL (afl-fuzz -- sbus-fuzz @@) sees it as a crash; the input of
+*			a random run is also in sbus-fuzz.last.  Memory errors need a build
+*			with -fsanitize=address,undefined; built by clang with -DFUZZER this
+*			file is instead a libFuzzer target with no main.
+*
+*			The throughput benchmark runs each command ten times and writes one
+*			CSV line per command:
+*
+*			  command,frame_bytes,reply_bytes,us,frames_per_s
+*
+*			\em us is the simulated time from the first character of the frame
+*			arriving at 9600 baud until the reply has been handed to the UART,
+*			and \em frames_per_s its inverse: the rate one node can be driven at
+*			with that command.
+*/
+//************************************************************************************
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+#include "RS485.h"
+#include "SBUS.h"
+#include "Macros.h"
+
+#define LF			(0x0A)
+#define BAUD		(9600)
+#define MAXINPUT	(4096)
+#define BUDGET		(30.0)					/*!< virtual seconds one command may take */
+#define REPEATS		(10)					/*!< frames timed per command */
+
+typedef struct _Seed {
+	const char *command;
+	const char *setup;						/*!< frames sent before the timed one */
+	const char *frame;
+} Seed;
+
+// Valid frames of every command; the two hex digits before <CR> are the unchecked LRC
+static const Seed seeds[] = {
+	{ "READSEGS",		NULL,	":FF10000000010000\r\n" },
+	{ "WRITESEGS",		NULL,	":FF2000000A05102030400000\r\n" },
+	{ "WRITESEGS new",	NULL,	":FF20FFFF0A05102030400000\r\n" },
+	{ "RUNSEGS",		NULL,	":FF30000000020000\r\n" },
+	{ "ERASESEGS",		NULL,	":FF40000100010000\r\n" },
+	{ "CONFIGURE",		NULL,	":FF50000100050000\r\n" },
+	{ "REPORT",			NULL,	":FF60000900\r\n" },
+	{ "REPORT all",		NULL,	":FF60FFFF00\r\n" },
+	{ "READMACROS",		":FF8000000001000200\r\n",	":FF70FFFF00000000\r\n" },
+	{ "WRITEMACROS",	NULL,	":FF8000000001000200\r\n" },
+	{ "DISPLAY",		NULL,	":FF9080400020100000\r\n" },
+	{ "BULKSTART",		NULL,	":FFA00000000C0000\r\n" },
+	{ "BULKDATA",		":FFA00000000C0000\r\n",	":FFB00000060A102030405500\r\n" },
+	{ "STREAM",			NULL,	":FFC00001102030400500\r\n" },
+	{ "TIMESYNC",		NULL,	":FFD00000123400\r\n" },
+	{ "RUNAT",			NULL,	":FFE0000000010000100000\r\n" },
+	{ "STATS",			NULL,	":FFF0000000000000\r\n" },
+	{ "STATS counters",	NULL,	":FFF0000300000000\r\n" },
+	{ "other address",	NULL,	":0110000000010000\r\n" },
+	{ "group",			NULL,	":E060000900\r\n" }
+};
+
+#define SEEDS	(sizeof(seeds)/sizeof(seeds[0]))
+
+extern void ConfigureOscillator (void);
+extern void InitApp (void);
+extern const unsigned char Sequences[];
+extern unsigned int activeSequence, maxAddress, minAddress;
+extern BOOL playMacros;
+
+static unsigned char part[EE24_BYTES];		/*!< 24LC256 every input starts from */
+static unsigned char dataEE[HOST_EESIZE];	/*!< and data EEPROM */
+static const unsigned char *input;			/*!< the input being run, for the report */
+static size_t inputSize;
+static unsigned long txBytes;
+static unsigned long seed = 1;
+
+static void Tx (unsigned char byte, HostTime now) {
+	(void)byte; (void)now;
+	txBytes++;
+}
+
+static unsigned char Night (HostTime now) {
+	(void)now;
+	return 1;
+}
+
+static void Report (const char *problem) {
+	size_t i;
+
+	fprintf(stderr, "sbus-fuzz: %s after this input:\n", problem);
+	for (i=0; i<inputSize; i++) {
+		if ((input[i] >= ' ') && (input[i] < 0x7F)) fputc(input[i], stderr);
+		else fprintf(stderr, "\\x%02X", input[i]);
+	}
+	fprintf(stderr, "\n");
+	abort();
+}
+
+static void Hung (void) {
+	Report("a command took more than 30 seconds");
+}
+
+static long ImageSize (const unsigned char *image) {
+	long i;
+
+	for (i=0; image[i] != ENDMARK; i++) {
+		while (image[i] != ENDMARK) i += BYTESPERSEQ;
+	}
+	return i + 1;
+}
+
+// Boots a node with the shipped sequences, as a FLASHCOPY build leaves the part
+static void Boot (void) {
+	static HostBoard board = { EE24_Bus, NULL, Tx, NULL, NULL, Night };
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	memcpy(EE24_Memory, Sequences, ImageSize(Sequences));
+	EE24_Memory[EE24_BYTES-2] = 0x55;				// MAGIC
+	EE24_Memory[EE24_BYTES-1] = 0xAA;
+	Host_OnFinish = Hung;
+	Host_Init(&board, BUDGET);
+	ConfigureOscillator();
+	InitApp();
+	memcpy(part, EE24_Memory, sizeof(part));
+	memcpy(dataEE, Host_EEPROM, sizeof(dataEE));
+}
+
+static void Restore (void) {
+	memcpy(EE24_Memory, part, sizeof(part));
+	memcpy(Host_EEPROM, dataEE, sizeof(dataEE));
+	Host_Deadline(BUDGET);
+	InitApp();
+}
+
+static void Process (void) {
+	while (RS485_CharReady() && RS485_FrameReady()) {
+		Host_Deadline(BUDGET);
+		SBUS_Process_Command();
+		if ((minAddress > maxAddress) || (activeSequence < minAddress) || (activeSequence > maxAddress) ||
+			(playMacros && (maxAddress >= Macros_Count())))
+			Report("the player was left with a bad sequence range");
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Puts a character into the receive ring as \em RS485_interrupt
+*			does and lets the parser run when the scheduler would.
+*/
+//********************************************************************************
+static void Receive (unsigned char ch) {
+	if ((RS485_RxBuf[RS485_WtPtr++] = ch) == LF) RS485_LineIn();
+	Process();
+}
+
+static void Run (const unsigned char *data, size_t size) {
+	size_t i;
+
+	input = data; inputSize = size;
+	Restore();
+	for (i=0; i<size; i++) Receive(data[i]);
+}
+
+static void Send (const char *frames) {
+	while (frames && *frames) Receive((unsigned char)*frames++);
+}
+
+//********************************************************************************
+/**
+* \details  Times each command once its setup frames have been handled.
+*/
+//********************************************************************************
+static void Throughput (void) {
+	const Seed *s;
+	HostTime start, total;
+	unsigned long replies, size;
+	double us;
+	int n;
+
+	printf("command,frame_bytes,reply_bytes,us,frames_per_s\n");
+	for (s=seeds; s<seeds+SEEDS; s++) {
+		input = (const unsigned char *)s->frame; inputSize = strlen(s->frame);
+		Restore();
+		Send(s->setup);
+		size = strlen(s->frame);
+		total = 0; replies = 0;
+		for (n=0; n<REPEATS; n++) {
+			txBytes = 0;
+			start = Host_Now();
+			Send(s->frame);
+			total += Host_Now() - start;
+			replies += txBytes;
+		}
+		us = (double)total * 1e6 / HOST_UNITHZ / REPEATS + size * 10.0 * 1e6 / BAUD;
+		printf("%s,%lu,%lu,%.0f,%.1f\n", s->command, size, replies / REPEATS, us, 1e6 / us);
+	}
+}
+
+static unsigned int Random (unsigned int range) {
+	seed = seed * 1103515245UL + 12345UL;
+	return (unsigned int)((seed >> 16) % range);
+}
+
+//********************************************************************************
+/**
+* \details  Makes an input of a few valid frames and damages it: characters
+*			are changed, often to ones the parser treats specially, dropped,
+*			repeated or added, and frames are cut short.
+*/
+//********************************************************************************
+static size_t Mutate (unsigned char *out) {
+	static const char special[] = ":\r\n0F9AafgG \xFF";
+	size_t size = 0, length, at;
+	int frames = 1 + Random(4), edits = Random(6), i;
+	const char *frame;
+
+	for (i=0; i<frames; i++) {
+		frame = seeds[Random(SEEDS)].frame;
+		length = strlen(frame);
+		if (size + length > MAXINPUT/2) break;
+		memcpy(out + size, frame, length);
+		size += length;
+	}
+	for (i=0; (i < edits) && (size > 0); i++) {
+		at = Random(size);
+		switch (Random(6)) {
+		case 0: out[at] = Random(256); break;
+		case 1: out[at] = special[Random(sizeof(special)-1)]; break;
+		case 2:
+			memmove(out + at, out + at + 1, size - at - 1);
+			size--;
+			break;
+		case 3:
+			// a long run of one hex digit overflows the parameter buffer
+			length = 1 + Random(600);
+			if (size + length > MAXINPUT) break;
+			memmove(out + at + length, out + at, size - at);
+			memset(out + at, "0A:"[Random(3)], length);
+			size += length;
+			break;
+		case 4:
+			if (size + 1 > MAXINPUT) break;
+			memmove(out + at + 1, out + at, size - at);
+			out[at] = special[Random(sizeof(special)-1)];
+			size++;
+			break;
+		default: size = at; break;
+		}
+	}
+	return size;
+}
+
+static void Fuzz (unsigned long count) {
+	static unsigned char buffer[MAXINPUT];
+	unsigned long n, first = seed;
+	size_t size;
+	FILE *f;
+
+	for (n=0; n<count; n++) {
+		size = Mutate(buffer);
+		if ((f = fopen("sbus-fuzz.last", "wb")) != NULL) {
+			fwrite(buffer, 1, size, f);
+			fclose(f);
+		}
+		Run(buffer, size);
+	}
+	printf("%lu inputs, seed %lu: no failures\n", count, first);
+}
+
+static void WriteSeeds (const char *dir) {
+	char name[1024];
+	FILE *f;
+	size_t i;
+
+	for (i=0; i<SEEDS; i++) {
+		snprintf(name, sizeof(name), "%s/seed%02u", dir, (unsigned int)i);
+		if ((f = fopen(name, "wb")) == NULL) { perror(name); exit(2); }
+		if (seeds[i].setup) fputs(seeds[i].setup, f);
+		fputs(seeds[i].frame, f);
+		fclose(f);
+	}
+}
+
+static void RunFile (FILE *f) {
+	static unsigned char buffer[MAXINPUT];
+
+	Run(buffer, fread(buffer, 1, sizeof(buffer), f));
+}
+
+#ifdef FUZZER
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size) {
+	static int booted;
+
+	if (!booted) { Boot(); booted = 1; }
+	if (size <= MAXINPUT) Run(data, size);
+	return 0;
+}
+
+#else
+
+static void Usage (void) {
+	fprintf(stderr, "usage: sbus-fuzz [file...] | -r count [-s seed] | -w dir | -b\n");
+	exit(2);
+}
+
+int main (int argc, char *argv[]) {
+	unsigned long count = 0;
+	const char *dir = NULL;
+	int opt, bench = 0, i;
+	FILE *f;
+
+	while ((opt = getopt(argc, argv, "r:s:w:b")) != -1) {
+		switch (opt) {
+		case 'r': count = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		case 'w': dir = optarg; break;
+		case 'b': bench = 1; break;
+		default: Usage();
+		}
+	}
+	if (dir) {
+		WriteSeeds(dir);
+		return 0;
+	}
+	Boot();
+	if (bench) Throughput();
+	else if (count > 0) Fuzz(count);
+	else if (optind == argc) RunFile(stdin);
+	else {
+		for (i=optind; i<argc; i++) {
+			if ((f = fopen(argv[i], "rb")) == NULL) { perror(argv[i]); return 2; }
+			RunFile(f);
+			fclose(f);
+		}
+	}
+	return 0;
+}
+
+#endif
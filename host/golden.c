@@ -0,0 +1,347 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	golden.c
+* \details  Golden waveform regression test of sequence playback.  The
+*			firmware boots on the simulator with the sequences of the
+*			Sequences.inc it was built with in the 24LC256, as a FLASHCOPY
+*			build leaves them, and plays the whole show once.  The PWM outputs
+*			are compared with a golden file:
+*
+*			  sbus-golden [-x part] [-t ticks] [-u] golden
+*
+*			\em -x plays a 24LC256 image from \em showc \em -x instead.  \em -t
+*			is the timing tolerance in 5mS ticks (default 1) and \em -u writes
+*			the golden file from this run rather than checking it.
+*
+*			The waveform is kept as ramps, one line each: the tick of the first
+*			level step, the number of steps, the ticks between them and the
+*			levels before and after.  A run of steps is one ramp while every
+*			channel moves by one level in the same direction, or stays, at an
+*			even pace; a change of more than one level is a ramp of one step.
+*
+*			  # tick steps interval from to
+*			  17 255 1 00000000 0000FF00
+*
+*			The levels of every ramp must match exactly.  The time from each
+*			ramp to the next and the length of each ramp may each be \em -t
+*			ticks out, so a late segment shows as one error rather than
+*			moving everything after it.  The run ends once it has as many ramps
+*			as the golden file, or when it is recording after the ideal playing
+*			time of the show and the start-up flashes; the ramp cut short then
+*			is left out.
+*/
+//************************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+
+#define TICKMS		(5)						/*!< system tick */
+#define STARTUP		(10.0)					/*!< seconds allowed for the version flashes */
+#define MAXERRORS	(20)					/*!< mismatches listed */
+
+typedef struct _Ramp {
+	long start, steps, interval;
+	unsigned char from[4], to[4];
+} Ramp;
+
+typedef struct _Ramps {
+	Ramp *items;
+	long count, size;
+} Ramps;
+
+extern const unsigned char Sequences[];		/*!< Sequences.inc in main_1.c */
+
+static Ramps golden, run;
+static Ramp current;
+static int ramping;							/*!< current holds a ramp still growing */
+static signed char direction[4];			/*!< of each channel in the current ramp */
+static unsigned char levels[4];				/*!< outputs as of the last whole tick */
+static unsigned char pending[4];			/*!< outputs set in the tick being written */
+static long pendingTick = -1, lastTick;
+static long tolerance = 1;
+static int update;
+static const char *goldenName, *imageName;
+
+static void Fail (const char *message, const char *detail) {
+	fprintf(stderr, "sbus-golden: %s%s\n", message, detail ? detail : "");
+	exit(2);
+}
+
+static void Add (Ramps *r, const Ramp *ramp) {
+	if (r->count == r->size) {
+		r->size = r->size ? 2*r->size : 1024;
+		if ((r->items = realloc(r->items, r->size * sizeof(Ramp))) == NULL) Fail("out of memory", NULL);
+	}
+	r->items[r->count++] = *ramp;
+}
+
+// Ideal ticks of one segment from PWM_Ramp until its hold runs out, as the PWM tick plays it
+static long SegmentTicks (unsigned char level[4], const unsigned char *g) {
+	unsigned int counter = g[0], done, i;
+	long ticks = 0;
+	int fading = 1;
+
+	for (;;) {
+		ticks++;
+		if (fading) {
+			if (counter == 0) {
+				done = 0;
+				for (i=0; i<4; i++) {
+					if (level[i] < g[2+i]) level[i]++;
+					else if (level[i] > g[2+i]) level[i]--;
+					else done++;
+				}
+				if (done == 4) {
+					counter = 10 * (unsigned int)g[1];
+					fading = 0;
+				} else counter = g[0];
+			}
+		} else if (counter == 0) return ticks;
+		if (counter > 0) counter--;
+	}
+}
+
+// Bytes up to the second end mark; the levels may be 255 too, so the walk is by segment
+static long ImageSize (const unsigned char *image) {
+	long i;
+
+	for (i=0; image[i] != ENDMARK; i++) {
+		while (image[i] != ENDMARK) i += BYTESPERSEQ;
+	}
+	return i + 1;
+}
+
+static double ShowSeconds (const unsigned char *image) {
+	unsigned char level[4] = { 0, 0, 0, 0 };
+	long ticks = 0, i;
+
+	for (i=0; image[i] != ENDMARK; i++) {
+		for (; image[i] != ENDMARK; i+=BYTESPERSEQ) ticks += SegmentTicks(level, &image[i]);
+	}
+	return (double)ticks * TICKMS / 1000.0;
+}
+
+static void Close (void) {
+	if (ramping) Add(&run, &current);
+	ramping = 0;
+}
+
+//********************************************************************************
+/**
+* \details  Adds the outputs of a whole tick to the ramps.
+*/
+//********************************************************************************
+static void Step (long tick, const unsigned char next[4]) {
+	int i, jump = 0, fits = ramping;
+	signed char delta;
+
+	for (i=0; i<4; i++) {
+		delta = (next[i] > levels[i]) ? 1 : ((next[i] < levels[i]) ? -1 : 0);
+		if ((next[i] > levels[i] + 1) || (next[i] + 1 < levels[i])) jump = 1;
+		if ((delta != 0) && (delta != direction[i])) fits = 0;
+	}
+	if (fits && (current.steps > 1) && (tick - lastTick != current.interval)) fits = 0;
+	if (jump) fits = 0;
+
+	if (fits) {
+		if (current.steps == 1) current.interval = tick - lastTick;
+		current.steps++;
+	} else {
+		Close();
+		current.start = tick;
+		current.steps = 1;
+		current.interval = 0;
+		memcpy(current.from, levels, 4);
+		for (i=0; i<4; i++) direction[i] = jump ? 0 : ((next[i] > levels[i]) ? 1 : ((next[i] < levels[i]) ? -1 : 0));
+		ramping = !jump;
+		if (jump) {
+			memcpy(current.to, next, 4);
+			Add(&run, &current);
+		}
+	}
+	if (ramping) memcpy(current.to, next, 4);
+	memcpy(levels, next, 4);
+	lastTick = tick;
+}
+
+static void Finish (void);
+
+static void Pwm (const unsigned char duty[4], HostTime now) {
+	long tick = (long)(now * (1000/TICKMS) / HOST_UNITHZ);
+
+	// the simulator sees each duty cycle register written; the tick sets all four
+	if ((pendingTick >= 0) && (tick != pendingTick) && (memcmp(pending, levels, 4) != 0)) Step(pendingTick, pending);
+	pendingTick = tick;
+	memcpy(pending, duty, 4);
+	if (!update && (run.count > golden.count)) Finish();
+}
+
+static unsigned char Night (HostTime now) {
+	(void)now;
+	return 1;
+}
+
+static void Hex (FILE *f, const unsigned char level[4]) {
+	fprintf(f, " %02X%02X%02X%02X", level[0], level[1], level[2], level[3]);
+}
+
+static void Save (void) {
+	FILE *f = fopen(goldenName, "w");
+	long i;
+
+	if (f == NULL) { perror(goldenName); exit(2); }
+	fprintf(f, "# Golden waveform of %s played by the host build; make golden-update rewrites it\n", imageName);
+	fprintf(f, "# tick steps interval from to\n");
+	for (i=0; i<run.count; i++) {
+		fprintf(f, "%ld %ld %ld", run.items[i].start, run.items[i].steps, run.items[i].interval);
+		Hex(f, run.items[i].from);
+		Hex(f, run.items[i].to);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+	printf("%s: %ld ramps recorded to %.3fs\n", goldenName, run.count,
+		   run.count ? (double)run.items[run.count-1].start * TICKMS / 1000.0 : 0.0);
+}
+
+static void Load (void) {
+	FILE *f = fopen(goldenName, "r");
+	char line[256];
+	unsigned int from, to;
+	int i;
+	Ramp ramp;
+
+	if (f == NULL) { perror(goldenName); exit(2); }
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') continue;
+		if (sscanf(line, "%ld %ld %ld %x %x", &ramp.start, &ramp.steps, &ramp.interval, &from, &to) != 5)
+			Fail("bad line in ", goldenName);
+		for (i=0; i<4; i++) {
+			ramp.from[i] = from >> (24 - 8*i);
+			ramp.to[i] = to >> (24 - 8*i);
+		}
+		Add(&golden, &ramp);
+	}
+	fclose(f);
+	if (golden.count == 0) Fail("no ramps in ", goldenName);
+}
+
+static void Print (const char *what, long index, const Ramp *r) {
+	printf("  %-8s ramp %5ld at %9.3fs: %4ld steps every %3ld ticks", what, index,
+		   (double)r->start * TICKMS / 1000.0, r->steps, r->interval);
+	Hex(stdout, r->from);
+	printf(" ->");
+	Hex(stdout, r->to);
+	printf("\n");
+}
+
+//********************************************************************************
+/**
+* \details  Compares the run with the golden ramps and exits with 0 if it
+*			matches, 1 if not.
+*/
+//********************************************************************************
+static void Compare (void) {
+	long i, errors = 0, gap, length, worstGap = 0, worstLength = 0;
+	const Ramp *g, *r;
+
+	for (i=0; (i < golden.count) && (i < run.count); i++) {
+		g = &golden.items[i];
+		r = &run.items[i];
+		if ((memcmp(g->from, r->from, 4) != 0) || (memcmp(g->to, r->to, 4) != 0) || (g->steps != r->steps)) {
+			// the waveform has changed shape; nothing after this lines up
+			Print("golden", i, g);
+			Print("run", i, r);
+			errors++;
+			break;
+		}
+		length = (r->steps - 1)*r->interval - (g->steps - 1)*g->interval;
+		gap = (i > 0) ? (r->start - run.items[i-1].start) - (g->start - golden.items[i-1].start) : 0;
+		if (labs(length) > labs(worstLength)) worstLength = length;
+		if (labs(gap) > labs(worstGap)) worstGap = gap;
+		if ((labs(length) > tolerance) || (labs(gap) > tolerance)) {
+			if (++errors <= MAXERRORS) {
+				printf("  ramp %ld %s by %+ld ticks\n", i, (labs(length) > tolerance) ? "length" : "start",
+					   (labs(length) > tolerance) ? length : gap);
+				Print("golden", i, g);
+				Print("run", i, r);
+			}
+		}
+	}
+	if ((i == run.count) && (i < golden.count)) {
+		printf("  the run ended after %ld of the %ld golden ramps\n", run.count, golden.count);
+		errors++;
+	}
+	printf("%s: %ld ramps, worst start %+ldms, worst length %+ldms, end %+.3fs: %s\n", goldenName, i,
+		   worstGap*TICKMS, worstLength*TICKMS,
+		   (i > 0) ? (double)(run.items[i-1].start - golden.items[i-1].start) * TICKMS / 1000.0 : 0.0,
+		   errors ? "FAIL" : "PASS");
+	exit(errors ? 1 : 0);
+}
+
+static void Finish (void) {
+	// the ramp in progress may have been cut short, so it is left out
+	if (run.count > golden.count) run.count = golden.count;
+	if (update) Save();
+	else Compare();
+	exit(0);
+}
+
+static void Usage (void) {
+	fprintf(stderr, "usage: sbus-golden [-x part] [-t ticks] [-u] golden\n");
+	exit(2);
+}
+
+int main (int argc, char *argv[]) {
+	HostBoard board = { EE24_Bus, Pwm, NULL, NULL, NULL, Night };
+	const unsigned char *image = Sequences;
+	double seconds;
+	FILE *f;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "x:t:u")) != -1) {
+		switch (opt) {
+		case 'x': imageName = optarg; break;
+		case 't': tolerance = atol(optarg); break;
+		case 'u': update = 1; break;
+		default: Usage();
+		}
+	}
+	if (argc - optind != 1) Usage();
+	goldenName = argv[optind];
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	if (imageName) {
+		if ((f = fopen(imageName, "rb")) == NULL) { perror(imageName); exit(2); }
+		if (fread(EE24_Memory, 1, EE24_BYTES, f) != EE24_BYTES) Fail("short image ", imageName);
+		fclose(f);
+		image = EE24_Memory;
+	} else {
+		// as CopyFlashToEEPROM leaves the part
+		memcpy(EE24_Memory, Sequences, ImageSize(Sequences));
+		EE24_Memory[EE24_BYTES-2] = 0x55;				// MAGIC
+		EE24_Memory[EE24_BYTES-1] = 0xAA;
+		imageName = "Sequences.inc";
+	}
+
+	if (update) {
+		seconds = STARTUP + ShowSeconds(image) * 1.01;
+		golden.count = 0x7FFFFFFFL;
+	} else {
+		Load();
+		seconds = STARTUP + (double)golden.items[golden.count-1].start * TICKMS / 1000.0 * 1.1;
+	}
+	Host_OnFinish = Finish;
+	Host_Init(&board, seconds);
+	Firmware_main();
+	Host_Finish();
+	return 0;
+}
@@ -0,0 +1,196 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	i2ceeprom.c
+* \details  Pin-level model of a Microchip 24LC256 with its address pins tied
+*			low (control byte 0xA0/0xA1).  The model follows SCL and SDA as the
+*			firmware drives them and answers with its own SDA level:
+*
+*			- a write addresses one 64-byte page; data beyond the end of the
+*			  page wraps to the start of the same page,
+*			- the bytes are programmed by a 5mS write cycle started by the stop
+*			  condition, during which the control byte is not acknowledged,
+*			- a read continues sequentially through the whole array and rolls
+*			  over at the end,
+*			- a read without an address starts at the current address, one past
+*			  the last byte accessed.
+*
+*			Bus timing is not checked; the firmware is slower than the part.
+*/
+//************************************************************************************
+
+#include <string.h>
+#include "i2ceeprom.h"
+
+#define CONTROL		(0xA0)						/*!< 1010 A2 A1 A0 = 0 */
+#define WRITECYCLE	(HOST_UNITHZ/200)			/*!< 5mS write cycle */
+
+typedef enum _State { IDLE, CONTROLBYTE, ADDRESSHI, ADDRESSLO, WRITING, READING } State;
+
+unsigned char EE24_Memory[EE24_BYTES];
+EE24Counts EE24_Counts;
+
+static State state = IDLE;
+static unsigned char lastScl = 1, lastSda = 1;
+static unsigned char out = 1;					/*!< SDA level the part drives */
+static unsigned char bits;						/*!< bits shifted in or out of the byte */
+static unsigned char shift;
+static int ackSlot;								/*!< ninth clock of a byte */
+static int masterAck;							/*!< the master acknowledged the byte read */
+static unsigned int address;					/*!< internal address counter */
+static unsigned char page[EE24_PAGE];			/*!< bytes latched for the write cycle */
+static unsigned char latched[EE24_PAGE];
+static unsigned int latchedCount;
+static HostTime busyUntil, startTime;
+static int inTransaction;
+
+void EE24_ClearCounts (void) {
+	memset(&EE24_Counts, 0, sizeof(EE24_Counts));
+}
+
+static void Start (HostTime now) {
+	EE24_Counts.starts++;
+	if (!inTransaction) {
+		inTransaction = 1;
+		startTime = now;
+	}
+	latchedCount = 0;						// a repeated start abandons a write
+	memset(latched, 0, sizeof(latched));
+	state = CONTROLBYTE;
+	bits = 0; shift = 0; ackSlot = 0;
+	out = 1;
+}
+
+static void Stop (HostTime now) {
+	unsigned int base = address & ~(EE24_PAGE-1);
+	unsigned int i;
+
+	EE24_Counts.stops++;
+	if (inTransaction) {
+		EE24_Counts.busTime += now - startTime;
+		inTransaction = 0;
+	}
+	if ((state == WRITING) && (latchedCount > 0)) {
+		// the array reads back the new data once the cycle is over; reads are
+		// refused until then anyway
+		for (i=0; i<EE24_PAGE; i++) {
+			if (latched[i]) {
+				EE24_Memory[base + i] = page[i];
+				EE24_Counts.bytesWritten++;
+			}
+		}
+		EE24_Counts.writeCycles++;
+		busyUntil = now + WRITECYCLE;
+	}
+	state = IDLE;
+	out = 1;
+}
+
+//********************************************************************************
+/**
+* \details  A whole byte has been clocked in.  Returns TRUE to acknowledge it.
+*/
+//********************************************************************************
+static int Received (unsigned char byte, HostTime now) {
+	unsigned int offset;
+
+	EE24_Counts.bytesIn++;
+	switch (state) {
+	case CONTROLBYTE:
+		if ((byte & 0xFE) != CONTROL) break;
+		if (now < busyUntil) {
+			EE24_Counts.busyNacks++;
+			break;
+		}
+		state = (byte & 0x01) ? READING : ADDRESSHI;
+		return 1;
+	case ADDRESSHI:
+		address = ((unsigned int)(byte & 0x7F) << 8) | (address & 0xFF);
+		state = ADDRESSLO;
+		return 1;
+	case ADDRESSLO:
+		address = (address & 0x7F00) | byte;
+		state = WRITING;
+		return 1;
+	case WRITING:
+		offset = address & (EE24_PAGE-1);
+		page[offset] = byte;
+		if (!latched[offset]) latchedCount++;
+		latched[offset] = 1;
+		address = (address & ~(EE24_PAGE-1)) | ((offset + 1) & (EE24_PAGE-1));
+		return 1;
+	default:
+		break;
+	}
+	state = IDLE;
+	return 0;
+}
+
+static void LoadByte (void) {
+	shift = EE24_Memory[address];
+	address = (address + 1) & (EE24_BYTES-1);
+	EE24_Counts.bytesOut++;
+	bits = 0;
+	out = shift >> 7;
+}
+
+//********************************************************************************
+/**
+* \details  Bus hook.  Start and stop conditions are SDA edges while SCL is
+*			high; data moves in on the rising edge of SCL and out on the falling
+*			edge.
+*/
+//********************************************************************************
+unsigned char EE24_Bus (unsigned char scl, unsigned char sda, HostTime now) {
+	unsigned char bus = sda & out;
+
+	if (scl && lastScl && (sda != lastSda)) {
+		if (sda) Stop(now);
+		else Start(now);
+	} else if (scl && !lastScl) {
+		// rising edge: sample
+		if (state == READING) {
+			if (ackSlot) masterAck = (bus == 0);
+		} else if ((state != IDLE) && !ackSlot) {
+			shift = (shift << 1) | sda;
+			bits++;
+		}
+	} else if (!scl && lastScl) {
+		// falling edge: drive
+		if (state == READING) {
+			if (ackSlot) {
+				// the ninth clock of the control byte, which the part acknowledged
+				// itself, or of a data byte
+				ackSlot = 0;
+				if (masterAck) LoadByte();
+				else { state = IDLE; out = 1; }
+			} else if (++bits < 8) {
+				out = (shift >> (7 - bits)) & 1;
+			} else {
+				ackSlot = 1;
+				out = 1;					// release SDA for the master
+			}
+		} else if (state != IDLE) {
+			if (ackSlot) {
+				ackSlot = 0;
+				out = 1;
+				bits = 0; shift = 0;
+			} else if (bits == 8) {
+				ackSlot = 1;
+				if (Received(shift, now)) {
+					out = 0;
+				} else {
+					EE24_Counts.nacks++;
+					out = 1;
+				}
+			}
+		}
+	}
+	lastScl = scl;
+	lastSda = sda;
+	return out;
+}
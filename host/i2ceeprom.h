@@ -0,0 +1,45 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	i2ceeprom.h
+* \details  Interface of the 24LC256 serial EEPROM model on the simulated I2C
+*			bus.
+*/
+//************************************************************************************
+#ifndef _HOST_I2CEEPROM_H_
+#define _HOST_I2CEEPROM_H_
+
+#include "sim.h"
+
+#define EE24_BYTES		(32768)			/*!< 256Kbit array */
+#define EE24_PAGE		(64)			/*!< write page */
+
+typedef struct _EE24Counts {
+	unsigned long starts;				/*!< start and repeated start conditions */
+	unsigned long stops;				/*!< stop conditions */
+	unsigned long bytesIn;				/*!< bytes clocked into the part, control bytes included */
+	unsigned long bytesOut;				/*!< bytes read from the part */
+	unsigned long nacks;				/*!< bytes the part did not acknowledge */
+	unsigned long busyNacks;			/*!< control bytes refused during a write cycle */
+	unsigned long writeCycles;			/*!< internal write cycles started */
+	unsigned long bytesWritten;			/*!< bytes programmed by the write cycles */
+	HostTime busTime;					/*!< time from each start to its stop */
+} EE24Counts;
+
+// Memory array; erased (0xFF) unless loaded before the run
+extern unsigned char EE24_Memory[EE24_BYTES];
+
+// Activity counters
+extern EE24Counts EE24_Counts;
+
+// Bus hook for HostBoard.i2c: returns the level the part drives SDA to
+extern unsigned char EE24_Bus (unsigned char scl, unsigned char sda, HostTime now);
+
+// Clears the counters
+extern void EE24_ClearCounts (void);
+
+#endif
@@ -0,0 +1,312 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	main.c
+* \details  Command line front end of the simulator.  The firmware runs
+*			unchanged for a given span of virtual time against a board whose
+*			inputs come from the command line and whose outputs go to files:
+*
+*			  -t seconds     virtual run time (default 10)
+*			  -r file        bytes sent to the firmware over RS-485 ('-' is stdin)
+*			  -R seconds     when the first byte is sent (default 1)
+*			  -o file        bytes the firmware transmits
+*			  -p file        PWM changes as CSV: seconds,ch1,ch2,ch3,ch4
+*			  -v file        PWM changes as a VCD waveform of four 8-bit signals
+*			  -b t:mask:dur  holds the inputs in 'mask' (1, 2 buttons; 4-32 cues)
+*			                 down from t for dur seconds; may be repeated
+*			  -N level       night sensor level on RA4 (default 1, dark)
+*			  -e file        data EEPROM image, loaded if it exists and saved on exit
+*			  -x file        24LC256 image, loaded if it exists and saved on exit
+*			  -X             no 24LC256 on the I2C bus
+*			  -q             no summary on stderr
+*			  -P             RS-485 on a pseudo terminal instead of -r and -o,
+*			                 with virtual time held to the wall clock; its name
+*			                 is printed on stderr for the sbus client
+*/
+//************************************************************************************
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+
+#define MAXPRESSES	(32)
+#define MAXRX		(65536)
+
+typedef struct _Press {
+	double start, length;
+	unsigned char mask;
+} Press;
+
+static Press presses[MAXPRESSES];
+static int pressCount;
+static unsigned char night = 1;
+static unsigned char rxData[MAXRX];
+static size_t rxSize, rxNext;
+static double rxDelay = 1.0;
+static FILE *txFile, *pwmFile, *vcdFile;
+static const char *eeName, *extName;
+static int noExt;
+static int quiet;
+static int pty = -1;						/*!< pseudo terminal master */
+static double wallStart;
+
+static double Wall (void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double Seconds (HostTime t) {
+	return (double)t / HOST_UNITHZ;
+}
+
+static unsigned char Buttons (HostTime now) {
+	double t = Seconds(now);
+	unsigned char mask = 0;
+	int i;
+
+	for (i=0; i<pressCount; i++) {
+		if ((t >= presses[i].start) && (t < presses[i].start + presses[i].length)) mask |= presses[i].mask;
+	}
+	return mask;
+}
+
+static unsigned char Night (HostTime now) {
+	(void)now;
+	return night;
+}
+
+static int Rx (unsigned char *byte, HostTime *start) {
+	if (rxNext >= rxSize) return 0;
+	*byte = rxData[rxNext++];
+	*start = (HostTime)(rxDelay * HOST_UNITHZ);
+	return 1;
+}
+
+static void Tx (unsigned char byte, HostTime now) {
+	(void)now;
+	if (txFile) fputc(byte, txFile);
+	if (pty >= 0) (void)write(pty, &byte, 1);
+}
+
+// Bytes from the pseudo terminal start on the line as they arrive
+static int PtyRx (unsigned char *byte, HostTime *start) {
+	if (rxNext >= rxSize) return 0;
+	*byte = rxData[rxNext++];
+	*start = Host_Now();
+	return 1;
+}
+
+//********************************************************************************
+/**
+* \details  Every millisecond of virtual time waits for the wall clock to
+*			catch up and takes in what the client has sent meanwhile.
+*/
+//********************************************************************************
+static HostTime PtySync (HostTime now) {
+	double ahead = Seconds(now) - (Wall() - wallStart);
+	struct timespec t;
+	ssize_t n;
+
+	if (ahead > 0) {
+		t.tv_sec = (time_t)ahead;
+		t.tv_nsec = (long)((ahead - t.tv_sec) * 1e9);
+		nanosleep(&t, NULL);
+	}
+	if (rxNext == rxSize) rxNext = rxSize = 0;
+	if ((rxSize < sizeof(rxData)) && ((n = read(pty, rxData + rxSize, sizeof(rxData) - rxSize)) > 0)) rxSize += n;
+	return now + HOST_UNITHZ/1000;
+}
+
+// Opens the pseudo terminal raw and keeps its slave open so clients can come and go
+static void OpenPty (void) {
+	struct termios t;
+	const char *name;
+	int slave;
+
+	if (((pty = posix_openpt(O_RDWR | O_NOCTTY)) < 0) || (grantpt(pty) < 0) || (unlockpt(pty) < 0) ||
+		((name = ptsname(pty)) == NULL) || ((slave = open(name, O_RDWR | O_NOCTTY)) < 0)) {
+		perror("sbus-sim: pseudo terminal");
+		exit(1);
+	}
+	if (tcgetattr(slave, &t) == 0) {
+		cfmakeraw(&t);
+		tcsetattr(slave, TCSANOW, &t);
+	}
+	fcntl(pty, F_SETFL, fcntl(pty, F_GETFL) | O_NONBLOCK);
+	fprintf(stderr, "sbus-sim: RS-485 on %s\n", name);
+}
+
+static void VcdValue (unsigned char level, char id) {
+	int bit;
+
+	fputc('b', vcdFile);
+	for (bit=7; bit>=0; bit--) fputc('0' + ((level >> bit) & 1), vcdFile);
+	fprintf(vcdFile, " %c\n", id);
+}
+
+// Value change dump with a 1uS time scale; the outputs start at 0 like the CCP registers
+static void VcdHeader (void) {
+	int i;
+
+	fprintf(vcdFile, "$timescale 1us $end\n$scope module pwm $end\n");
+	for (i=0; i<4; i++) fprintf(vcdFile, "$var wire 8 %c ch%d $end\n", '!' + i, i + 1);
+	fprintf(vcdFile, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+	for (i=0; i<4; i++) VcdValue(0, '!' + i);
+	fprintf(vcdFile, "$end\n");
+}
+
+static void Pwm (const unsigned char duty[4], HostTime now) {
+	static unsigned char last[4];
+	int i;
+
+	if (pwmFile) fprintf(pwmFile, "%.6f,%u,%u,%u,%u\n", Seconds(now), duty[0], duty[1], duty[2], duty[3]);
+	if (vcdFile) {
+		fprintf(vcdFile, "#%.0f\n", Seconds(now) * 1e6);
+		for (i=0; i<4; i++) {
+			if (duty[i] != last[i]) VcdValue(duty[i], '!' + i);
+			last[i] = duty[i];
+		}
+	}
+}
+
+static unsigned char NoDevice (unsigned char scl, unsigned char sda, HostTime now) {
+	(void)scl; (void)sda; (void)now;
+	return 1;
+}
+
+static void Load (const char *name, unsigned char *image, size_t size) {
+	FILE *f = fopen(name, "rb");
+
+	if (f == NULL) return;
+	if (fread(image, 1, size, f) != size) {
+		fprintf(stderr, "%s: short image\n", name);
+		exit(1);
+	}
+	fclose(f);
+}
+
+static void Save (const char *name, const unsigned char *image, size_t size) {
+	FILE *f;
+
+	if ((name == NULL) || (f = fopen(name, "wb")) == NULL) return;
+	fwrite(image, 1, size, f);
+	fclose(f);
+}
+
+static void Finish (void) {
+	if (txFile) fclose(txFile);
+	if (pwmFile) fclose(pwmFile);
+	if (vcdFile) fclose(vcdFile);
+	Save(eeName, Host_EEPROM, HOST_EESIZE);
+	if (!noExt) Save(extName, EE24_Memory, EE24_BYTES);
+	if (quiet) return;
+	fprintf(stderr, "time %.3fs  cycles %llu  idle %.1f%%  interrupts %lu\n", Seconds(Host_Now()),
+			Host_Counts.cycles, Host_Counts.cycles ? 100.0*Host_Counts.idle/Host_Counts.cycles : 0.0,
+			Host_Counts.interrupts);
+	fprintf(stderr, "uart rx %lu (overrun %lu, framing %lu) tx %lu  eeprom writes %lu  pwm changes %lu\n",
+			Host_Counts.rxBytes, Host_Counts.rxOverruns, Host_Counts.rxFraming, Host_Counts.txBytes,
+			Host_Counts.eeWrites, Host_Counts.pwmChanges);
+	if (noExt) return;
+	fprintf(stderr, "i2c starts %lu stops %lu bytes in %lu out %lu nacks %lu (busy %lu)  "
+					"write cycles %lu (%lu bytes)  bus %.3fs\n",
+			EE24_Counts.starts, EE24_Counts.stops, EE24_Counts.bytesIn, EE24_Counts.bytesOut,
+			EE24_Counts.nacks, EE24_Counts.busyNacks, EE24_Counts.writeCycles, EE24_Counts.bytesWritten,
+			Seconds(EE24_Counts.busTime));
+}
+
+static void Usage (void) {
+	fprintf(stderr, "usage: sbus-sim [-t seconds] [-r file] [-R seconds] [-o file] [-p file] [-v file]\n"
+					"                [-b t:mask:dur]... [-N level] [-e file] [-x file | -X] [-q] [-P]\n");
+	exit(2);
+}
+
+static FILE *Open (const char *name, const char *mode, FILE *std) {
+	FILE *f;
+
+	if (strcmp(name, "-") == 0) return std;
+	if ((f = fopen(name, mode)) == NULL) {
+		perror(name);
+		exit(1);
+	}
+	return f;
+}
+
+int main (int argc, char *argv[]) {
+	HostBoard board = { EE24_Bus, Pwm, Tx, Rx, Buttons, Night };
+	double seconds = 10.0;
+	FILE *f;
+	int opt;
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	while ((opt = getopt(argc, argv, "t:r:R:o:p:v:b:N:e:x:XqP")) != -1) {
+		switch (opt) {
+		case 't': seconds = atof(optarg); break;
+		case 'r':
+			f = Open(optarg, "rb", stdin);
+			rxSize = fread(rxData, 1, sizeof(rxData), f);
+			if (f != stdin) fclose(f);
+			break;
+		case 'R': rxDelay = atof(optarg); break;
+		case 'o': txFile = Open(optarg, "wb", stdout); break;
+		case 'p': pwmFile = Open(optarg, "w", stdout); break;
+		case 'v':
+			vcdFile = Open(optarg, "w", stdout);
+			VcdHeader();
+			break;
+		case 'b':
+			if (pressCount == MAXPRESSES) Usage();
+			presses[pressCount].length = 0.1;
+			{
+				unsigned int mask = 0;
+				if (sscanf(optarg, "%lf:%u:%lf", &presses[pressCount].start, &mask, &presses[pressCount].length) < 2) Usage();
+				presses[pressCount].mask = (unsigned char)mask;
+			}
+			pressCount++;
+			break;
+		case 'N': night = atoi(optarg) != 0; break;
+		case 'e':
+			eeName = optarg;
+			if ((f = fopen(eeName, "rb")) != NULL) {
+				fclose(f);
+				Load(eeName, Host_EEPROM, HOST_EESIZE);
+				Host_EEPROMLoaded = 1;
+			}
+			break;
+		case 'x':
+			extName = optarg;
+			Load(extName, EE24_Memory, EE24_BYTES);
+			break;
+		case 'X': noExt = 1; break;
+		case 'q': quiet = 1; break;
+		case 'P': OpenPty(); break;
+		default: Usage();
+		}
+	}
+	if (optind != argc) Usage();
+
+	if (noExt) board.i2c = NoDevice;
+	if (pty >= 0) {
+		if (rxSize) Usage();
+		board.rx = PtyRx;
+		board.sync = PtySync;
+		wallStart = Wall();
+	}
+	Host_OnFinish = Finish;
+	Host_Init(&board, seconds);
+	Firmware_main();
+	Host_Finish();
+	return 0;
+}
@@ -0,0 +1,303 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	sbuscli.c
+* \details  Command line client of the SBUS protocol over a serial device or
+*			a pseudo terminal, such as the one sbus-sim -P opens.  Numbers are
+*			decimal or 0x hex; the device address is given in hex.
+*
+*			  sbus [-d device] [-a address] [-t ms] [-w] [-T] command [arguments]
+*
+*			  report [item]                      one REPORT item or all of them
+*			  readsegs first [count]             segments of 'count' sequences
+*			  writesegs seq|new f,h,r,g,b,w ...  segments added to a sequence
+*			  runsegs first count                play a range of sequences
+*			  erasesegs first last               delete a range of sequences
+*			  configure item value
+*			  readmacros [count]                 the first 'count' or all macros
+*			  writemacros macro ...
+*			  display r g b w                    fixed levels until the next RUNSEGS
+*			  stream frame r g b w [fade]        one STREAM frame, never answered
+*			  timesync tick                      the master tick count to slew to
+*			  runat first count tick             start a range at a tick
+*			  stats page [clear]                 a STATS page, cleared if 'clear'
+*			  upload seqs|macros file [chunk [gap]]
+*			                                     bulk upload of a binary image
+*			  raw command address [hex]          any frame
+*
+*			The device is -d, else $SBUS_DEVICE, else /dev/ttyUSB0, and the
+*			address is FF by default.  -w wakes a sleeping device first and -T
+*			prints the time from the frame to the end of its reply.  The exit
+*			status is 0 when the command succeeded, 1 when it failed and 2 for
+*			bad arguments.
+*/
+//************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sbuslib.h"
+
+#define MAXIMAGE	(65536)
+
+static SbusReply reply;
+
+static void Usage (void) {
+	fprintf(stderr,
+		"usage: sbus [-d device] [-a address] [-t ms] [-w] [-T] command [arguments]\n"
+		"  report [item] | readsegs first [count] | writesegs seq|new f,h,r,g,b,w ...\n"
+		"  runsegs first count | erasesegs first last | configure item value\n"
+		"  readmacros [count] | writemacros macro ... | display r g b w\n"
+		"  stream frame r g b w [fade] | timesync tick | runat first count tick\n"
+		"  stats page [clear] | upload seqs|macros file [chunk [gap]] | raw command address [hex]\n");
+	exit(2);
+}
+
+static unsigned long Number (const char *text, unsigned long max) {
+	char *end;
+	unsigned long value = strtoul(text, &end, 0);
+
+	if ((*text == '\0') || (*end != '\0') || (value > max)) {
+		fprintf(stderr, "sbus: bad number '%s'\n", text);
+		exit(2);
+	}
+	return value;
+}
+
+static void Data (size_t from) {
+	size_t i;
+
+	for (i=from; i<reply.size; i++) printf("%02X", reply.data[i]);
+	printf("\n");
+}
+
+//********************************************************************************
+/**
+* \details  REPORT items are a byte or a word each and items 4, 6 and 8 send
+*			nothing, so the reply to FFFF is taken apart by this table.
+*/
+//********************************************************************************
+static void PrintReport (unsigned int item) {
+	static const struct { const char *name; int size; } items[] = {
+		{ "state", 1 }, { "offtime", 1 }, { "ontime", 1 }, { "duration", 2 }, { NULL, 0 },
+		{ "startseq", 2 }, { NULL, 0 }, { "totalseq", 2 }, { NULL, 0 }, { "device", 1 },
+		{ "sequences", 2 }, { "groups", 1 }, { "syncoffset", 2 }, { "syncslew", 2 }
+	};
+	unsigned int first = (item == SBUS_ALL) ? 0 : item;
+	unsigned int last = (item == SBUS_ALL) ? sizeof(items)/sizeof(items[0]) - 1 : item;
+	size_t at = 0;
+
+	if (first >= sizeof(items)/sizeof(items[0])) {
+		Data(0);
+		return;
+	}
+	for (item=first; item<=last; item++) {
+		if (items[item].size == 0) continue;
+		if (at + items[item].size > reply.size) break;
+		printf("%-10s %u\n", items[item].name,
+			   items[item].size == 1 ? reply.data[at] : Sbus_Word(&reply, at));
+		at += items[item].size;
+	}
+}
+
+static void PrintSegments (void) {
+	size_t at = 2, i;
+	unsigned int sequence = reply.address, size;
+
+	while (at < reply.size) {
+		size = reply.data[at++];
+		printf("sequence %u:", sequence++);
+		for (i=0; (i + 6 <= size) && (at + i + 6 <= reply.size); i+=6) {
+			printf(" %u,%u,%u,%u,%u,%u", reply.data[at+i], reply.data[at+i+1], reply.data[at+i+2],
+				   reply.data[at+i+3], reply.data[at+i+4], reply.data[at+i+5]);
+		}
+		printf("\n");
+		at += size;
+	}
+}
+
+static void PrintStats (unsigned int page) {
+	size_t at, count, i;
+
+	switch (page) {
+	case 0:
+		printf("task period maxrun late\n");
+		for (i=0, at=1; (i < reply.data[0]) && (at + 6 <= reply.size); i++, at+=6)
+			printf("%4zu %6u %6u %4u\n", i, Sbus_Word(&reply, at), Sbus_Word(&reply, at+2), Sbus_Word(&reply, at+4));
+		break;
+	case 1:
+		if (reply.size >= 2) printf("idle %u%%  wake latency %u\n", reply.data[0], reply.data[1]);
+		break;
+	case 2:
+		printf("source count average longest overruns\n");
+		for (i=0, at=1; (i < reply.data[0]) && (at + 8 <= reply.size); i++, at+=8)
+			printf("%6zu %5u %7u %7u %8u\n", i, Sbus_Word(&reply, at), Sbus_Word(&reply, at+2),
+				   Sbus_Word(&reply, at+4), Sbus_Word(&reply, at+6));
+		break;
+	case 3:
+		for (i=0, at=1; (i < reply.data[0]) && (at + 2 <= reply.size); i++, at+=2) printf("%u ", Sbus_Word(&reply, at));
+		printf("\n");
+		break;
+	case 4:
+		if (reply.size < 3) break;
+		count = reply.data[0];
+		printf("entries %zu lost %u\n", count, Sbus_Word(&reply, 1));
+		for (i=0, at=3; (i < count) && (at + 6 <= reply.size); i++, at+=6)
+			printf("%5u %3u %3u %3u %3u\n", Sbus_Word(&reply, at), reply.data[at+2], reply.data[at+3],
+				   reply.data[at+4], reply.data[at+5]);
+		break;
+	default:
+		Data(0);
+		break;
+	}
+}
+
+static SbusStatus Upload (SbusPort *port, unsigned char id, int argc, char *argv[]) {
+	static unsigned char image[MAXIMAGE];
+	unsigned int target, chunk = 128, gap = 0;
+	size_t size;
+	FILE *f;
+
+	if ((argc < 2) || (argc > 4)) Usage();
+	if (strcmp(argv[0], "seqs") == 0) target = SBUS_BULKSEQS;
+	else if (strcmp(argv[0], "macros") == 0) target = SBUS_BULKMACROS;
+	else Usage();
+	if (argc > 2) chunk = Number(argv[2], SBUS_MAXCHUNK);
+	if (argc > 3) gap = Number(argv[3], 60000);
+	if ((f = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		exit(1);
+	}
+	size = fread(image, 1, sizeof(image), f);
+	fclose(f);
+	return Sbus_Upload(port, id, target, image, size, chunk, gap);
+}
+
+static SbusStatus Raw (SbusPort *port, unsigned char id, int argc, char *argv[]) {
+	unsigned char data[SBUS_MAXCHUNK];
+	size_t size = 0, i, n;
+	unsigned int byte;
+
+	if ((argc < 2) || (argc > 3)) Usage();
+	if (argc == 3) {
+		n = strlen(argv[2]);
+		if ((n & 1) || (n/2 > sizeof(data))) Usage();
+		for (i=0; i<n; i+=2) {
+			if (sscanf(argv[2] + i, "%2x", &byte) != 1) Usage();
+			data[size++] = byte;
+		}
+	}
+	return Sbus_Command(port, id, Number(argv[0], 0xFF), Number(argv[1], 0xFFFF), data, size, &reply);
+}
+
+int main (int argc, char *argv[]) {
+	const char *device = getenv("SBUS_DEVICE");
+	unsigned char id = SBUS_BROADCAST, level[4], segments[SBUS_MAXCHUNK];
+	unsigned int macros[SBUS_MAXCHUNK/2], count, i, timeout = 0;
+	int opt, wake = 0, timing = 0;
+	const char *command;
+	SbusStatus status;
+	SbusPort port;
+	double start;
+	char *arg;
+
+	while ((opt = getopt(argc, argv, "d:a:t:wT")) != -1) {
+		switch (opt) {
+		case 'd': device = optarg; break;
+		case 'a': id = strtoul(optarg, NULL, 16); break;
+		case 't': timeout = Number(optarg, 600000); break;
+		case 'w': wake = 1; break;
+		case 'T': timing = 1; break;
+		default: Usage();
+		}
+	}
+	if (optind == argc) Usage();
+	command = argv[optind++];
+	argc -= optind; argv += optind;
+	if (device == NULL) device = "/dev/ttyUSB0";
+	if (!Sbus_OpenSerial(&port, device)) {
+		perror(device);
+		return 1;
+	}
+	if (timeout) port.timeout = timeout;
+	if (wake) Sbus_Wake(&port);
+	start = port.clock(&port);
+	memset(&reply, 0, sizeof(reply));
+
+	if (strcmp(command, "report") == 0) {
+		if (argc > 1) Usage();
+		count = argc ? Number(argv[0], 0xFFFF) : SBUS_ALL;
+		if ((status = Sbus_Report(&port, id, count, &reply)) == SBUS_OK) PrintReport(count);
+	} else if (strcmp(command, "readsegs") == 0) {
+		if ((argc < 1) || (argc > 2)) Usage();
+		status = Sbus_ReadSegs(&port, id, Number(argv[0], 0xFFFF), argc > 1 ? Number(argv[1], 0xFFFF) : 1, &reply);
+		if (status == SBUS_OK) PrintSegments();
+	} else if (strcmp(command, "writesegs") == 0) {
+		if ((argc < 2) || (argc > 1 + SBUS_MAXCHUNK/6)) Usage();
+		for (count=0; count<(unsigned int)argc-1; count++) {
+			arg = argv[count+1];
+			for (i=0; i<6; i++) {
+				segments[6*count+i] = strtoul(arg, &arg, 0);
+				if ((*arg != (i < 5 ? ',' : '\0'))) Usage();
+				arg++;
+			}
+		}
+		status = Sbus_WriteSegs(&port, id, strcmp(argv[0], "new") ? Number(argv[0], 0xFFFE) : SBUS_NEWSEQ,
+								segments, count, &reply);
+		if (status == SBUS_OK) printf("%u bytes written\n", Sbus_Word(&reply, 0));
+	} else if (strcmp(command, "runsegs") == 0) {
+		if (argc != 2) Usage();
+		status = Sbus_RunSegs(&port, id, Number(argv[0], 0xFFFF), Number(argv[1], 0xFFFF), &reply);
+	} else if (strcmp(command, "erasesegs") == 0) {
+		if (argc != 2) Usage();
+		status = Sbus_EraseSegs(&port, id, Number(argv[0], 0xFFFF), Number(argv[1], 0xFFFF), &reply);
+	} else if (strcmp(command, "configure") == 0) {
+		if (argc != 2) Usage();
+		status = Sbus_Configure(&port, id, Number(argv[0], 0xFFFF), Number(argv[1], 0xFFFF), &reply);
+	} else if (strcmp(command, "readmacros") == 0) {
+		if (argc > 1) Usage();
+		status = Sbus_ReadMacros(&port, id, argc ? Number(argv[0], 0xFFFE) : SBUS_ALL, &reply);
+		if (status == SBUS_OK) {
+			for (i=2; i+2<=reply.size; i+=2) printf("%u\n", Sbus_Word(&reply, i));
+		}
+	} else if (strcmp(command, "writemacros") == 0) {
+		if ((argc < 1) || (argc > (int)(sizeof(macros)/sizeof(macros[0])))) Usage();
+		for (i=0; i<(unsigned int)argc; i++) macros[i] = Number(argv[i], 0xFFFF);
+		status = Sbus_WriteMacros(&port, id, macros, argc, &reply);
+	} else if ((strcmp(command, "display") == 0) || (strcmp(command, "stream") == 0)) {
+		i = (command[1] == 't');
+		if ((argc < 4 + (int)i) || (argc > 4 + 2*(int)i)) Usage();
+		for (count=0; count<4; count++) level[count] = Number(argv[i+count], 255);
+		if (i) status = Sbus_Stream(&port, id, Number(argv[0], 0xFFFF), level, argc > 5 ? Number(argv[5], 255) : 0);
+		else status = Sbus_Display(&port, id, level, &reply);
+	} else if (strcmp(command, "timesync") == 0) {
+		if (argc != 1) Usage();
+		status = Sbus_TimeSync(&port, id, Number(argv[0], 0xFFFFFFFFUL), &reply);
+	} else if (strcmp(command, "runat") == 0) {
+		if (argc != 3) Usage();
+		status = Sbus_RunAt(&port, id, Number(argv[0], 0xFFFF), Number(argv[1], 0xFFFF),
+							Number(argv[2], 0xFFFFFFFFUL), &reply);
+	} else if (strcmp(command, "stats") == 0) {
+		if ((argc < 1) || (argc > 2) || ((argc == 2) && strcmp(argv[1], "clear"))) Usage();
+		count = Number(argv[0], 0xFFFF);
+		if ((status = Sbus_Stats(&port, id, count, argc == 2, &reply)) == SBUS_OK) PrintStats(count);
+	} else if (strcmp(command, "upload") == 0) {
+		status = Upload(&port, id, argc, argv);
+	} else if (strcmp(command, "raw") == 0) {
+		if ((status = Raw(&port, id, argc, argv)) == SBUS_OK) Data(0);
+	} else Usage();
+
+	if (timing) printf("%.1f ms\n", (port.clock(&port) - start) * 1000.0);
+	if (status != SBUS_OK) {
+		fprintf(stderr, "sbus: %s: %s", command, Sbus_StatusName(status));
+		if (status == SBUS_REFUSED) fprintf(stderr, " (%04X)", Sbus_Word(&reply, 0));
+		fprintf(stderr, "\n");
+	}
+	Sbus_Close(&port);
+	return (status == SBUS_OK) ? 0 : 1;
+}
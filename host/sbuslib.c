@@ -0,0 +1,367 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	sbuslib.c
+* \details  Host side of the SBUS protocol.  A frame is ':', the device
+*			address, the command and the address word followed by the data and
+*			a checksum byte of "00", all as upper case hex, and <CR><LF>.  The
+*			reply repeats the first four fields, so it is matched against the
+*			command before its data is taken.  A device keeps driving the bus
+*			for 5mS after its reply and only listens again on its next pass
+*			through the SBUS task, so the next frame waits for the turnaround.
+*			Frames that get no reply may follow each other directly, since a
+*			device queues the frames that arrive while it parses one.  They can
+*			be paced \em gap mS apart for a device that takes longer to act on
+*			each than the next one takes to arrive.
+*/
+//************************************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "sbuslib.h"
+
+#define CR			(0x0D)
+#define LF			(0x0A)
+#define ERRSTATUS	(0xEF00)
+#define TIMEOUT		(2000)			/*!< default mS to the start of a reply */
+#define TURNAROUND	(15)			/*!< default mS the replying device holds the bus */
+#define GAP			(0)				/*!< default mS between frames with no reply */
+#define CHARTIME	(10.0/9600)		/*!< seconds per character on the line */
+#define CHARGAP		(500)			/*!< mS between the characters of a reply */
+#define RETRIES		(5)				/*!< failed chunks in a row before an upload gives up */
+#define MAXFRAME	(2*(6 + SBUS_MAXCHUNK + 1) + 3)
+
+static int SerialWrite (SbusPort *port, const unsigned char *data, size_t size) {
+	ssize_t n;
+
+	while (size > 0) {
+		if ((n = write(port->fd, data, size)) < 0) {
+			if (errno == EINTR) continue;
+			return 0;
+		}
+		data += n; size -= n;
+	}
+	return tcdrain(port->fd) == 0;
+}
+
+static int SerialRead (SbusPort *port, unsigned char *byte, unsigned int ms) {
+	struct pollfd p = { port->fd, POLLIN, 0 };
+	int n;
+
+	if ((n = poll(&p, 1, (int)ms)) <= 0) return (n < 0) && (errno != EINTR) ? -1 : 0;
+	n = read(port->fd, byte, 1);
+	return (n == 1) ? 1 : ((n < 0) && (errno == EAGAIN)) ? 0 : -1;
+}
+
+static double SerialClock (SbusPort *port) {
+	struct timespec t;
+
+	(void)port;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void Sbus_InitPort (SbusPort *port) {
+	port->timeout = TIMEOUT;
+	port->turnaround = TURNAROUND;
+	port->gap = GAP;
+	port->idleFrom = 0;
+}
+
+int Sbus_OpenSerial (SbusPort *port, const char *device) {
+	struct termios t;
+
+	memset(port, 0, sizeof(*port));
+	if ((port->fd = open(device, O_RDWR | O_NOCTTY)) < 0) return 0;
+	if (tcgetattr(port->fd, &t) == 0) {
+		cfmakeraw(&t);
+		cfsetispeed(&t, B9600);
+		cfsetospeed(&t, B9600);
+		t.c_cflag |= CLOCAL | CREAD;
+		t.c_cflag &= ~(CSTOPB | PARENB);
+		t.c_cc[VMIN] = 1; t.c_cc[VTIME] = 0;
+		tcsetattr(port->fd, TCSANOW, &t);
+		tcflush(port->fd, TCIOFLUSH);
+	}
+	port->write = SerialWrite;
+	port->read = SerialRead;
+	port->clock = SerialClock;
+	Sbus_InitPort(port);
+	return 1;
+}
+
+// Lets 'ms' pass on the port's clock; anything received meanwhile is dropped
+static int Wait (SbusPort *port, double ms) {
+	double until = port->clock(port) + ms / 1000.0;
+	double left;
+	unsigned char byte;
+
+	while ((left = until - port->clock(port)) > 0) {
+		if (port->read(port, &byte, (unsigned int)(left * 1000.0) + 1) < 0) return 0;
+	}
+	return 1;
+}
+
+static int WaitIdle (SbusPort *port) {
+	double wait = port->idleFrom - port->clock(port);
+
+	return (wait <= 0) || Wait(port, wait * 1000.0);
+}
+
+void Sbus_Close (SbusPort *port) {
+	WaitIdle(port);						// so the next client's first frame is heard
+	if (port->fd > 0) close(port->fd);
+	port->fd = -1;
+}
+
+SbusStatus Sbus_Wake (SbusPort *port) {
+	static const unsigned char lf = LF;
+
+	if (!port->write(port, &lf, 1) || !Wait(port, 10)) return SBUS_IOERROR;
+	return SBUS_OK;
+}
+
+static char *Hex (char *out, unsigned int value, int digits) {
+	static const char hex[] = "0123456789ABCDEF";
+
+	while (digits-- > 0) *out++ = hex[(value >> (4*digits)) & 0x0F];
+	return out;
+}
+
+static int FromHex (unsigned char ch) {
+	if (ch >= '0' && ch <= '9') return ch - '0';
+	if (ch >= 'A' && ch <= 'F') return ch - ('A' - 10);
+	if (ch >= 'a' && ch <= 'f') return ch - ('a' - 10);
+	return -1;
+}
+
+//********************************************************************************
+/**
+* \details  Reads a reply line and decodes its fields.  Waits \em timeout mS
+*			for the ':' and at most 500mS between the characters after it,
+*			which is what the firmware allows the other way.  Some replies are
+*			the frame itself, so the adapter must not echo what it sends.
+*/
+//********************************************************************************
+static SbusStatus ReadReply (SbusPort *port, SbusReply *reply) {
+	static unsigned char line[2*(4 + SBUS_MAXDATA + 1)];
+	unsigned char byte = 0;
+	size_t length = 0, i;
+	int hi, lo, n;
+
+	do {
+		if ((n = port->read(port, &byte, port->timeout)) <= 0) return n < 0 ? SBUS_IOERROR : SBUS_TIMEOUT;
+	} while (byte != ':');
+	for (;;) {
+		if ((n = port->read(port, &byte, CHARGAP)) <= 0) return n < 0 ? SBUS_IOERROR : SBUS_TIMEOUT;
+		if (byte == LF) break;
+		if (byte == CR) continue;
+		if (length == sizeof(line)) return SBUS_BADREPLY;
+		line[length++] = byte;
+	}
+	port->idleFrom = port->clock(port) + port->turnaround / 1000.0;
+	if ((length & 1) || (length < 2*(4 + 1))) return SBUS_BADREPLY;
+	for (i=0; i<length; i+=2) {
+		if (((hi = FromHex(line[i])) < 0) || ((lo = FromHex(line[i+1])) < 0)) return SBUS_BADREPLY;
+		line[i/2] = (unsigned char)((hi << 4) | lo);
+	}
+	length /= 2;
+	reply->id = line[0];
+	reply->command = line[1];
+	reply->address = ((unsigned int)line[2] << 8) | line[3];
+	reply->size = length - 4 - 1;
+	memcpy(reply->data, line + 4, reply->size);
+	return SBUS_OK;
+}
+
+SbusStatus Sbus_Command (SbusPort *port, unsigned char id, unsigned char command, unsigned int address,
+						 const unsigned char *data, size_t size, SbusReply *reply) {
+	static SbusReply scratch;
+	char frame[MAXFRAME], *p = frame;
+	SbusStatus status;
+	size_t i;
+
+	if (size > SBUS_MAXCHUNK) return SBUS_BADREPLY;
+	*p++ = ':';
+	p = Hex(p, id, 2);
+	p = Hex(p, command, 2);
+	p = Hex(p, address, 4);
+	for (i=0; i<size; i++) p = Hex(p, data[i], 2);
+	memcpy(p, "00\r\n", 4);
+	p += 4;
+
+	if (!WaitIdle(port) || !port->write(port, (const unsigned char *)frame, p - frame)) return SBUS_IOERROR;
+	if ((id == SBUS_QUIETCAST) || ((id & 0xF8) == SBUS_GROUPCAST) || (command == SBUS_STREAM)) {
+		port->idleFrom = port->clock(port) + (p - frame) * CHARTIME + port->gap / 1000.0;
+		return SBUS_OK;
+	}
+
+	if (reply == NULL) reply = &scratch;
+	if ((status = ReadReply(port, reply)) != SBUS_OK) return status;
+	if ((reply->id != id) || (reply->command != command)) return SBUS_BADREPLY;
+	if ((command != SBUS_REPORT) && (reply->size >= 2) && (Sbus_Word(reply, 0) == (ERRSTATUS | command)))
+		return SBUS_REFUSED;
+	return SBUS_OK;
+}
+
+unsigned int Sbus_Word (const SbusReply *reply, size_t index) {
+	if (index + 2 > reply->size) return 0;
+	return ((unsigned int)reply->data[index] << 8) | reply->data[index+1];
+}
+
+// Commands whose data is one more word
+static SbusStatus Fixed (SbusPort *port, unsigned char id, unsigned char command, unsigned int address,
+						 unsigned int word, SbusReply *reply) {
+	unsigned char data[2];
+
+	data[0] = word >> 8; data[1] = word & 0xFF;
+	return Sbus_Command(port, id, command, address, data, 2, reply);
+}
+
+SbusStatus Sbus_ReadSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+						  SbusReply *reply) {
+	return Fixed(port, id, SBUS_READSEGS, first, count, reply);
+}
+
+SbusStatus Sbus_WriteSegs (SbusPort *port, unsigned char id, unsigned int sequence,
+						   const unsigned char *segments, unsigned int count, SbusReply *reply) {
+	return Sbus_Command(port, id, SBUS_WRITESEGS, sequence, segments, 6*count, reply);
+}
+
+SbusStatus Sbus_RunSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+						 SbusReply *reply) {
+	return Fixed(port, id, SBUS_RUNSEGS, first, count, reply);
+}
+
+SbusStatus Sbus_EraseSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int last,
+						   SbusReply *reply) {
+	return Fixed(port, id, SBUS_ERASESEGS, first, last, reply);
+}
+
+SbusStatus Sbus_Configure (SbusPort *port, unsigned char id, unsigned int item, unsigned int value,
+						   SbusReply *reply) {
+	return Fixed(port, id, SBUS_CONFIGURE, item, value, reply);
+}
+
+SbusStatus Sbus_Report (SbusPort *port, unsigned char id, unsigned int item, SbusReply *reply) {
+	return Sbus_Command(port, id, SBUS_REPORT, item, NULL, 0, reply);
+}
+
+SbusStatus Sbus_ReadMacros (SbusPort *port, unsigned char id, unsigned int count, SbusReply *reply) {
+	if (count == SBUS_ALL) return Fixed(port, id, SBUS_READMACROS, SBUS_ALL, 0, reply);
+	return Fixed(port, id, SBUS_READMACROS, 0, count, reply);
+}
+
+SbusStatus Sbus_WriteMacros (SbusPort *port, unsigned char id, const unsigned int *macros,
+							 unsigned int count, SbusReply *reply) {
+	unsigned char data[SBUS_MAXCHUNK];
+	unsigned int i;
+
+	if (2*count > sizeof(data)) return SBUS_BADREPLY;
+	for (i=0; i<count; i++) {
+		data[2*i] = macros[i] >> 8;
+		data[2*i+1] = macros[i] & 0xFF;
+	}
+	return Sbus_Command(port, id, SBUS_WRITEMACROS, 0, data, 2*count, reply);
+}
+
+SbusStatus Sbus_Display (SbusPort *port, unsigned char id, const unsigned char level[4], SbusReply *reply) {
+	return Fixed(port, id, SBUS_DISPLAY, ((unsigned int)level[0] << 8) | level[1],
+				 ((unsigned int)level[2] << 8) | level[3], reply);
+}
+
+SbusStatus Sbus_TimeSync (SbusPort *port, unsigned char id, unsigned long tick, SbusReply *reply) {
+	return Fixed(port, id, SBUS_TIMESYNC, (tick >> 16) & 0xFFFF, tick & 0xFFFF, reply);
+}
+
+SbusStatus Sbus_RunAt (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+					   unsigned long tick, SbusReply *reply) {
+	unsigned char data[6];
+
+	data[0] = count >> 8; data[1] = count & 0xFF;
+	data[2] = tick >> 24; data[3] = tick >> 16; data[4] = tick >> 8; data[5] = tick & 0xFF;
+	return Sbus_Command(port, id, SBUS_RUNAT, first, data, sizeof(data), reply);
+}
+
+SbusStatus Sbus_Stats (SbusPort *port, unsigned char id, unsigned int page, int clear, SbusReply *reply) {
+	return Fixed(port, id, SBUS_STATS, page, clear ? 1 : 0, reply);
+}
+
+SbusStatus Sbus_Stream (SbusPort *port, unsigned char id, unsigned int frame, const unsigned char level[4],
+						unsigned char fade) {
+	unsigned char data[5];
+
+	memcpy(data, level, 4);
+	data[4] = fade;
+	return Sbus_Command(port, id, SBUS_STREAM, frame, data, sizeof(data), NULL);
+}
+
+SbusStatus Sbus_BulkOffset (SbusPort *port, unsigned char id, unsigned int *offset) {
+	static SbusReply reply;
+	SbusStatus status = Sbus_Command(port, id, SBUS_BULKDATA, 0, NULL, 0, &reply);
+
+	if (status == SBUS_REFUSED) *offset = Sbus_Word(&reply, 2);
+	else if (status == SBUS_OK) *offset = Sbus_Word(&reply, 0);
+	else return status;
+	return SBUS_OK;
+}
+
+//********************************************************************************
+/**
+* \details  The device acknowledges every chunk with the offset it expects
+*			next and refuses one beyond it with that offset too, so a lost
+*			chunk or reply is recovered by carrying on from the offset given.
+*			A chunk with no reply at all is followed by an empty one to ask.
+*			Sent to a quiet address every chunk is sent once; the devices are
+*			checked afterwards with \em Sbus_BulkOffset.
+*/
+//********************************************************************************
+SbusStatus Sbus_Upload (SbusPort *port, unsigned char id, unsigned int target, const unsigned char *image,
+						unsigned int size, unsigned int chunk, unsigned int gap) {
+	static SbusReply reply;
+	unsigned int offset = 0, length, next;
+	SbusStatus status;
+	int failures = 0;
+	int quiet = (id == SBUS_QUIETCAST) || ((id & 0xF8) == SBUS_GROUPCAST);
+	unsigned int normal = port->gap;
+
+	if ((chunk == 0) || (chunk > SBUS_MAXCHUNK)) chunk = SBUS_MAXCHUNK;
+	if (gap) port->gap = gap;
+	status = Fixed(port, id, SBUS_BULKSTART, target, size, &reply);
+	while ((status == SBUS_OK) && quiet && (offset < size)) {
+		length = (size - offset < chunk) ? size - offset : chunk;
+		status = Sbus_Command(port, id, SBUS_BULKDATA, offset, image + offset, length, &reply);
+		offset += length;
+	}
+	port->gap = normal;
+	if ((status != SBUS_OK) || quiet) return status;
+	while (offset < size) {
+		length = (size - offset < chunk) ? size - offset : chunk;
+		status = Sbus_Command(port, id, SBUS_BULKDATA, offset, image + offset, length, &reply);
+		if (status == SBUS_OK) next = Sbus_Word(&reply, 0);
+		else if (status == SBUS_REFUSED) next = Sbus_Word(&reply, 2);
+		else if ((status == SBUS_TIMEOUT) || (status == SBUS_BADREPLY)) {
+			if (Sbus_BulkOffset(port, id, &next) != SBUS_OK) next = offset;
+		} else return status;
+		if (next > offset) failures = 0;
+		else if (++failures == RETRIES) return (status == SBUS_OK) ? SBUS_BADREPLY : status;
+		if (next > size) return SBUS_BADREPLY;
+		offset = next;
+	}
+	return SBUS_OK;
+}
+
+const char *Sbus_StatusName (SbusStatus status) {
+	static const char *names[] = { "ok", "no reply", "port failed", "bad reply", "refused" };
+
+	return ((unsigned int)status < sizeof(names)/sizeof(names[0])) ? names[status] : "?";
+}
@@ -0,0 +1,140 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	sbuslib.h
+* \details  Host side of the SBUS protocol: builds the frames of every command
+*			in SBUS.c, waits for and decodes the replies and uploads images with
+*			the bulk transfer commands.  The bytes go through an SbusPort, which
+*			is a serial device or pseudo terminal from \em Sbus_OpenSerial or
+*			any other transport that fills in the three hooks, such as the
+*			virtual bus of sbus-bus.
+*/
+//************************************************************************************
+#ifndef _HOST_SBUSLIB_H_
+#define _HOST_SBUSLIB_H_
+
+#include <stddef.h>
+
+// Commands
+#define SBUS_READSEGS		(0x10)
+#define SBUS_WRITESEGS		(0x20)
+#define SBUS_RUNSEGS		(0x30)
+#define SBUS_ERASESEGS		(0x40)
+#define SBUS_CONFIGURE		(0x50)
+#define SBUS_REPORT			(0x60)
+#define SBUS_READMACROS		(0x70)
+#define SBUS_WRITEMACROS	(0x80)
+#define SBUS_DISPLAY		(0x90)
+#define SBUS_BULKSTART		(0xA0)
+#define SBUS_BULKDATA		(0xB0)
+#define SBUS_STREAM			(0xC0)
+#define SBUS_TIMESYNC		(0xD0)
+#define SBUS_RUNAT			(0xE0)
+#define SBUS_STATS			(0xF0)
+
+// Addresses
+#define SBUS_BROADCAST		(0xFF)		/*!< all devices, with reply */
+#define SBUS_QUIETCAST		(0xFE)		/*!< all devices, no reply */
+#define SBUS_GROUPCAST		(0xE0)		/*!< E0-E7: members of groups 0-7, no reply */
+
+// Bulk transfer targets
+#define SBUS_BULKSEQS		(0x0000)
+#define SBUS_BULKMACROS		(0x0001)
+
+#define SBUS_ALL			(0xFFFF)	/*!< REPORT every item, READMACROS every macro */
+#define SBUS_NEWSEQ			(0xFFFF)	/*!< WRITESEGS to a new sequence */
+#define SBUS_MAXCHUNK		(255)		/*!< data bytes the parameter buffer takes */
+#define SBUS_MAXDATA		(36864)		/*!< reply data bytes; READSEGS of a full 24LC256 */
+
+typedef enum _SbusStatus {
+	SBUS_OK,
+	SBUS_TIMEOUT,			/*!< no reply, or it stopped short */
+	SBUS_IOERROR,			/*!< the port failed */
+	SBUS_BADREPLY,			/*!< the reply is not for this command or not hex */
+	SBUS_REFUSED			/*!< the device answered with an error code */
+} SbusStatus;
+
+typedef struct _SbusReply {
+	unsigned char id, command;
+	unsigned int address;
+	size_t size;						/*!< data bytes, not counting the checksum */
+	unsigned char data[SBUS_MAXDATA];
+} SbusReply;
+
+typedef struct _SbusPort SbusPort;
+
+struct _SbusPort {
+	// sends 'size' bytes; returns 0 on failure
+	int (*write)(SbusPort *port, const unsigned char *data, size_t size);
+	// waits up to 'ms' for a received byte; returns 1 with a byte, 0 on a
+	// time-out and -1 on failure
+	int (*read)(SbusPort *port, unsigned char *byte, unsigned int ms);
+	// seconds on the clock of the transport
+	double (*clock)(SbusPort *port);
+	unsigned int timeout;		/*!< mS to wait for the start of a reply */
+	unsigned int turnaround;	/*!< mS a device drives the bus after its reply */
+	unsigned int gap;			/*!< mS between frames with no reply */
+	double idleFrom;			/*!< clock when the bus is free for the next frame */
+	int fd;						/*!< serial device */
+	void *context;				/*!< for other transports */
+};
+
+// Opens a serial device or pseudo terminal at 9600 baud, 8N1, raw; returns 0 on failure
+extern int Sbus_OpenSerial (SbusPort *port, const char *device);
+
+// Waits until the bus is free for another frame and closes the device
+extern void Sbus_Close (SbusPort *port);
+
+// Sets the defaults of a port whose hooks are filled in by the caller
+extern void Sbus_InitPort (SbusPort *port);
+
+// Wakes devices put to sleep with their pushbutton: a lone <LF> and 10mS
+extern SbusStatus Sbus_Wake (SbusPort *port);
+
+// Sends any command and, unless the address or command gets none, reads the reply
+extern SbusStatus Sbus_Command (SbusPort *port, unsigned char id, unsigned char command, unsigned int address,
+								const unsigned char *data, size_t size, SbusReply *reply);
+
+// The commands; 'reply' may be NULL where only the status matters
+extern SbusStatus Sbus_ReadSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+								 SbusReply *reply);
+extern SbusStatus Sbus_WriteSegs (SbusPort *port, unsigned char id, unsigned int sequence,
+								  const unsigned char *segments, unsigned int count, SbusReply *reply);
+extern SbusStatus Sbus_RunSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+								SbusReply *reply);
+extern SbusStatus Sbus_EraseSegs (SbusPort *port, unsigned char id, unsigned int first, unsigned int last,
+								  SbusReply *reply);
+extern SbusStatus Sbus_Configure (SbusPort *port, unsigned char id, unsigned int item, unsigned int value,
+								  SbusReply *reply);
+extern SbusStatus Sbus_Report (SbusPort *port, unsigned char id, unsigned int item, SbusReply *reply);
+extern SbusStatus Sbus_ReadMacros (SbusPort *port, unsigned char id, unsigned int count, SbusReply *reply);
+extern SbusStatus Sbus_WriteMacros (SbusPort *port, unsigned char id, const unsigned int *macros,
+									unsigned int count, SbusReply *reply);
+extern SbusStatus Sbus_Display (SbusPort *port, unsigned char id, const unsigned char level[4], SbusReply *reply);
+extern SbusStatus Sbus_TimeSync (SbusPort *port, unsigned char id, unsigned long tick, SbusReply *reply);
+extern SbusStatus Sbus_RunAt (SbusPort *port, unsigned char id, unsigned int first, unsigned int count,
+							  unsigned long tick, SbusReply *reply);
+extern SbusStatus Sbus_Stats (SbusPort *port, unsigned char id, unsigned int page, int clear, SbusReply *reply);
+extern SbusStatus Sbus_Stream (SbusPort *port, unsigned char id, unsigned int frame, const unsigned char level[4],
+							   unsigned char fade);
+
+// Uploads an image with BULKSTART and BULKDATA in chunks of 'chunk' bytes,
+// resuming from the offset the device reports after a lost frame.  Quiet
+// addresses get no reply and their chunks follow each other 'gap' mS apart (0
+// for the port's gap).
+extern SbusStatus Sbus_Upload (SbusPort *port, unsigned char id, unsigned int target, const unsigned char *image,
+							   unsigned int size, unsigned int chunk, unsigned int gap);
+
+// Offset the device expects next in a bulk transfer, asked with an empty chunk
+extern SbusStatus Sbus_BulkOffset (SbusPort *port, unsigned char id, unsigned int *offset);
+
+// Big-endian word at 'index' of the reply data
+extern unsigned int Sbus_Word (const SbusReply *reply, size_t index);
+
+extern const char *Sbus_StatusName (SbusStatus status);
+
+#endif
@@ -0,0 +1,791 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	showc.c
+* \details  Show compiler.  Reads a show as named sequences of colours with
+*			their fade and hold times, checks it against what the player can do
+*			and writes the packed sequence image: as Sequences.inc for a
+*			FLASHCOPY build, as the raw image for a BULKSTART/BULKDATA upload
+*			or as a whole 24LC256 image for a programmer or the simulator.
+*
+*			  showc [-o Sequences.inc] [-b image] [-x part] [-q] show
+*			  showc -d image
+*
+*			A show is text or, if it starts with '{', JSON.  In text each
+*			sequence starts with a \em sequence line naming it and has one line
+*			per segment: the levels and then any of \em fade, \em rate and
+*			\em hold.  Comments run from // to the end of the line.
+*
+*			  sequence Purple morph
+*			      #CC00FF5D  fade 1s   hold 100ms
+*			      32,0,64,32 rate 2    hold 100ms
+*
+*			The levels are #RRGGBBWW, #RRGGBB with the white off, or three or
+*			four decimal numbers.  \em fade is the time to reach the levels from
+*			the previous segment's, from which the fade rate is worked out;
+*			\em rate gives the fade rate byte itself, the 5mS ticks per level
+*			step.  \em hold is in steps of 50mS up to 12.75s.  Times take an ms
+*			or s suffix and are in milliseconds without one.  The same show in
+*			JSON is
+*
+*			  { "sequences": [ { "name": "Purple morph", "segments": [
+*			      { "color": "#CC00FF5D", "fade": 1000, "hold": 100 },
+*			      { "color": [32, 0, 64, 32], "rate": 2, "hold": 100 } ] } ] }
+*
+*			The report lists each sequence by its SBUS number with its segments,
+*			bytes and playing time.  Times are worked out tick by tick as the
+*			PWM module runs the fades, starting the first sequence from the
+*			levels the last one ends on as the player does when it wraps.
+*
+*			\em -d turns a raw or a 24LC256 image back into a text show.
+*/
+//************************************************************************************
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+
+#define IMAGELIMIT	(EE24_BYTES-256)		/*!< Seq_ImageLimit */
+#define TICKMS		(5)						/*!< system tick */
+#define HOLDMS		(50)					/*!< hold unit */
+#define MAXRATE		(ENDMARK-1)
+#define MAXNAME		(64)
+#define NOFADE		(-1)
+
+typedef struct _Segment {
+	unsigned char level[4];
+	unsigned char rate;						/*!< fade rate byte */
+	unsigned char hold;						/*!< hold byte */
+	long fadeMs;							/*!< fade time to meet or NOFADE */
+	int line;
+} Segment;
+
+typedef struct _Sequence {
+	char name[MAXNAME];
+	Segment *segments;
+	int count, size;
+	int line;
+} Sequence;
+
+static Sequence *sequences;
+static int seqCount, seqSize;
+static const char *sourceName;
+static int errors;
+
+static void Error (int line, const char *message, const char *detail) {
+	fprintf(stderr, "%s:%d: %s%s%s\n", sourceName, line, message, detail ? " " : "", detail ? detail : "");
+	errors++;
+}
+
+static void Warning (int line, const char *message) {
+	fprintf(stderr, "%s:%d: warning: %s\n", sourceName, line, message);
+}
+
+static void *Grow (void *array, int *size, size_t item) {
+	*size = *size ? 2 * *size : 16;
+	if ((array = realloc(array, *size * item)) == NULL) {
+		fprintf(stderr, "showc: out of memory\n");
+		exit(1);
+	}
+	return array;
+}
+
+static Sequence *NewSequence (const char *name, int line) {
+	Sequence *s;
+
+	if (seqCount == seqSize) sequences = Grow(sequences, &seqSize, sizeof(Sequence));
+	s = &sequences[seqCount++];
+	memset(s, 0, sizeof(*s));
+	if (name && *name) snprintf(s->name, sizeof(s->name), "%s", name);
+	else snprintf(s->name, sizeof(s->name), "sequence %d", seqCount-1);
+	s->line = line;
+	return s;
+}
+
+static Segment *NewSegment (Sequence *s, int line) {
+	Segment *g;
+
+	if (s->count == s->size) s->segments = Grow(s->segments, &s->size, sizeof(Segment));
+	g = &s->segments[s->count++];
+	memset(g, 0, sizeof(*g));
+	g->fadeMs = NOFADE;
+	g->line = line;
+	return g;
+}
+
+//********************************************************************************
+/**
+* \details  Parses a time with an optional ms or s suffix into milliseconds.
+*/
+//********************************************************************************
+static int ParseTime (const char *text, long *ms) {
+	char *end;
+	double value = strtod(text, &end);
+
+	if ((end == text) || (value < 0)) return 0;
+	if (strcmp(end, "s") == 0) value *= 1000.0;
+	else if ((*end != '\0') && (strcmp(end, "ms") != 0)) return 0;
+	*ms = (long)floor(value + 0.5);
+	return 1;
+}
+
+static int ParseLevel (const char *text, unsigned char *level) {
+	char *end;
+	long value = strtol(text, &end, 10);
+
+	if ((end == text) || (*end != '\0') || (value < 0) || (value > 255)) return 0;
+	*level = (unsigned char)value;
+	return 1;
+}
+
+// #RRGGBB, #RRGGBBWW or r,g,b[,w]
+static int ParseColor (const char *text, unsigned char level[4]) {
+	char part[16];
+	const char *p;
+	unsigned int n = 0, i;
+
+	level[3] = 0;
+	if (text[0] == '#') {
+		n = strlen(text+1);
+		if ((n != 6) && (n != 8)) return 0;
+		for (i=0; i<n; i++) if (!isxdigit((unsigned char)text[1+i])) return 0;
+		for (i=0; i<n/2; i++) {
+			memcpy(part, text+1+2*i, 2); part[2] = '\0';
+			level[i] = (unsigned char)strtoul(part, NULL, 16);
+		}
+		return 1;
+	}
+	for (p=text; ; p++) {
+		if ((*p == ',') || (*p == '\0')) {
+			if ((n == 4) || (p - text == 0) || (p - text >= (long)sizeof(part))) return 0;
+			memcpy(part, text, p - text); part[p - text] = '\0';
+			if (!ParseLevel(part, &level[n++])) return 0;
+			if (*p == '\0') break;
+			text = p + 1;
+		}
+	}
+	return (n == 3) || (n == 4);
+}
+
+static void SetHold (Segment *g, long ms) {
+	if (ms > 255L*HOLDMS) {
+		Error(g->line, "hold longer than 12.75s", NULL);
+		return;
+	}
+	g->hold = (unsigned char)((ms + HOLDMS/2) / HOLDMS);
+	if (ms % HOLDMS) Warning(g->line, "hold rounded to a multiple of 50ms");
+}
+
+static void SetRate (Segment *g, long rate) {
+	if ((rate < 0) || (rate > MAXRATE)) Error(g->line, "fade rate outside 0-254", NULL);
+	else g->rate = (unsigned char)rate;
+}
+
+//********************************************************************************
+/**
+* \details  Text show: one \em sequence line per sequence followed by its
+*			segment lines.
+*/
+//********************************************************************************
+static void ParseText (char *text) {
+	Sequence *s = NULL;
+	Segment *g;
+	char *line, *next, *p, *word, *value;
+	int number = 0;
+	long n;
+
+	for (line=text; line; line=next) {
+		number++;
+		if ((next = strchr(line, '\n')) != NULL) *next++ = '\0';
+		if ((p = strstr(line, "//")) != NULL) *p = '\0';
+		p = line + strlen(line);
+		while ((p > line) && isspace((unsigned char)p[-1])) *--p = '\0';
+		while (isspace((unsigned char)*line)) line++;
+		if (*line == '\0') continue;
+
+		if ((strncmp(line, "sequence", 8) == 0) && ((line[8] == '\0') || isspace((unsigned char)line[8]))) {
+			for (p=line+8; isspace((unsigned char)*p); p++);
+			if ((*p == '"') && (strlen(p) > 1) && (p[strlen(p)-1] == '"')) {
+				p[strlen(p)-1] = '\0'; p++;
+			}
+			if (strlen(p) >= MAXNAME) Error(number, "sequence name too long", NULL);
+			s = NewSequence(p, number);
+			continue;
+		}
+		if (s == NULL) {
+			Error(number, "segment before the first sequence line", NULL);
+			continue;
+		}
+		g = NewSegment(s, number);
+		word = strtok(line, " \t\r");
+		if (!ParseColor(word, g->level)) Error(number, "bad levels", word);
+		while ((word = strtok(NULL, " \t\r")) != NULL) {
+			if ((value = strtok(NULL, " \t\r")) == NULL) {
+				Error(number, "missing value after", word);
+				break;
+			}
+			if (strcmp(word, "fade") == 0) {
+				if (ParseTime(value, &n)) g->fadeMs = n;
+				else Error(number, "bad fade time", value);
+			} else if (strcmp(word, "rate") == 0) {
+				if (ParseTime(value, &n) && (strchr(value, 's') == NULL)) SetRate(g, n);
+				else Error(number, "bad fade rate", value);
+			} else if (strcmp(word, "hold") == 0) {
+				if (ParseTime(value, &n)) SetHold(g, n);
+				else Error(number, "bad hold time", value);
+			} else Error(number, "unknown keyword", word);
+		}
+	}
+}
+
+//********************************************************************************
+/**
+* \details  A small JSON reader; only what a show needs is kept.
+*/
+//********************************************************************************
+typedef enum _JType { JNULL, JBOOL, JNUMBER, JSTRING, JARRAY, JOBJECT } JType;
+
+typedef struct _JValue {
+	JType type;
+	double number;
+	char *string;
+	struct _JValue *items;					/*!< array items or object values */
+	char **keys;							/*!< object keys */
+	int count, size;
+	int line;
+} JValue;
+
+static const char *json;
+static int jsonLine = 1;
+
+static void Space (void) {
+	while (isspace((unsigned char)*json)) {
+		if (*json == '\n') jsonLine++;
+		json++;
+	}
+}
+
+static int ParseValue (JValue *v);
+
+static char *ParseString (void) {
+	const char *start = ++json;
+	char *out, *o;
+
+	while (*json && (*json != '"')) {
+		if ((*json == '\\') && json[1]) json++;
+		json++;
+	}
+	if (*json != '"') return NULL;
+	out = o = malloc(json - start + 1);
+	for (; start < json; start++) {
+		if (*start == '\\') {
+			start++;
+			*o++ = (*start == 'n') ? '\n' : (*start == 't') ? '\t' : *start;
+		} else *o++ = *start;
+	}
+	*o = '\0';
+	json++;
+	return out;
+}
+
+static int ParseItems (JValue *v, char close) {
+	JValue item;
+	char *key = NULL;
+
+	json++;
+	Space();
+	if (*json == close) { json++; return 1; }
+	for (;;) {
+		Space();
+		if (v->type == JOBJECT) {
+			if ((*json != '"') || ((key = ParseString()) == NULL)) return 0;
+			Space();
+			if (*json++ != ':') return 0;
+		}
+		if (!ParseValue(&item)) return 0;
+		if (v->count == v->size) {
+			int size = v->size;
+			v->items = Grow(v->items, &v->size, sizeof(JValue));
+			if (v->type == JOBJECT) v->keys = Grow(v->keys, &size, sizeof(char *));
+		}
+		if (v->type == JOBJECT) v->keys[v->count] = key;
+		v->items[v->count++] = item;
+		Space();
+		if (*json == ',') { json++; continue; }
+		if (*json++ == close) return 1;
+		return 0;
+	}
+}
+
+static int ParseValue (JValue *v) {
+	char *end;
+
+	Space();
+	memset(v, 0, sizeof(*v));
+	v->line = jsonLine;
+	switch (*json) {
+	case '{': v->type = JOBJECT; return ParseItems(v, '}');
+	case '[': v->type = JARRAY; return ParseItems(v, ']');
+	case '"': v->type = JSTRING; return (v->string = ParseString()) != NULL;
+	default: break;
+	}
+	if (strncmp(json, "true", 4) == 0) { v->type = JBOOL; v->number = 1; json += 4; return 1; }
+	if (strncmp(json, "false", 5) == 0) { v->type = JBOOL; json += 5; return 1; }
+	if (strncmp(json, "null", 4) == 0) { v->type = JNULL; json += 4; return 1; }
+	v->type = JNUMBER;
+	v->number = strtod(json, &end);
+	if (end == json) return 0;
+	json = end;
+	return 1;
+}
+
+static JValue *Member (JValue *object, const char *key) {
+	int i;
+
+	for (i=0; i<object->count; i++) if (strcmp(object->keys[i], key) == 0) return &object->items[i];
+	return NULL;
+}
+
+static void CheckKeys (JValue *object, const char *const known[]) {
+	int i, k;
+
+	for (i=0; i<object->count; i++) {
+		for (k=0; known[k] && strcmp(known[k], object->keys[i]); k++);
+		if (!known[k]) Error(object->items[i].line, "unknown key", object->keys[i]);
+	}
+}
+
+static int Number (JValue *v, const char *what, long *n) {
+	if ((v->type != JNUMBER) || (v->number < 0)) {
+		Error(v->line, "bad", what);
+		return 0;
+	}
+	*n = (long)floor(v->number + 0.5);
+	return 1;
+}
+
+static void ParseJSONSegment (Sequence *s, JValue *v) {
+	static const char *const known[] = { "color", "fade", "rate", "hold", NULL };
+	Segment *g = NewSegment(s, v->line);
+	JValue *m;
+	long n;
+	int i;
+
+	if (v->type != JOBJECT) {
+		Error(v->line, "segment is not an object", NULL);
+		return;
+	}
+	CheckKeys(v, known);
+	if ((m = Member(v, "color")) == NULL) Error(v->line, "segment without a color", NULL);
+	else if (m->type == JSTRING) {
+		if (!ParseColor(m->string, g->level)) Error(m->line, "bad color", m->string);
+	} else if ((m->type == JARRAY) && ((m->count == 3) || (m->count == 4))) {
+		for (i=0; i<m->count; i++) {
+			if (Number(&m->items[i], "level", &n) && (n <= 255)) g->level[i] = (unsigned char)n;
+			else Error(m->line, "level outside 0-255", NULL);
+		}
+	} else Error(m->line, "bad color", NULL);
+	if ((m = Member(v, "fade")) && Number(m, "fade", &n)) g->fadeMs = n;
+	if ((m = Member(v, "rate")) && Number(m, "rate", &n)) SetRate(g, n);
+	if ((m = Member(v, "hold")) && Number(m, "hold", &n)) SetHold(g, n);
+}
+
+static void ParseJSON (const char *text) {
+	static const char *const knownShow[] = { "sequences", NULL };
+	static const char *const knownSeq[] = { "name", "segments", NULL };
+	JValue root, *list, *seq, *m;
+	Sequence *s;
+	int i, k;
+
+	json = text;
+	if (!ParseValue(&root) || (Space(), *json != '\0')) {
+		Error(jsonLine, "JSON syntax error", NULL);
+		return;
+	}
+	if (root.type == JOBJECT) {
+		CheckKeys(&root, knownShow);
+		list = Member(&root, "sequences");
+	} else list = &root;
+	if ((list == NULL) || (list->type != JARRAY)) {
+		Error(root.line, "no sequences array", NULL);
+		return;
+	}
+	for (i=0; i<list->count; i++) {
+		seq = &list->items[i];
+		if (seq->type != JOBJECT) {
+			Error(seq->line, "sequence is not an object", NULL);
+			continue;
+		}
+		CheckKeys(seq, knownSeq);
+		m = Member(seq, "name");
+		if (m && ((m->type != JSTRING) || (strlen(m->string) >= MAXNAME))) Error(m->line, "bad name", NULL);
+		s = NewSequence((m && (m->type == JSTRING)) ? m->string : NULL, seq->line);
+		if (((m = Member(seq, "segments")) == NULL) || (m->type != JARRAY)) {
+			Error(seq->line, "sequence without a segments array", NULL);
+			continue;
+		}
+		for (k=0; k<m->count; k++) ParseJSONSegment(s, &m->items[k]);
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Plays one segment as the PWM tick does and returns the ticks from
+*			\em PWM_Ramp until the hold has run out.  \em level is moved to the
+*			segment's levels.
+*/
+//********************************************************************************
+static unsigned long SegmentTicks (unsigned char level[4], const Segment *g) {
+	unsigned int counter = g->rate, done, i;
+	unsigned long ticks = 0;
+	int fading = 1;
+
+	for (;;) {
+		ticks++;
+		if (fading) {
+			if (counter == 0) {
+				done = 0;
+				for (i=0; i<4; i++) {
+					if (level[i] < g->level[i]) level[i]++;
+					else if (level[i] > g->level[i]) level[i]--;
+					else done++;
+				}
+				if (done == 4) {
+					counter = 10 * (unsigned int)g->hold;
+					fading = 0;
+				} else counter = g->rate;
+			}
+		} else if (counter == 0) return ticks;
+		if (counter > 0) counter--;
+	}
+}
+
+static unsigned long FadeTicks (const unsigned char from[4], const Segment *g) {
+	unsigned char level[4];
+	Segment fade = *g;
+
+	memcpy(level, from, 4);
+	fade.hold = 0;
+	return SegmentTicks(level, &fade);
+}
+
+//********************************************************************************
+/**
+* \details  Picks the fade rate that comes closest to each fade time, now
+*			that the levels every segment starts from are known.
+*/
+//********************************************************************************
+static void ResolveFades (void) {
+	unsigned char level[4];
+	unsigned long ticks, target, diff, bestDiff;
+	Segment *g;
+	int s, i, rate, bestRate;
+	char message[80];
+
+	if (seqCount == 0) return;
+	memset(level, 0, sizeof(level));
+	if (sequences[seqCount-1].count > 0)
+		memcpy(level, sequences[seqCount-1].segments[sequences[seqCount-1].count-1].level, 4);
+	for (s=0; s<seqCount; s++) {
+		for (i=0; i<sequences[s].count; i++) {
+			g = &sequences[s].segments[i];
+			if (g->fadeMs != NOFADE) {
+				// the fade gets longer with the rate
+				target = (g->fadeMs + TICKMS/2) / TICKMS;
+				bestRate = 0; bestDiff = (unsigned long)-1;
+				for (rate=0; rate<=MAXRATE; rate++) {
+					g->rate = rate;
+					ticks = FadeTicks(level, g);
+					diff = (ticks > target) ? ticks - target : target - ticks;
+					if (diff < bestDiff) { bestRate = rate; bestDiff = diff; }
+					if (ticks >= target) break;
+				}
+				g->rate = bestRate;
+				ticks = FadeTicks(level, g);
+				if (bestDiff*TICKMS > (unsigned long)g->fadeMs/10 + TICKMS) {
+					snprintf(message, sizeof(message), "fade of %ldms plays as %lums", g->fadeMs, ticks*TICKMS);
+					Warning(g->line, message);
+				}
+			}
+			memcpy(level, g->level, 4);
+		}
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Packs the show into \em image: each segment as fade, hold and RGBW,
+*			an ENDMARK after each sequence and another after the last.  Returns
+*			the size.
+*/
+//********************************************************************************
+static unsigned int Pack (unsigned char image[IMAGELIMIT]) {
+	unsigned int size = 0, need;
+	Segment *g;
+	int s, i;
+
+	for (s=0; s<seqCount; s++) {
+		need = sequences[s].count*BYTESPERSEQ + 1;
+		if (size + need + 1 > IMAGELIMIT) {
+			Error(sequences[s].line, "the show is larger than the sequence store", NULL);
+			return 0;
+		}
+		for (i=0; i<sequences[s].count; i++) {
+			g = &sequences[s].segments[i];
+			image[size++] = g->rate;
+			image[size++] = g->hold;
+			memcpy(&image[size], g->level, 4);
+			size += 4;
+		}
+		image[size++] = ENDMARK;
+	}
+	image[size++] = ENDMARK;
+	return size;
+}
+
+static void Check (void) {
+	int s;
+
+	if (seqCount == 0) Error(1, "no sequences", NULL);
+	if (seqCount > EEMAX) Error(sequences[EEMAX].line, "more sequences than the player can number", NULL);
+	for (s=0; s<seqCount; s++) {
+		// an empty sequence would read as the end of all of them
+		if (sequences[s].count == 0) Error(sequences[s].line, "sequence without segments:", sequences[s].name);
+	}
+}
+
+static void Report (unsigned int size) {
+	unsigned char level[4];
+	unsigned long ticks, total = 0;
+	int s, i;
+
+	memcpy(level, sequences[seqCount-1].segments[sequences[seqCount-1].count-1].level, 4);
+	printf(" seq  %-32s segments  bytes  duration\n", "name");
+	for (s=0; s<seqCount; s++) {
+		ticks = 0;
+		for (i=0; i<sequences[s].count; i++) ticks += SegmentTicks(level, &sequences[s].segments[i]);
+		total += ticks;
+		printf("%4d  %-32s %8d  %5d  %7.2fs\n", s, sequences[s].name, sequences[s].count,
+			   sequences[s].count*BYTESPERSEQ + 1, ticks*TICKMS/1000.0);
+	}
+	printf("%d sequences, %u of %u bytes (%.1f%%), %.2fs to play them all\n", seqCount, size, IMAGELIMIT,
+		   100.0*size/IMAGELIMIT, total*TICKMS/1000.0);
+}
+
+static FILE *Create (const char *name, const char *mode) {
+	FILE *f = fopen(name, mode);
+
+	if (f == NULL) {
+		perror(name);
+		exit(1);
+	}
+	return f;
+}
+
+//********************************************************************************
+/**
+* \details  Writes the show as the Sequences[] initializer included by
+*			main_1.c for FLASHCOPY builds.
+*/
+//********************************************************************************
+static void WriteInclude (const char *name) {
+	FILE *f = Create(name, "w");
+	const Segment *g;
+	int s, i;
+
+	fprintf(f,
+		"//************************************************************************************\n"
+		"//\n"
+		"// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.\n"
+		"// You are permitted to modify and use this code for personal use only.\n"
+		"//\n"
+		"//************************************************************************************\n"
+		"/**\n"
+		"* \\file   \tSequences.inc\n"
+		"* \\details  This module defines the default sequences that a FLASHCOPY build\n"
+		"*\t\t\tcopies to the external EEPROM.  It is generated by the show compiler\n"
+		"*\t\t\tfrom %s; edit the show and run \\em make \\em sequences in\n"
+		"*\t\t\thost/ rather than changing the numbers here.\n"
+		"* \\author   Michael Griebling\n"
+		"* \\date   \t10 Nov 2011\n"
+		"*/ \n"
+		"//************************************************************************************\n"
+		"\n"
+		"//\tSequence Data Format\n"
+		"//\t--------------------\n"
+		"//\tEach segment is six bytes: fade_rate, hold_time, red, green, blue, white.\n"
+		"//\tThe levels are 0 to 255.\n"
+		"//\n"
+		"//\tEnd of current sequence\n"
+		"//\t-----------------------\n"
+		"//\tA fade_rate of 255 ends the current sequence.  A sequence has at least\n"
+		"//\tone segment.\n"
+		"//\n"
+		"//\tEnd of all sequence data\n"
+		"//\t------------------------\n"
+		"//\tA second 255 straight after the end of a sequence ends all the sequences.\n"
+		"//\n"
+		"//\tFade Rate\n"
+		"//\t---------\n"
+		"//\tThe levels move from the current values to the new ones in steps of 1\n"
+		"//\t(0 to 100 takes 100 steps), one step every fade_rate ticks of 5mS.  A\n"
+		"//\tfade_rate of 0 steps every tick like 1.  The longest fade, 255 steps at\n"
+		"//\ta fade_rate of 254, takes 5m24s.\n"
+		"//\n"
+		"//\tHold Time\n"
+		"//\t---------\n"
+		"//\tHow long to hold the levels once they are reached before the next\n"
+		"//\tsegment: 50mS x hold_time, up to 12.75 secs.  A hold_time of 0 goes\n"
+		"//\tstraight on to the next segment.\n"
+		"//\n"
+		"//\t      |------------------------- Fade Rate\n"
+		"//\t      |    |-------------------- Hold time\n"
+		"//\t      |    |    |--------------- Red\n"
+		"//\t      |    |    |    |---------- Green\n"
+		"//\t      |    |    |    |    |----- Blue\n"
+		"//\t      |    |    |    |    |    |-- White\n"
+		"//\t      |    |    |    |    |    |\n"
+		"const unsigned char Sequences[] = { \n", sourceName);
+	for (s=0; s<seqCount; s++) {
+		fprintf(f, "\n\t// %d: %s\n", s, sequences[s].name);
+		for (i=0; i<sequences[s].count; i++) {
+			g = &sequences[s].segments[i];
+			fprintf(f, "\t   %3u, %3u, %3u, %3u, %3u, %3u,\n", g->rate, g->hold,
+					g->level[0], g->level[1], g->level[2], g->level[3]);
+		}
+		fprintf(f, "\t   255,\t\t// end of sequence %d\n", s);
+	}
+	fprintf(f, "\n\t   255\t\t// end of all data\n\t};\n");
+	fclose(f);
+}
+
+static void WriteImage (const char *name, const unsigned char *image, unsigned int size) {
+	FILE *f = Create(name, "wb");
+
+	fwrite(image, 1, size, f);
+	fclose(f);
+}
+
+// The image as the part holds it after a FLASHCOPY: the rest erased and MAGIC at the end
+static void WritePart (const char *name, const unsigned char *image, unsigned int size) {
+	static unsigned char part[EE24_BYTES];
+
+	memset(part, 0xFF, sizeof(part));
+	memcpy(part, image, size);
+	part[EE24_BYTES-2] = 0x55;
+	part[EE24_BYTES-1] = 0xAA;
+	WriteImage(name, part, sizeof(part));
+}
+
+//********************************************************************************
+/**
+* \details  Prints a raw or 24LC256 image as a text show.  Fades are given as
+*			rates so the show compiles back to the same bytes.
+*/
+//********************************************************************************
+static int Decompile (const char *name) {
+	static unsigned char image[EE24_BYTES];
+	FILE *f = fopen(name, "rb");
+	unsigned int size, i = 0;
+	int s = 0;
+
+	if (f == NULL) {
+		perror(name);
+		return 1;
+	}
+	size = fread(image, 1, sizeof(image), f);
+	fclose(f);
+	printf("// decompiled from %s\n", name);
+	while ((i < size) && (image[i] != ENDMARK)) {
+		printf("\nsequence sequence %d\n", s++);
+		while ((i + BYTESPERSEQ <= size) && (image[i] != ENDMARK)) {
+			printf("    #%02X%02X%02X%02X  rate %-3u  hold %ums\n", image[i+2], image[i+3], image[i+4], image[i+5],
+				   image[i], image[i+1]*HOLDMS);
+			i += BYTESPERSEQ;
+		}
+		if ((i >= size) || (image[i] != ENDMARK)) {
+			fprintf(stderr, "%s: sequence %d runs off the end of the image\n", name, s-1);
+			return 1;
+		}
+		i++;
+	}
+	if (i >= size) {
+		fprintf(stderr, "%s: no end of all data mark\n", name);
+		return 1;
+	}
+	return 0;
+}
+
+static char *ReadAll (const char *name) {
+	FILE *f = fopen(name, "rb");
+	char *text;
+	long size;
+
+	if (f == NULL) {
+		perror(name);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	rewind(f);
+	text = malloc(size + 1);
+	if ((text == NULL) || (fread(text, 1, size, f) != (size_t)size)) {
+		fprintf(stderr, "%s: cannot read\n", name);
+		exit(1);
+	}
+	text[size] = '\0';
+	fclose(f);
+	return text;
+}
+
+static void Usage (void) {
+	fprintf(stderr, "usage: showc [-o Sequences.inc] [-b image] [-x part] [-q] show\n"
+					"       showc -d image\n");
+	exit(2);
+}
+
+int main (int argc, char *argv[]) {
+	static unsigned char image[IMAGELIMIT];
+	const char *include = NULL, *raw = NULL, *part = NULL;
+	unsigned int size;
+	int opt, quiet = 0;
+	char *text, *p;
+
+	while ((opt = getopt(argc, argv, "o:b:x:qd:")) != -1) {
+		switch (opt) {
+		case 'o': include = optarg; break;
+		case 'b': raw = optarg; break;
+		case 'x': part = optarg; break;
+		case 'q': quiet = 1; break;
+		case 'd': return Decompile(optarg);
+		default: Usage();
+		}
+	}
+	if (optind != argc - 1) Usage();
+
+	sourceName = argv[optind];
+	text = ReadAll(sourceName);
+	for (p=text; isspace((unsigned char)*p); p++);
+	if (*p == '{') ParseJSON(text);
+	else ParseText(text);
+	Check();
+	if (errors) return 1;
+	ResolveFades();
+	size = Pack(image);
+	if (errors) return 1;
+
+	if (include) WriteInclude(include);
+	if (raw) WriteImage(raw, image, size);
+	if (part) WritePart(part, image, size);
+	if (!quiet) Report(size);
+	return 0;
+}
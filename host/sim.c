@@ -0,0 +1,506 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	sim.c
+* \details  A cycle-counted model of the parts of the PIC18F25K22 that the
+*			firmware uses: the oscillator and 4x PLL, Timer1, Timer2 and Timer4, the
+*			CCP PWM outputs, the EUSART, the data EEPROM, the HLVD module, the
+*			watchdog in sleep and the I/O ports.
+*
+*			Each register access is one instruction cycle.  A write is seen by
+*			the models at the following access, which is when the instruction
+*			after it would run on the part; the interrupt routine is entered
+*			between two accesses whenever an enabled interrupt is pending.  Code
+*			that only touches RAM takes no virtual time, so a loop that waits on
+*			a variable the interrupt routine sets has to contain a NOP().
+*/
+//************************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+#include "xc.h"
+
+#define LINEBAUD	(9600UL)						/*!< baud rate of the bus */
+#define LINEBIT		(HOST_UNITHZ/LINEBAUD)			/*!< units per bit on the bus */
+#define PLLLOCK		(HOST_UNITHZ/500)				/*!< 2mS PLL lock time */
+#define EEWRITE		(HOST_UNITHZ/250)				/*!< 4mS data EEPROM write cycle */
+#define WDTPERIOD	(HOST_UNITHZ/1000*128)			/*!< 128mS watchdog period */
+#define OSTDELAY	(1024*4)						/*!< crystal start-up after a sleep */
+#define MAXEEDATA	(32)							/*!< __EEPROM_DATA lines */
+
+unsigned char Host_EEPROM[HOST_EESIZE];
+int Host_EEPROMLoaded;
+HostCounts Host_Counts;
+void (*Host_OnFinish)(void);
+
+static unsigned char sfr[SFR_COUNT];	/*!< register contents */
+static const HostBoard *board;
+static HostTime now, endTime;
+static int last = -1;					/*!< register accessed by the last instruction */
+static unsigned char lastValue;			/*!< and its value before the access */
+static int inIsr;
+static int asleep;						/*!< SLEEP with the oscillator stopped */
+static int fast;						/*!< running on the PLL */
+static HostTime pllReady;
+
+static unsigned char pre1, pre2, post2, pre4, post4;	/*!< timer prescalers and postscalers */
+static unsigned int tmr1;				/*!< Timer1 count */
+static unsigned char tmr1Latch;			/*!< high byte latched by a 16-bit read of TMR1L */
+
+static unsigned char rxFifo[2], rxErr[2], rxCount;
+static int rxHave, rxActive, rxWake;
+static unsigned char rxNext, rxByte;	/*!< byte waiting on the line, byte being received */
+static HostTime rxStart, rxEnd, lineFree;
+static HostTime syncTime;				/*!< when the sync hook is due */
+
+static int txShifting, txFull;
+static unsigned char txShift, txBuf;
+static HostTime txEnd;
+
+static int eeBusy, unlock;
+static unsigned char eeAddr, eeData;
+static HostTime eeEnd;
+
+static HostTime wdtStart;
+static int wdtWake;
+
+static unsigned char sdaDevice = 1;		/*!< level the I2C devices pull SDA to */
+static unsigned char sclOut = 1, sdaOut = 1;
+static unsigned char duty[4];
+
+static struct { int line; unsigned char data[8]; } eeLines[MAXEEDATA];
+static int eeLineCount;
+
+HostTime Host_Now (void) {
+	return now;
+}
+
+void Host_EEData (int line, const unsigned char data[8]) {
+	if (eeLineCount == MAXEEDATA) return;
+	eeLines[eeLineCount].line = line;
+	memcpy(eeLines[eeLineCount].data, data, 8);
+	eeLineCount++;
+}
+
+static int ByLine (const void *a, const void *b) {
+	return *(const int *)a - *(const int *)b;
+}
+
+//********************************************************************************
+/**
+* \details  Power-on reset values for the modelled registers.
+*/
+//********************************************************************************
+void Host_Init (const HostBoard *parts, double seconds) {
+	int i;
+
+	board = parts;
+	endTime = (HostTime)(seconds * HOST_UNITHZ);
+	memset(sfr, 0, sizeof(sfr));
+	sfr[SFR_TRISA] = sfr[SFR_TRISB] = sfr[SFR_TRISC] = 0xFF;
+	sfr[SFR_ANSELA] = 0x2F; sfr[SFR_ANSELB] = 0x3F; sfr[SFR_ANSELC] = 0xFC;
+	sfr[SFR_WPUB] = 0xFF;
+	sfr[SFR_INTCON2] = 0xFF;
+	sfr[SFR_PIR1] = 0x10;					// TXIF
+	sfr[SFR_OSCCON] = 0x3C;					// OSTS: running from the crystal
+	sfr[SFR_PR2] = sfr[SFR_PR4] = sfr[SFR_PR6] = 0xFF;
+	sfr[SFR_TXSTA] = 0x02;					// TRMT
+	sfr[SFR_BAUDCON] = 0x40;				// RCIDL
+	sfr[SFR_RCON] = 0x1C;
+
+	if (!Host_EEPROMLoaded) {
+		memset(Host_EEPROM, 0xFF, sizeof(Host_EEPROM));
+		qsort(eeLines, eeLineCount, sizeof(eeLines[0]), ByLine);
+		for (i=0; i<eeLineCount && i*8<HOST_EESIZE; i++) memcpy(&Host_EEPROM[i*8], eeLines[i].data, 8);
+	}
+}
+
+void Host_Deadline (double seconds) {
+	endTime = now + (HostTime)(seconds * HOST_UNITHZ);
+}
+
+void Host_Finish (void) {
+	if (Host_OnFinish) Host_OnFinish();
+	exit(0);
+}
+
+//********************************************************************************
+/**
+* \details  Pin levels.  The firmware reads back the latch of an output; the
+*			inputs come from the board.
+*/
+//********************************************************************************
+static unsigned char Pins (unsigned char lat, unsigned char tris, unsigned char in) {
+	return (lat & ~tris) | (in & tris);
+}
+
+static void UpdateI2C (void) {
+	unsigned char scl = (sfr[SFR_TRISB] & 0x40) ? 1 : ((sfr[SFR_LATB] >> 6) & 1);
+	unsigned char sda = (sfr[SFR_TRISB] & 0x10) ? 1 : ((sfr[SFR_LATB] >> 4) & 1);
+
+	if ((scl == sclOut) && (sda == sdaOut)) return;
+	sclOut = scl; sdaOut = sda;
+	if (board->i2c) sdaDevice = board->i2c(scl, sda, now);
+}
+
+static void UpdatePWM (void) {
+	static const HostSFR con[4] = { SFR_CCP3CON, SFR_CCP1CON, SFR_CCP2CON, SFR_CCP4CON };
+	static const HostSFR reg[4] = { SFR_CCPR3L, SFR_CCPR1L, SFR_CCPR2L, SFR_CCPR4L };
+	unsigned char next[4];
+	int i;
+
+	for (i=0; i<4; i++) next[i] = ((sfr[con[i]] & 0x0C) == 0x0C) ? sfr[reg[i]] : 0;
+	if (memcmp(next, duty, sizeof(duty)) == 0) return;
+	memcpy(duty, next, sizeof(duty));
+	Host_Counts.pwmChanges++;
+	if (board->pwm) board->pwm(duty, now);
+}
+
+static HostTime BitTime (void) {
+	unsigned long divide = (sfr[SFR_TXSTA] & 0x04) ? 16 : 64;
+
+	return divide * (sfr[SFR_SPBRG] + 1UL) * (fast ? 1 : 4);
+}
+
+static void TxStart (unsigned char byte) {
+	txShift = byte;
+	txShifting = 1;
+	txEnd = now + 10*BitTime();
+	sfr[SFR_TXSTA] &= ~0x02;				// TRMT
+	if (board->line) board->line(byte, now, txEnd);
+}
+
+//********************************************************************************
+/**
+* \details  Acts on the write made by the previous instruction to \em reg.
+*/
+//********************************************************************************
+static void Settle (int reg) {
+	unsigned char value;
+
+	if (reg < 0) return;
+	value = sfr[reg];
+	switch (reg) {
+	case SFR_TXREG:
+		if (!(sfr[SFR_TXSTA] & 0x20)) break;
+		if (!txShifting) TxStart(value);
+		else if (!txFull) {
+			txBuf = value; txFull = 1;
+			sfr[SFR_PIR1] &= ~0x10;			// TXIF
+		}
+		break;
+	case SFR_EECON2:
+		if (value == 0x55) unlock = 1;
+		else if ((value == 0xAA) && (unlock == 1)) unlock = 2;
+		else unlock = 0;
+		return;
+	case SFR_EECON1:
+		if ((value & 0x01) && !(value & 0xC0)) {		// RD
+			sfr[SFR_EEDATA] = Host_EEPROM[sfr[SFR_EEADR]];
+			sfr[SFR_EECON1] &= ~0x01;
+		}
+		if ((value & 0x02) && !(lastValue & 0x02)) {	// WR
+			if ((value & 0x04) && (unlock == 2) && !(value & 0xC0) && !eeBusy) {
+				eeBusy = 1;
+				eeAddr = sfr[SFR_EEADR];
+				eeData = sfr[SFR_EEDATA];
+				eeEnd = now + EEWRITE;
+				Host_Counts.eeWrites++;
+			} else sfr[SFR_EECON1] &= ~0x02;			// refused
+		}
+		break;
+	case SFR_OSCTUNE:
+		if (!(value & 0x40)) {
+			fast = 0;
+			sfr[SFR_OSCCON2] &= ~0x80;				// PLLRDY
+		} else if (!(lastValue & 0x40)) pllReady = now + PLLLOCK;
+		break;
+	case SFR_HLVDCON:
+		if (value & 0x10) sfr[SFR_HLVDCON] |= 0x20;		// IRVST
+		else sfr[SFR_HLVDCON] &= ~0x20;
+		break;
+	case SFR_RCSTA:
+		if (!(value & 0x10)) sfr[SFR_RCSTA] &= ~0x02;	// clearing CREN clears OERR
+		break;
+	case SFR_LATB: case SFR_TRISB:
+		UpdateI2C();
+		break;
+	case SFR_CCP1CON: case SFR_CCP2CON: case SFR_CCP3CON: case SFR_CCP4CON:
+	case SFR_CCPR1L: case SFR_CCPR2L: case SFR_CCPR3L: case SFR_CCPR4L:
+		UpdatePWM();
+		break;
+	}
+	unlock = 0;
+}
+
+//********************************************************************************
+/**
+* \details  Timer2-style timers count instruction cycles.
+*/
+//********************************************************************************
+static void CountTimer (HostSFR con, HostSFR tmr, HostSFR pr, unsigned char *pre, unsigned char *post,
+						HostSFR pir, unsigned char flag) {
+	static const unsigned char prescale[4] = { 1, 4, 16, 16 };
+	unsigned char c = sfr[con];
+
+	if (!(c & 0x04)) return;
+	if (++*pre < prescale[c & 0x03]) return;
+	*pre = 0;
+	if (sfr[tmr] != sfr[pr]) {
+		sfr[tmr]++;
+		return;
+	}
+	sfr[tmr] = 0;
+	if (++*post > ((c >> 3) & 0x0F)) {
+		*post = 0;
+		sfr[pir] |= flag;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Timer1 runs free from the instruction clock.  Writes to the count
+*			are not modelled.
+*/
+//********************************************************************************
+static void CountTimer1 (void) {
+	static const unsigned char prescale[4] = { 1, 2, 4, 8 };
+	unsigned char c = sfr[SFR_T1CON];
+
+	if (!(c & 0x01) || (c & 0xC0)) return;
+	if (++pre1 < prescale[(c >> 4) & 0x03]) return;
+	pre1 = 0;
+	tmr1++;
+}
+
+// FERR belongs to the character at the top of the receive FIFO
+static void RxError (void) {
+	if (rxCount && rxErr[0]) sfr[SFR_RCSTA] |= 0x04;
+	else sfr[SFR_RCSTA] &= ~0x04;
+}
+
+static void Receive (void) {
+	HostTime start;
+
+	if (!rxHave && board->rx && board->rx(&rxNext, &start)) {
+		rxHave = 1;
+		rxStart = (start > lineFree) ? start : lineFree;
+	}
+	if (rxHave && !rxActive && (now >= rxStart)) {
+		rxHave = 0;
+		lineFree = rxStart + 10*LINEBIT;
+		if (asleep) {
+			// the start bit only wakes the part
+			if (sfr[SFR_BAUDCON] & 0x02) {
+				sfr[SFR_BAUDCON] &= ~0x02;
+				rxWake = 1;
+			}
+		} else if (((sfr[SFR_RCSTA] & 0x90) == 0x90) && !(sfr[SFR_RCSTA] & 0x02)) {
+			rxActive = 1;
+			rxByte = rxNext;
+			rxEnd = lineFree;
+			sfr[SFR_BAUDCON] &= ~0x40;			// RCIDL
+		}
+	}
+	if (rxActive && (now >= rxEnd)) {
+		HostTime bit = BitTime();
+		int framing = (bit*100 < LINEBIT*97) || (bit*100 > LINEBIT*103);
+
+		rxActive = 0;
+		sfr[SFR_BAUDCON] |= 0x40;
+		if (rxCount == 2) {
+			sfr[SFR_RCSTA] |= 0x02;				// OERR
+			Host_Counts.rxOverruns++;
+		} else {
+			rxFifo[rxCount] = framing ? (unsigned char)(rxByte ^ 0x55) : rxByte;
+			rxErr[rxCount] = framing;
+			rxCount++;
+			RxError();
+			Host_Counts.rxBytes++;
+			if (framing) Host_Counts.rxFraming++;
+		}
+	}
+	if (rxCount || rxWake) sfr[SFR_PIR1] |= 0x20;
+	else sfr[SFR_PIR1] &= ~0x20;
+}
+
+static void Transmit (void) {
+	if (!txShifting || (now < txEnd)) return;
+	Host_Counts.txBytes++;
+	if (board->tx) board->tx(txShift, now);
+	if (txFull) {
+		txFull = 0;
+		sfr[SFR_PIR1] |= 0x10;
+		TxStart(txBuf);
+	} else {
+		txShifting = 0;
+		sfr[SFR_TXSTA] |= 0x02;
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Advances everything by one instruction cycle.
+*/
+//********************************************************************************
+static void Step (void) {
+	now += fast ? 4 : 16;
+	if (now >= endTime) Host_Finish();
+	if (board->sync && (now >= syncTime)) syncTime = board->sync(now);
+	Host_Counts.cycles++;
+
+	if (!asleep) {
+		CountTimer1();
+		CountTimer(SFR_T2CON, SFR_TMR2, SFR_PR2, &pre2, &post2, SFR_PIR1, 0x02);
+		CountTimer(SFR_T4CON, SFR_TMR4, SFR_PR4, &pre4, &post4, SFR_PIR5, 0x01);
+		Transmit();
+		if ((sfr[SFR_OSCTUNE] & 0x40) && !fast && (now >= pllReady)) {
+			fast = 1;
+			sfr[SFR_OSCCON2] |= 0x80;
+		}
+	}
+	Receive();
+	if (eeBusy && (now >= eeEnd)) {
+		Host_EEPROM[eeAddr] = eeData;
+		eeBusy = 0;
+		sfr[SFR_EECON1] &= ~0x02;
+		sfr[SFR_PIR2] |= 0x10;					// EEIF
+	}
+	if ((sfr[SFR_WDTCON] & 0x01) && (now - wdtStart >= WDTPERIOD)) {
+		wdtStart = now;
+		if (asleep) wdtWake = 1;
+		else fprintf(stderr, "sim: watchdog reset ignored at %.3fs\n", (double)now/HOST_UNITHZ);
+	}
+}
+
+static int Pending (void) {
+	return (sfr[SFR_PIR1] & sfr[SFR_PIE1] & 0x32) || (sfr[SFR_PIR2] & sfr[SFR_PIE2] & 0x14) ||
+		   (sfr[SFR_PIR5] & sfr[SFR_PIE5] & 0x01);
+}
+
+static void Dispatch (void) {
+	if (inIsr || !(sfr[SFR_INTCON] & 0x80) || !(sfr[SFR_INTCON] & 0x40) || !Pending()) return;
+	inIsr = 1;
+	sfr[SFR_INTCON] &= ~0x80;
+	Host_Counts.interrupts++;
+	Step(); Step();						// vectoring
+	high_isr();
+	Settle(last);
+	last = -1;
+	sfr[SFR_INTCON] |= 0x80;			// RETFIE
+	inIsr = 0;
+}
+
+//********************************************************************************
+/**
+* \details  Register access.  The previous write is settled, a cycle passes,
+*			a pending interrupt is taken and the value to be read is set up.
+*/
+//********************************************************************************
+volatile unsigned char *Host_Access (HostSFR reg) {
+	unsigned char pressed;
+
+	Settle(last);
+	last = -1;
+	Step();
+	Dispatch();
+	switch (reg) {
+	case SFR_PORTA:
+		pressed = board->buttons ? board->buttons(now) : 0;
+		sfr[reg] = Pins(sfr[SFR_LATA], sfr[SFR_TRISA],
+					   (~pressed & 0x03) | ((board->night && board->night(now)) ? 0x10 : 0) | 0xEC);
+		break;
+	case SFR_PORTB:
+		pressed = board->buttons ? board->buttons(now) : 0;
+		sfr[reg] = Pins(sfr[SFR_LATB], sfr[SFR_TRISB],
+					   ((~pressed >> 2) & 0x0F) | ((sdaOut & sdaDevice) << 4) | 0x20 | (sclOut << 6) | 0x80);
+		break;
+	case SFR_PORTC:
+		sfr[reg] = Pins(sfr[SFR_LATC], sfr[SFR_TRISC], 0xFF);
+		break;
+	case SFR_TMR1L:
+		sfr[reg] = (unsigned char)tmr1;
+		tmr1Latch = (unsigned char)(tmr1 >> 8);
+		break;
+	case SFR_TMR1H:
+		sfr[reg] = (sfr[SFR_T1CON] & 0x02) ? tmr1Latch : (unsigned char)(tmr1 >> 8);
+		break;
+	case SFR_RCREG:
+		if (rxCount) {
+			sfr[reg] = rxFifo[0];
+			rxFifo[0] = rxFifo[1]; rxErr[0] = rxErr[1];
+			rxCount--;
+			RxError();
+		} else {
+			sfr[reg] = 0;
+			rxWake = 0;
+		}
+		if (!rxCount && !rxWake) sfr[SFR_PIR1] &= ~0x20;
+		break;
+	default:
+		break;
+	}
+	last = reg;
+	lastValue = sfr[reg];
+	return &sfr[reg];
+}
+
+void Host_Cycles (unsigned long cycles) {
+	Settle(last);
+	last = -1;
+	while (cycles-- > 0) {
+		Step();
+		Dispatch();
+	}
+}
+
+void Host_ClearWatchdog (void) {
+	wdtStart = now;
+}
+
+//********************************************************************************
+/**
+* \details  SLEEP: with IDLEN set only the core stops; otherwise the oscillator
+*			stops too and only the UART wake-up, the EEPROM, the HLVD and the
+*			watchdog carry on.  Any enabled interrupt flag wakes the part.
+*/
+//********************************************************************************
+void Host_Sleep (void) {
+	Settle(last);
+	last = -1;
+	wdtStart = now;
+	asleep = !(sfr[SFR_OSCCON] & 0x80);
+	if (asleep) {
+		fast = 0;						// the PLL has to lock again
+		sfr[SFR_OSCCON2] &= ~0x80;
+	}
+	while (!Pending() && !wdtWake) {
+		Step();
+		Host_Counts.idle++;
+	}
+	if (asleep) {
+		asleep = 0;
+		pllReady = now + PLLLOCK;
+		now += OSTDELAY;
+	}
+	wdtWake = 0;
+	Dispatch();
+}
+
+unsigned char eeprom_read (unsigned char address) {
+	while (eeBusy) Host_Cycles(1);
+	return Host_EEPROM[address];
+}
+
+void eeprom_write (unsigned char address, unsigned char value) {
+	while (eeBusy) Host_Cycles(1);
+	eeBusy = 1;
+	eeAddr = address;
+	eeData = value;
+	eeEnd = now + EEWRITE;
+	Host_Counts.eeWrites++;
+}
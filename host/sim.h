@@ -0,0 +1,118 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	sim.h
+* \details  Interface of the PIC18F25K22 simulator that the host build of the
+*			firmware runs on.  Virtual time is counted in periods of the 4x PLL
+*			clock, so one instruction cycle is 16 units on the crystal and 4
+*			units on the PLL.
+*/ 
+//************************************************************************************
+#ifndef _HOST_SIM_H_
+#define _HOST_SIM_H_
+
+#include <stdio.h>
+
+#define HOST_CRYSTAL	(3686400UL)				/*!< crystal frequency in Hz */
+#define HOST_UNITHZ		(4*HOST_CRYSTAL)		/*!< virtual time units per second */
+#define HOST_EESIZE		(256)					/*!< bytes of data EEPROM */
+
+typedef unsigned long long HostTime;			/*!< virtual time in units */
+
+// Special function registers the firmware uses
+typedef enum _HostSFR {
+	SFR_PORTA, SFR_PORTB, SFR_PORTC, SFR_LATA, SFR_LATB, SFR_LATC,
+	SFR_TRISA, SFR_TRISB, SFR_TRISC, SFR_ANSELA, SFR_ANSELB, SFR_ANSELC, SFR_WPUB,
+	SFR_INTCON, SFR_INTCON2, SFR_PIR1, SFR_PIE1, SFR_PIR2, SFR_PIE2, SFR_PIR5, SFR_PIE5,
+	SFR_RCON, SFR_OSCCON, SFR_OSCCON2, SFR_OSCTUNE,
+	SFR_T1CON, SFR_TMR1L, SFR_TMR1H, SFR_T2CON, SFR_PR2, SFR_TMR2,
+	SFR_T4CON, SFR_PR4, SFR_TMR4, SFR_T6CON, SFR_PR6, SFR_TMR6,
+	SFR_CCP1CON, SFR_CCP2CON, SFR_CCP3CON, SFR_CCP4CON,
+	SFR_CCPR1L, SFR_CCPR2L, SFR_CCPR3L, SFR_CCPR4L, SFR_CCPTMRS0, SFR_CCPTMRS1,
+	SFR_FVRCON, SFR_HLVDCON, SFR_WDTCON,
+	SFR_EECON1, SFR_EECON2, SFR_EEADR, SFR_EEDATA,
+	SFR_RCSTA, SFR_TXSTA, SFR_BAUDCON, SFR_SPBRG, SFR_SPBRGH, SFR_RCREG, SFR_TXREG,
+	SFR_COUNT
+} HostSFR;
+
+// External parts on the board.  Each hook is optional.
+typedef struct _HostBoard {
+	// I2C bus: called whenever SCL or SDA as driven by the firmware changes;
+	// returns the level the devices pull SDA to (1 = released)
+	unsigned char (*i2c)(unsigned char scl, unsigned char sda, HostTime now);
+	// PWM outputs: called with the four channel duties after any change
+	void (*pwm)(const unsigned char duty[4], HostTime now);
+	// UART: a byte has been transmitted
+	void (*tx)(unsigned char byte, HostTime now);
+	// UART: the next byte to send to the firmware and when to start it;
+	// returns 0 once there is nothing more to send
+	int (*rx)(unsigned char *byte, HostTime *start);
+	// inputs: active-low levels of RA0, RA1, RB0-RB3 in firmware mask order
+	// and of the RA4 night sensor
+	unsigned char (*buttons)(HostTime now);
+	unsigned char (*night)(HostTime now);
+	// UART: 'byte' has started to shift out and is on the line until 'end'
+	void (*line)(unsigned char byte, HostTime start, HostTime end);
+	// called once virtual time reaches the time it returned last, first at
+	// the first instruction; lets a front end keep the run in step with
+	// other simulators or the wall clock
+	HostTime (*sync)(HostTime now);
+} HostBoard;
+
+typedef struct _HostCounts {
+	unsigned long long cycles;		/*!< instruction cycles executed */
+	unsigned long long idle;		/*!< instruction cycles spent in SLEEP */
+	unsigned long interrupts;		/*!< interrupts serviced */
+	unsigned long txBytes, rxBytes;	/*!< UART bytes each way */
+	unsigned long rxOverruns;		/*!< bytes lost to a full receive FIFO */
+	unsigned long rxFraming;		/*!< bytes received at the wrong baud rate */
+	unsigned long eeWrites;			/*!< data EEPROM write cycles */
+	unsigned long pwmChanges;		/*!< PWM duty changes */
+} HostCounts;
+
+// Register access; advances the virtual clock by one instruction cycle
+extern volatile unsigned char *Host_Access (HostSFR sfr);
+
+// Busy-waits 'cycles' instruction cycles with the interrupts serviced
+extern void Host_Cycles (unsigned long cycles);
+
+// SLEEP instruction
+extern void Host_Sleep (void);
+
+// CLRWDT instruction
+extern void Host_ClearWatchdog (void);
+
+// Initial data EEPROM contents from __EEPROM_DATA at source line 'line'
+extern void Host_EEData (int line, const unsigned char data[8]);
+
+// Starts the simulator with the 'board' parts; runs for 'seconds' of virtual time
+extern void Host_Init (const HostBoard *board, double seconds);
+
+// Virtual time now
+extern HostTime Host_Now (void);
+
+// Moves the end of the run to 'seconds' of virtual time from now
+extern void Host_Deadline (double seconds);
+
+// Data EEPROM image; loaded before and saved after a run
+extern unsigned char Host_EEPROM[HOST_EESIZE];
+extern int Host_EEPROMLoaded;
+
+// Activity counters
+extern HostCounts Host_Counts;
+
+// Called when the run time is up; never returns
+extern void Host_Finish (void);
+
+// Registered by the front end to save results before the process exits
+extern void (*Host_OnFinish)(void);
+
+// Firmware entry points
+extern unsigned char Firmware_main (void);
+extern void high_isr (void);
+
+#endif
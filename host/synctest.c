@@ -0,0 +1,74 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	synctest.c
+* \details  Checks that \em Timer_Sync corrects the tick in the right direction
+*			for offsets either side of what the slew can hold.  The part keeps
+*			the slew in a 16-bit int while the host's is 32 bits, so the
+*			correction is added up as the part would see it: the ticks stepped
+*			plus the slew cut to 16 bits.
+*
+*			  sync-test
+*
+*			Prints one line per offset and exits with 1 if any is wrong.
+*/
+//************************************************************************************
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Timer.h"
+
+#define SLACK		(TIMER_TICKCOUNTS+16)	/*!< a tick and a few periods may pass during a call */
+
+extern void ConfigureOscillator (void);
+extern void InitApp (void);
+
+static const long offsets[] = { 40000L, -40000L, 57599L, -57599L, 32767L, -32767L, 1000L, -1000L, 100000L };
+
+static unsigned char Night (HostTime now) {
+	(void)now;
+	return 1;
+}
+
+// Syncs to a master 'offset' phase counts ahead and returns the correction made
+static long Correction (long offset) {
+	unsigned long tick = Timer_Ticks;
+	long ticks = (offset > 0) ? (offset + TIMER_TICKCOUNTS - 1) / TIMER_TICKCOUNTS : offset / TIMER_TICKCOUNTS;
+	unsigned long master = tick + ticks;
+	unsigned int phase = (unsigned int)(ticks * TIMER_TICKCOUNTS - offset);
+	int total, remaining;
+
+	Timer_Sync(master, tick, phase);
+	Timer_GetSync(&total, &remaining);
+	return (long)(Timer_Ticks - tick) * TIMER_TICKCOUNTS + (int16_t)remaining;
+}
+
+int main (void) {
+	static HostBoard board = { EE24_Bus, NULL, NULL, NULL, NULL, Night };
+	long correction;
+	unsigned int i;
+	int failed = 0, bad;
+
+	memset(EE24_Memory, 0xFF, sizeof(EE24_Memory));
+	Host_Init(&board, 1e6);
+	ConfigureOscillator();
+	InitApp();
+	Timer_Sync(Timer_Ticks, Timer_Ticks, 0);			// the first sync always steps
+
+	for (i=0; i<sizeof(offsets)/sizeof(offsets[0]); i++) {
+		correction = Correction(offsets[i]);
+		bad = ((correction > 0) != (offsets[i] > 0)) || (labs(correction - offsets[i]) > SLACK);
+		printf("offset %7ld: corrected %7ld %s\n", offsets[i], correction, bad ? "FAIL" : "ok");
+		failed |= bad;
+		Correction(-correction);						// back where it was
+	}
+	printf(failed ? "FAIL\n" : "PASS\n");
+	return failed;
+}
@@ -0,0 +1,369 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	tracecheck.c
+* \details  Checks a trace of the PWM outputs against the timeline the sequence
+*			data gives.  The trace is either the CSV of level changes written
+*			by \em sbus-sim \em -p or, with \em -s, the replies to STATS page
+*			0004 read from a node built with TRACE.  The image is a raw sequence
+*			image or a whole 24LC256 image.
+*
+*			  tracecheck [-n first[-last]] [-i r,g,b,w] [-t ticks] [-l] [-s] image trace
+*
+*			The sequences from \em first to \em last (all of them by default)
+*			are played as the PWM tick runs them, from the levels given by \em -i
+*			(all off by default), with each segment following the previous hold
+*			without a gap.  The trace is lined up with the longest run of
+*			matching levels it has in that timeline, so it may start anywhere in
+*			the show; changes before that are skipped.  From there every change
+*			must have the expected levels, and for each segment the fade, from
+*			its first level step to its last, and the hold, from its last step
+*			to the first step of the next segment that changes anything, must
+*			be within \em -t ticks (default 1) of the expected times.  Holds
+*			include the time the player takes to start the next segment.  The
+*			exit status is 0 if the trace matches, 1 if it does not.
+*
+*			\em -l lists every segment checked.  A STATS reply that reports
+*			lost changes starts a new run that is lined up again.
+*/
+//************************************************************************************
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "i2ceeprom.h"
+#include "Sequences.h"
+
+#define TICKMS		(5)						/*!< system tick */
+#define ALIGNMAX	(4096)					/*!< trace changes that may be skipped */
+#define MAXSEQS		(EEMAX)
+
+typedef struct _Event {
+	long tick;
+	unsigned char level[4];
+	int sequence, segment;					/*!< expected events only */
+	int first, last;						/*!< first or last level step of the segment */
+} Event;
+
+typedef struct _Events {
+	Event *items;
+	long count, size;
+} Events;
+
+static unsigned char image[EE24_BYTES];
+static long imageSize;
+static long starts[MAXSEQS+1];				/*!< offset of each sequence */
+static int seqCount;
+static int firstSeq, lastSeq = -1;
+static unsigned char startLevel[4];
+static long tolerance = 1;
+static int list, sbus;
+static long segmentsChecked, changesChecked, failures;
+static long worstFade, worstHold;
+
+static void Fail (const char *message, const char *detail) {
+	fprintf(stderr, "tracecheck: %s%s\n", message, detail ? detail : "");
+	exit(2);
+}
+
+static void Add (Events *e, const Event *event) {
+	if (e->count == e->size) {
+		e->size = e->size ? 2*e->size : 1024;
+		if ((e->items = realloc(e->items, e->size * sizeof(Event))) == NULL) Fail("out of memory", NULL);
+	}
+	e->items[e->count++] = *event;
+}
+
+static void LoadImage (const char *name) {
+	FILE *f = fopen(name, "rb");
+	long i;
+
+	if (f == NULL) { perror(name); exit(2); }
+	imageSize = (long)fread(image, 1, sizeof(image), f);
+	fclose(f);
+
+	// sequences end with ENDMARK and the image with a second one
+	for (i=0; (i < imageSize) && (image[i] != ENDMARK); ) {
+		if (seqCount == MAXSEQS) Fail("too many sequences in ", name);
+		starts[seqCount++] = i;
+		while ((i < imageSize) && (image[i] != ENDMARK)) i += BYTESPERSEQ;
+		if (i >= imageSize) Fail("no end mark in ", name);
+		i++;
+	}
+	if (seqCount == 0) Fail("no sequences in ", name);
+	starts[seqCount] = i;
+}
+
+//********************************************************************************
+/**
+* \details  Plays one segment as the PWM tick does, from the tick the segment
+*			is started after, and adds its level changes.  Returns the tick its
+*			hold runs out on, after which the next segment starts.
+*/
+//********************************************************************************
+static long Play (Events *e, long tick, unsigned char level[4], const unsigned char *g, int seq, int seg) {
+	unsigned int rate = g[0], counter = g[0], hold = 10 * (unsigned int)g[1], done, i;
+	int fading = 1, first = 1;
+	Event event;
+
+	memset(&event, 0, sizeof(event));
+	event.sequence = seq; event.segment = seg;
+	for (;;) {
+		tick++;
+		if (fading) {
+			if (counter == 0) {
+				done = 0;
+				for (i=0; i<4; i++) {
+					if (level[i] < g[2+i]) level[i]++;
+					else if (level[i] > g[2+i]) level[i]--;
+					else done++;
+				}
+				if (done == 4) {
+					if (!first) e->items[e->count-1].last = 1;
+					counter = hold;
+					fading = 0;
+				} else {
+					event.tick = tick;
+					memcpy(event.level, level, 4);
+					event.first = first;
+					first = 0;
+					Add(e, &event);
+					counter = rate;
+				}
+			}
+		} else if (counter == 0) return tick;
+		if (counter > 0) counter--;
+	}
+}
+
+// Plays the sequence range from the start levels until at least 'needed' changes
+static void Expect (Events *e, long needed) {
+	unsigned char level[4];
+	long tick = 0, i, cycle = 0;
+	int s, seg;
+
+	memcpy(level, startLevel, 4);
+	for (;;) {
+		for (s=firstSeq; s<=lastSeq; s++) {
+			for (i=starts[s], seg=0; image[i] != ENDMARK; i+=BYTESPERSEQ, seg++)
+				tick = Play(e, tick, level, &image[i], s, seg);
+		}
+		if (cycle == 0) cycle = e->count;
+		if ((cycle == 0) || (e->count >= needed + cycle)) return;
+	}
+}
+
+static int Hex (const char *p, int digits, unsigned long *value) {
+	*value = 0;
+	while (digits-- > 0) {
+		if (!isxdigit((unsigned char)*p)) return 0;
+		*value = (*value << 4) | (isdigit((unsigned char)*p) ? *p - '0' : (toupper((unsigned char)*p) - 'A' + 10));
+		p++;
+	}
+	return 1;
+}
+
+//********************************************************************************
+/**
+* \details  Reads the trace into runs of changes without a gap.  The 16-bit
+*			tick stamps of the STATS entries are unwrapped.
+*/
+//********************************************************************************
+static int LoadTrace (const char *name, Events runs[], int maxRuns) {
+	FILE *f = fopen(name, "r");
+	char line[4096];
+	int count = 0, n, k;
+	unsigned long value, entries, lost, stamp;
+	unsigned char level[4];
+	unsigned int c[4];
+	long tick = 0, lineNo = 0;
+	unsigned int lastStamp = 0;
+	double seconds;
+	const char *p;
+	Event event;
+
+	if (f == NULL) { perror(name); exit(2); }
+	memset(&event, 0, sizeof(event));
+	if (!sbus) count = 1;
+	while (fgets(line, sizeof(line), f)) {
+		lineNo++;
+		if (!sbus) {
+			if (sscanf(line, "%lf,%u,%u,%u,%u", &seconds, &c[0], &c[1], &c[2], &c[3]) != 5) continue;
+			event.tick = (long)(seconds * 1000.0 / TICKMS);
+			for (k=0; k<4; k++) event.level[k] = c[k];
+			// the simulator sees each duty cycle register written; the tick sets all four
+			if ((runs[0].count > 0) && (runs[0].items[runs[0].count-1].tick == event.tick))
+				runs[0].items[runs[0].count-1] = event;
+			else Add(&runs[0], &event);
+			continue;
+		}
+
+		// :IIF00004 NN LLLL then NN entries of TTTT R G B W
+		if ((p = strchr(line, ':')) == NULL) continue;
+		if (!Hex(p+3, 2, &value) || (value != 0xF0) || !Hex(p+5, 4, &value) || (value != 0x0004)) continue;
+		p += 9;
+		if (!Hex(p, 2, &entries) || !Hex(p+2, 4, &lost)) {
+			fprintf(stderr, "%s:%ld: not a trace page\n", name, lineNo);
+			exit(2);
+		}
+		p += 6;
+		if ((count == 0) || (lost > 0)) {
+			if (count == maxRuns) Fail("too many gaps in ", name);
+			if (count > 0) fprintf(stderr, "%s:%ld: %lu changes lost, lining up again\n", name, lineNo, lost);
+			count++;
+			tick = 0;
+		}
+		for (n=0; n<(int)entries; n++, p+=12) {
+			if (!Hex(p, 4, &stamp)) {
+				fprintf(stderr, "%s:%ld: short trace page\n", name, lineNo);
+				exit(2);
+			}
+			for (k=0; k<4; k++) {
+				Hex(p+4+2*k, 2, &value);
+				level[k] = (unsigned char)value;
+			}
+			if (runs[count-1].count == 0) tick = stamp;
+			else tick += (unsigned int)((unsigned int)stamp - lastStamp) & 0xFFFF;
+			lastStamp = stamp;
+			event.tick = tick;
+			memcpy(event.level, level, 4);
+			Add(&runs[count-1], &event);
+		}
+	}
+	fclose(f);
+	return count;
+}
+
+static long Match (const Events *actual, long a, const Events *expected, long p) {
+	long n = 0;
+
+	while ((a + n < actual->count) && (p + n < expected->count) &&
+		   (memcmp(actual->items[a+n].level, expected->items[p+n].level, 4) == 0)) n++;
+	return n;
+}
+
+static void Report (const Event *g, const char *what, long got, long want) {
+	long error = got - want;
+
+	if (error < 0) error = -error;
+	if (error > tolerance) failures++;
+	if (list || (error > tolerance)) {
+		printf("  seq %3d segment %2d  %-4s %8ldms expected %8ldms%s\n", g->sequence, g->segment, what,
+			   got*TICKMS, want*TICKMS, (error > tolerance) ? "  FAIL" : "");
+	}
+}
+
+//********************************************************************************
+/**
+* \details  Lines a run up with the expected changes and compares the levels
+*			and the segment times.
+*/
+//********************************************************************************
+static void Check (const Events *actual, const Events *expected, int run) {
+	long a, p, n, best = 0, bestA = 0, bestP = 0, limit, i, fadeStart = -1, fade, want;
+	const Event *x, *y;
+
+	if (actual->count == 0) return;
+	limit = (actual->count - 1 < ALIGNMAX) ? actual->count - 1 : ALIGNMAX;
+	for (a=0; (a <= limit) && (best < actual->count - a); a++) {
+		for (p=0; p<expected->count; p++) {
+			n = Match(actual, a, expected, p);
+			if (n > best) { best = n; bestA = a; bestP = p; }
+			if (best == actual->count - a) break;
+		}
+	}
+	if (best == 0) {
+		printf("run %d: none of the %ld changes are in the show\n", run, actual->count);
+		failures++;
+		return;
+	}
+	printf("run %d: %ld changes from %.3fs, lined up with sequence %d segment %d", run, actual->count,
+		   (double)actual->items[bestA].tick * TICKMS / 1000.0, expected->items[bestP].sequence,
+		   expected->items[bestP].segment);
+	if (bestA > 0) printf(" after skipping %ld", bestA);
+	printf("\n");
+
+	for (i=0; i<best; i++) {
+		x = &expected->items[bestP + i];
+		y = &actual->items[bestA + i];
+		// segments are timed from their first step, so one the trace starts in is skipped
+		if (x->first) fadeStart = i;
+		if (x->last && (fadeStart >= 0) && (i + 1 < best)) {
+			fade = y->tick - actual->items[bestA + fadeStart].tick;
+			want = x->tick - expected->items[bestP + fadeStart].tick;
+			Report(x, "fade", fade, want);
+			if (labs(fade - want) > labs(worstFade)) worstFade = fade - want;
+			fade = actual->items[bestA + i + 1].tick - y->tick;
+			want = expected->items[bestP + i + 1].tick - x->tick;
+			Report(x, "hold", fade, want);
+			if (labs(fade - want) > labs(worstHold)) worstHold = fade - want;
+			segmentsChecked++;
+		}
+	}
+	changesChecked += best;
+	if (bestA + best < actual->count) {
+		y = &actual->items[bestA + best];
+		printf("  change %ld at %.3fs to %u,%u,%u,%u is not in the show", bestA + best,
+			   (double)y->tick * TICKMS / 1000.0, y->level[0], y->level[1], y->level[2], y->level[3]);
+		if (bestP + best < expected->count) {
+			x = &expected->items[bestP + best];
+			printf(": expected %u,%u,%u,%u (sequence %d segment %d)", x->level[0], x->level[1], x->level[2],
+				   x->level[3], x->sequence, x->segment);
+		}
+		printf("  FAIL\n");
+		failures++;
+	}
+}
+
+static void Usage (void) {
+	fprintf(stderr, "usage: tracecheck [-n first[-last]] [-i r,g,b,w] [-t ticks] [-l] [-s] image trace\n");
+	exit(2);
+}
+
+int main (int argc, char *argv[]) {
+	static Events runs[64];
+	Events expected;
+	unsigned int c[4];
+	long longest = 0;
+	int opt, count, r, k;
+
+	while ((opt = getopt(argc, argv, "n:i:t:ls")) != -1) {
+		switch (opt) {
+		case 'n':
+			if ((k = sscanf(optarg, "%d-%d", &firstSeq, &lastSeq)) < 1) Usage();
+			if (k == 1) lastSeq = firstSeq;
+			break;
+		case 'i':
+			if (sscanf(optarg, "%u,%u,%u,%u", &c[0], &c[1], &c[2], &c[3]) != 4) Usage();
+			for (k=0; k<4; k++) startLevel[k] = c[k];
+			break;
+		case 't': tolerance = atol(optarg); break;
+		case 'l': list = 1; break;
+		case 's': sbus = 1; break;
+		default: Usage();
+		}
+	}
+	if (argc - optind != 2) Usage();
+
+	LoadImage(argv[optind]);
+	if (lastSeq < 0) lastSeq = seqCount - 1;
+	if ((firstSeq < 0) || (lastSeq >= seqCount) || (firstSeq > lastSeq)) Fail("no such sequences in ", argv[optind]);
+	count = LoadTrace(argv[optind+1], runs, sizeof(runs)/sizeof(runs[0]));
+	for (r=0; r<count; r++) if (runs[r].count > longest) longest = runs[r].count;
+
+	memset(&expected, 0, sizeof(expected));
+	Expect(&expected, longest + ALIGNMAX);
+	if (expected.count == 0) Fail("the sequences never change the outputs", NULL);
+	for (r=0; r<count; r++) Check(&runs[r], &expected, r);
+
+	printf("%ld changes and %ld segments checked, worst fade error %+ldms, worst hold error %+ldms: %s\n",
+		   changesChecked, segmentsChecked, worstFade*TICKMS, worstHold*TICKMS,
+		   ((failures == 0) && (changesChecked > 0)) ? "PASS" : "FAIL");
+	return ((failures == 0) && (changesChecked > 0)) ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+//************************************************************************************
+//
+// This source is Copyright (c) 2011 by Computer Inspirations.  All rights reserved.
+// You are permitted to modify and use this code for personal use only.
+//
+//************************************************************************************
+/**
+* \file   	xc.h
+* \details  Host stand-in for the XC8 device header of the PIC18F25K22.  Every
+*			special function register the firmware uses is a byte in the
+*			simulator and every access to one goes through \em Host_Access,
+*			which advances the virtual clock by one instruction cycle, lets
+*			the peripheral models see the previous write, and services any
+*			interrupt that is due.  The firmware sources therefore build
+*			unchanged with gcc or clang.
+*
+*			A bit that the firmware names on its own (\em TMR4IF) must not
+*			also be named through its register (\em PIR5bits.TMR4IF) since the
+*			short names are macros here rather than XC8 bit variables.
+*/ 
+//************************************************************************************
+#ifndef _HOST_XC_H_
+#define _HOST_XC_H_
+
+#include "sim.h"
+
+#define HOST_REG(r)		(*(volatile unsigned char *)Host_Access(SFR_##r))
+#define HOST_BITS(r)	(*(volatile r##bits_t *)Host_Access(SFR_##r))
+
+typedef struct {
+	unsigned char RA0:1, RA1:1, RA2:1, RA3:1, RA4:1, RA5:1, RA6:1, RA7:1;
+} PORTAbits_t;
+typedef struct {
+	unsigned char RB0:1, RB1:1, RB2:1, RB3:1, RB4:1, RB5:1, RB6:1, RB7:1;
+} PORTBbits_t;
+typedef struct {
+	unsigned char RC0:1, RC1:1, RC2:1, RC3:1, RC4:1, RC5:1, RC6:1, RC7:1;
+} PORTCbits_t;
+typedef struct {
+	unsigned char LATA0:1, LATA1:1, LATA2:1, LATA3:1, LATA4:1, LATA5:1, LATA6:1, LATA7:1;
+} LATAbits_t;
+typedef struct {
+	unsigned char LATB0:1, LATB1:1, LATB2:1, LATB3:1, LATB4:1, LATB5:1, LATB6:1, LATB7:1;
+} LATBbits_t;
+typedef struct {
+	unsigned char LATC0:1, LATC1:1, LATC2:1, LATC3:1, LATC4:1, LATC5:1, LATC6:1, LATC7:1;
+} LATCbits_t;
+typedef struct {
+	unsigned char TRISA0:1, TRISA1:1, TRISA2:1, TRISA3:1, TRISA4:1, TRISA5:1, TRISA6:1, TRISA7:1;
+} TRISAbits_t;
+typedef struct {
+	unsigned char TRISB0:1, TRISB1:1, TRISB2:1, TRISB3:1, TRISB4:1, TRISB5:1, TRISB6:1, TRISB7:1;
+} TRISBbits_t;
+typedef struct {
+	unsigned char TRISC0:1, TRISC1:1, TRISC2:1, TRISC3:1, TRISC4:1, TRISC5:1, TRISC6:1, TRISC7:1;
+} TRISCbits_t;
+typedef struct {
+	unsigned char WPUB0:1, WPUB1:1, WPUB2:1, WPUB3:1, WPUB4:1, WPUB5:1, WPUB6:1, WPUB7:1;
+} WPUBbits_t;
+typedef struct {
+	unsigned char RBIF:1, INT0IF:1, TMR0IF:1, RBIE:1, INT0IE:1, TMR0IE:1, PEIE:1, GIE:1;
+} INTCONbits_t;
+typedef struct {
+	unsigned char RBIP:1, :1, TMR0IP:1, :1, INTEDG2:1, INTEDG1:1, INTEDG0:1, RBPU:1;
+} INTCON2bits_t;
+typedef struct {
+	unsigned char TMR1IF:1, TMR2IF:1, CCP1IF:1, SSP1IF:1, TXIF:1, RCIF:1, ADIF:1, :1;
+} PIR1bits_t;
+typedef struct {
+	unsigned char TMR1IE:1, TMR2IE:1, CCP1IE:1, SSP1IE:1, TXIE:1, RCIE:1, ADIE:1, :1;
+} PIE1bits_t;
+typedef struct {
+	unsigned char CCP2IF:1, TMR3IF:1, HLVDIF:1, BCL1IF:1, EEIF:1, C2IF:1, C1IF:1, OSCFIF:1;
+} PIR2bits_t;
+typedef struct {
+	unsigned char CCP2IE:1, TMR3IE:1, HLVDIE:1, BCL1IE:1, EEIE:1, C2IE:1, C1IE:1, OSCFIE:1;
+} PIE2bits_t;
+typedef struct {
+	unsigned char TMR4IF:1, TMR5IF:1, TMR6IF:1, :5;
+} PIR5bits_t;
+typedef struct {
+	unsigned char TMR4IE:1, TMR5IE:1, TMR6IE:1, :5;
+} PIE5bits_t;
+typedef struct {
+	unsigned char BOR:1, POR:1, PD:1, TO:1, RI:1, :1, SBOREN:1, IPEN:1;
+} RCONbits_t;
+typedef struct {
+	unsigned char SCS:2, HFIOFS:1, OSTS:1, IRCF:3, IDLEN:1;
+} OSCCONbits_t;
+typedef struct {
+	unsigned char LFIOFS:1, MFIOFS:1, PRISD:1, SOSCGO:1, MFIOSEL:1, :1, SOSCRUN:1, PLLRDY:1;
+} OSCCON2bits_t;
+typedef struct {
+	unsigned char TUN:6, PLLEN:1, INTSRC:1;
+} OSCTUNEbits_t;
+typedef struct {
+	unsigned char T2CKPS:2, TMR2ON:1, T2OUTPS:4, :1;
+} T2CONbits_t;
+typedef struct {
+	unsigned char T4CKPS:2, TMR4ON:1, T4OUTPS:4, :1;
+} T4CONbits_t;
+typedef struct {
+	unsigned char T6CKPS:2, TMR6ON:1, T6OUTPS:4, :1;
+} T6CONbits_t;
+typedef struct {
+	unsigned char TMR1ON:1, T1RD16:1, T1SYNC:1, T1SOSCEN:1, T1CKPS:2, TMR1CS:2;
+} T1CONbits_t;
+typedef struct {
+	unsigned char CCP1M:4, DC1B:2, P1M:2;
+} CCP1CONbits_t;
+typedef struct {
+	unsigned char CCP2M:4, DC2B:2, P2M:2;
+} CCP2CONbits_t;
+typedef struct {
+	unsigned char CCP3M:4, DC3B:2, P3M:2;
+} CCP3CONbits_t;
+typedef struct {
+	unsigned char CCP4M:4, DC4B:2, :2;
+} CCP4CONbits_t;
+typedef struct {
+	unsigned char C1TSEL:2, :1, C2TSEL:2, :1, C3TSEL:2;
+} CCPTMRS0bits_t;
+typedef struct {
+	unsigned char C4TSEL:2, C5TSEL:2, :4;
+} CCPTMRS1bits_t;
+typedef struct {
+	unsigned char HLVDL:4, HLVDEN:1, IRVST:1, BGVST:1, VDIRMAG:1;
+} HLVDCONbits_t;
+typedef struct {
+	unsigned char SWDTEN:1, :7;
+} WDTCONbits_t;
+typedef struct {
+	unsigned char RD:1, WR:1, WREN:1, WRERR:1, FREE:1, :1, CFGS:1, EEPGD:1;
+} EECON1bits_t;
+typedef struct {
+	unsigned char RX9D:1, OERR:1, FERR:1, ADDEN:1, CREN:1, SREN:1, RX9:1, SPEN:1;
+} RCSTAbits_t;
+typedef struct {
+	unsigned char TX9D:1, TRMT:1, BRGH:1, SENDB:1, SYNC:1, TXEN:1, TX9:1, CSRC:1;
+} TXSTAbits_t;
+typedef struct {
+	unsigned char ABDEN:1, WUE:1, :1, BRG16:1, CKTXP:1, DTRXP:1, RCIDL:1, ABDOVF:1;
+} BAUDCONbits_t;
+
+#define PORTA		HOST_REG(PORTA)
+#define PORTB		HOST_REG(PORTB)
+#define PORTC		HOST_REG(PORTC)
+#define LATA		HOST_REG(LATA)
+#define LATB		HOST_REG(LATB)
+#define LATC		HOST_REG(LATC)
+#define TRISA		HOST_REG(TRISA)
+#define TRISB		HOST_REG(TRISB)
+#define TRISC		HOST_REG(TRISC)
+#define ANSELA		HOST_REG(ANSELA)
+#define ANSELB		HOST_REG(ANSELB)
+#define ANSELC		HOST_REG(ANSELC)
+#define WPUB		HOST_REG(WPUB)
+#define INTCON		HOST_REG(INTCON)
+#define INTCON2		HOST_REG(INTCON2)
+#define PIR1		HOST_REG(PIR1)
+#define PIE1		HOST_REG(PIE1)
+#define PIR2		HOST_REG(PIR2)
+#define PIE2		HOST_REG(PIE2)
+#define PIR5		HOST_REG(PIR5)
+#define PIE5		HOST_REG(PIE5)
+#define RCON		HOST_REG(RCON)
+#define OSCCON		HOST_REG(OSCCON)
+#define OSCCON2		HOST_REG(OSCCON2)
+#define OSCTUNE		HOST_REG(OSCTUNE)
+#define T1CON		HOST_REG(T1CON)
+#define TMR1L		HOST_REG(TMR1L)
+#define TMR1H		HOST_REG(TMR1H)
+#define T2CON		HOST_REG(T2CON)
+#define PR2			HOST_REG(PR2)
+#define TMR2		HOST_REG(TMR2)
+#define T4CON		HOST_REG(T4CON)
+#define PR4			HOST_REG(PR4)
+#define TMR4		HOST_REG(TMR4)
+#define T6CON		HOST_REG(T6CON)
+#define PR6			HOST_REG(PR6)
+#define TMR6		HOST_REG(TMR6)
+#define CCP1CON		HOST_REG(CCP1CON)
+#define CCP2CON		HOST_REG(CCP2CON)
+#define CCP3CON		HOST_REG(CCP3CON)
+#define CCP4CON		HOST_REG(CCP4CON)
+#define CCPR1L		HOST_REG(CCPR1L)
+#define CCPR2L		HOST_REG(CCPR2L)
+#define CCPR3L		HOST_REG(CCPR3L)
+#define CCPR4L		HOST_REG(CCPR4L)
+#define CCPTMRS0	HOST_REG(CCPTMRS0)
+#define CCPTMRS1	HOST_REG(CCPTMRS1)
+#define FVRCON		HOST_REG(FVRCON)
+#define HLVDCON		HOST_REG(HLVDCON)
+#define WDTCON		HOST_REG(WDTCON)
+#define EECON1		HOST_REG(EECON1)
+#define EECON2		HOST_REG(EECON2)
+#define EEADR		HOST_REG(EEADR)
+#define EEDATA		HOST_REG(EEDATA)
+#define RCSTA		HOST_REG(RCSTA)
+#define TXSTA		HOST_REG(TXSTA)
+#define BAUDCON		HOST_REG(BAUDCON)
+#define SPBRG		HOST_REG(SPBRG)
+#define SPBRGH		HOST_REG(SPBRGH)
+#define RCREG		HOST_REG(RCREG)
+#define TXREG		HOST_REG(TXREG)
+
+#define PORTAbits	HOST_BITS(PORTA)
+#define PORTBbits	HOST_BITS(PORTB)
+#define PORTCbits	HOST_BITS(PORTC)
+#define LATAbits	HOST_BITS(LATA)
+#define LATBbits	HOST_BITS(LATB)
+#define LATCbits	HOST_BITS(LATC)
+#define TRISAbits	HOST_BITS(TRISA)
+#define TRISBbits	HOST_BITS(TRISB)
+#define TRISCbits	HOST_BITS(TRISC)
+#define WPUBbits	HOST_BITS(WPUB)
+#define INTCONbits	HOST_BITS(INTCON)
+#define INTCON2bits	HOST_BITS(INTCON2)
+#define PIR1bits	HOST_BITS(PIR1)
+#define PIE1bits	HOST_BITS(PIE1)
+#define PIR2bits	HOST_BITS(PIR2)
+#define PIE2bits	HOST_BITS(PIE2)
+#define PIR5bits	HOST_BITS(PIR5)
+#define PIE5bits	HOST_BITS(PIE5)
+#define RCONbits	HOST_BITS(RCON)
+#define OSCCONbits	HOST_BITS(OSCCON)
+#define OSCCON2bits	HOST_BITS(OSCCON2)
+#define OSCTUNEbits	HOST_BITS(OSCTUNE)
+#define T1CONbits	HOST_BITS(T1CON)
+#define T2CONbits	HOST_BITS(T2CON)
+#define T4CONbits	HOST_BITS(T4CON)
+#define T6CONbits	HOST_BITS(T6CON)
+#define CCP1CONbits	HOST_BITS(CCP1CON)
+#define CCP2CONbits	HOST_BITS(CCP2CON)
+#define CCP3CONbits	HOST_BITS(CCP3CON)
+#define CCP4CONbits	HOST_BITS(CCP4CON)
+#define CCPTMRS0bits	HOST_BITS(CCPTMRS0)
+#define CCPTMRS1bits	HOST_BITS(CCPTMRS1)
+#define HLVDCONbits	HOST_BITS(HLVDCON)
+#define WDTCONbits	HOST_BITS(WDTCON)
+#define EECON1bits	HOST_BITS(EECON1)
+#define RCSTAbits	HOST_BITS(RCSTA)
+#define TXSTAbits	HOST_BITS(TXSTA)
+#define BAUDCONbits	HOST_BITS(BAUDCON)
+
+// Bits the firmware names on their own (defined after the structures above)
+#define GIE			INTCONbits.GIE
+#define PEIE		INTCONbits.PEIE
+#define TMR4IE		PIE5bits.TMR4IE
+#define TMR4IF		PIR5bits.TMR4IF
+#define RCIE		PIE1bits.RCIE
+#define RCIF		PIR1bits.RCIF
+#define TXIF		PIR1bits.TXIF
+#define EEIE		PIE2bits.EEIE
+#define EEIF		PIR2bits.EEIF
+#define HLVDIE		PIE2bits.HLVDIE
+#define HLVDIF		PIR2bits.HLVDIF
+
+// Compiler built-ins
+#define persistent
+#define interrupt
+#define low_priority
+#define ei()			(GIE = 1)
+#define di()			(GIE = 0)
+#define NOP()			Host_Cycles(1)
+#define CLRWDT()		Host_ClearWatchdog()
+#define SLEEP()			Host_Sleep()
+#define __delay_ms(x)	Host_Cycles((unsigned long)(x) * (_XTAL_FREQ/4000))
+#define __delay_us(x)	Host_Cycles((unsigned long)(x) * (_XTAL_FREQ/4000) / 1000)
+
+extern unsigned char eeprom_read (unsigned char address);
+extern void eeprom_write (unsigned char address, unsigned char value);
+
+// Initial data EEPROM contents, eight bytes at a time in source order
+#define HOST_EENAME2(line)	Host_EEData_##line
+#define HOST_EENAME(line)	HOST_EENAME2(line)
+#define __EEPROM_DATA(a, b, c, d, e, f, g, h) \
+	static void HOST_EENAME(__LINE__) (void) __attribute__((constructor)); \
+	static void HOST_EENAME(__LINE__) (void) { \
+		static const unsigned char data[8] = { a, b, c, d, e, f, g, h }; \
+		Host_EEData(__LINE__, data); \
+	}
+
+#endif
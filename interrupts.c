@@ -10,9 +10,10 @@
     #include <p18cxxx.h>    /* C18 General Include File */
 #endif
 
-#include "PWM.h"
-#include "NightSense.h"
+#include "Timer.h"
 #include "RS485.h"
+#include "DataEE.h"
+#include "IsrStats.h"
 
 #if defined(__XC) || defined(HI_TECH_C)
 
@@ -38,19 +39,30 @@ void high_isr(void)
 #endif
 
 {
-    // PWM timer code
-    if ((TMR4IE) && (TMR4IF)) {
-        PWM_interrupt();
-        TMR4IF = 0;				// Clear Timer4 interrupt flag bit
+    ISR_ENTER();
 
-    } else if ((TMR6IE) && (TMR6IF)) {
-        NightSense_interrupt();
-        TMR6IF = 0;				// Clear Timer6 interrupt flag bit
+    // System tick
+    if ((TMR4IE) && (TMR4IF)) {
+        TMR4IF = 0;				// Clear Timer4 interrupt flag bit first so a late tick shows
+        Timer_interrupt();
+        ISR_EXIT(ISR_TICK);
+
+    // Supply failing -- finish the EEPROM writes
+    } else if ((HLVDIE) && (HLVDIF)) {
+        DataEE_PowerFail();
+        HLVDIF = 0;
+        ISR_EXIT(ISR_HLVD);
+
+    // EEPROM write complete
+    } else if ((EEIE) && (EEIF)) {
+        EEIF = 0;
+        DataEE_interrupt();
+        ISR_EXIT(ISR_EEPROM);
 
     // Handle the UART receive interrupt
     } else if (RCIF) {
-        // Add character to receive buffer
-        RS485_RxBuf[RS485_WtPtr++] = RCREG;
+        RS485_interrupt();
+        ISR_EXIT(ISR_RX);
 
     // Handle the I/O interrupt
 //    } else if (IOCAF != 0) {
@@ -14,6 +14,13 @@
 #include "EEPROM.h"
 #include "Sequences.h"
 #include "MemoryMap.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Timer.h"
+#include "DataEE.h"
+#include "Journal.h"
+#include "IsrStats.h"
+#include "Counters.h"
 
 /******************************************************************************/
 /* User Global Variable Declaration                                           */
@@ -36,40 +43,63 @@
 #define STARTSEQ        (0)     //      start Sequence = 0
 #define LASTSEQ         (61)    //      last Sequence = 61
 #define DEVICEADDVALUE  (255)   //      device Address = FF
+#define GROUPS          (0)     //      group membership = none
 
 #define HI(x)           ((x >> 8) & 0xFF)
 #define LO(x)           (x & 0xFF)
 
-// Internal state variables - 16 bytes
-__EEPROM_DATA(NIGHTMODE, OFFDELAYTIME, ONDELAYTIME, HI(DURATION), LO(DURATION), HI(STARTSEQ), LO(STARTSEQ), HI(LASTSEQ));
-__EEPROM_DATA(LO(LASTSEQ), DEVICEADDVALUE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+// Internal state variables - one journal record (key, sequence, hi, lo, check) each
+#define CHECK(key, seq, x)	JOURNALCHECK(key, seq, HI(x), LO(x))
+__EEPROM_DATA(STATEADD, 0, HI(NIGHTMODE), LO(NIGHTMODE), CHECK(STATEADD, 0, NIGHTMODE), OFFTIMEADD, 1, HI(OFFDELAYTIME));
+__EEPROM_DATA(LO(OFFDELAYTIME), CHECK(OFFTIMEADD, 1, OFFDELAYTIME), ONTIMEADD, 2, HI(ONDELAYTIME), LO(ONDELAYTIME), CHECK(ONTIMEADD, 2, ONDELAYTIME), DURATIONADD);
+__EEPROM_DATA(3, HI(DURATION), LO(DURATION), CHECK(DURATIONADD, 3, DURATION), STARTSEQADD, 4, HI(STARTSEQ), LO(STARTSEQ));
+__EEPROM_DATA(CHECK(STARTSEQADD, 4, STARTSEQ), TOTALSEQADD, 5, HI(LASTSEQ), LO(LASTSEQ), CHECK(TOTALSEQADD, 5, LASTSEQ), DEVICEADD, 6);
+__EEPROM_DATA(HI(DEVICEADDVALUE), LO(DEVICEADDVALUE), CHECK(DEVICEADD, 6, DEVICEADDVALUE), GROUPADD, 7, HI(GROUPS), LO(GROUPS), CHECK(GROUPADD, 7, GROUPS));
 
-// EEPROM macro sequences - 200 bytes
-//      macro area blank (no macros to play)
-__EEPROM_DATA(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);	
+// The rest of the journal and the EEPROM macro area at EESEQADD are left blank
+// (no newer records, no macros to play)
 
 unsigned int activeSequence;		// active sequence to play
 unsigned int maxAddress, minAddress;	// sequence start and end address
 BOOL override;				// override outputs via SBUS
 BOOL playMacros;			// play EEPROM macros if TRUE
+BOOL restart;				// restart playback at minAddress via SBUS
+BOOL startPending;			// hold the restart until startTick
+unsigned long startTick;		// scheduled start tick for synchronized playback
+
+static SeqCursor player;		// segment position of the playing sequence
+static unsigned int playerStart;	// EEPROM address of the first segment in player
+static BOOL playing;			// a sequence is open in player
+static unsigned char playerTask;	// scheduler identifier of Player_Task
+
+// Playback position kept in RAM over a brown-out or reset
+#define CHECKMARK	(0xC3A5)
+#define CHECKINTERVAL	(10UL*60*TIMER_HZ)	// journal the sequence at most every 10 minutes
+
+typedef struct _Checkpoint {
+	unsigned int marker;		// CHECKMARK once written
+	unsigned int sequence;		// active sequence
+	unsigned int offset;		// bytes from the first segment to the one playing
+	unsigned char generation;	// sequence store the offset belongs to
+	BOOL macros;			// playing macros
+	unsigned char check;		// XOR of the bytes above
+} Checkpoint;
+
+static persistent Checkpoint checkpoint;
+static unsigned long journalTick;	// next tick the sequence may be journaled
 
 /******************************************************************************/
 /* User Functions                                                             */
 /******************************************************************************/
 
-// Wait for Sequence to finish playing while also scanning the pushbuttons and
-// handling any external commands
+// Wait for Sequence to finish playing while the scheduled tasks scan the
+// pushbuttons and handle any external commands
 BOOL Scan (void) {
-	unsigned int i;
-
 	do {
-		PushButtons_Scan();			// update pushbutton status
-		for (i=0; i<10; i++) {
-			SBUS_Process_Command();	// handle protocol commands
-			__delay_ms(1);
-		}
+		if (!Sched_Run()) Power_Idle();		// sleep until the next tick or character
 		if (PushButtons_Active(BUTTON1|BUTTON2)) return TRUE;
 //		if (PushButtons_Active(BUTTON2)) return TRUE;
+
 	} while (PWM_Busy());
 	return FALSE;
 }
@@ -85,11 +115,8 @@ void ShowNumber (unsigned int version) {
 }
 
 void Delay (CARDINAL ms) {
-    // __delay_ms has limited size arguments
-    while (ms > 0) {
-        __delay_ms(1);
-        ms--;
-    }
+    // __delay_ms has limited size arguments and only suits the crystal clock
+    Power_DelayMs(ms);
 }
 
 void ConfirmCommand (void) {
@@ -119,10 +146,118 @@ void PlaySequence (unsigned int sequence) {
 			PWM_Set(0, 0, 0, 0);
 			return;         		// handle push buttons
 		}
+		if (override) return;		// host has taken over the outputs
 		ok = Seq_Next(NOREPEAT);
 	} while ((Seq_GetActive() == sequence) && ok);
 }
 
+static unsigned char CheckpointSum (void) {
+	unsigned char *byte = (unsigned char *)&checkpoint;
+	unsigned char i, sum = 0x5A;
+	
+	for (i=0; i<sizeof(checkpoint)-1; i++) sum ^= byte[i];
+	return sum;
+}
+
+// Record the segment about to play.  The RAM copy is updated for every segment;
+// the journal only gets the sequence number, and not more than every 10 minutes,
+// to spare the internal EEPROM.
+static void SaveCheckpoint (void) {
+	checkpoint.marker = CHECKMARK;
+	checkpoint.sequence = activeSequence;
+	checkpoint.offset = player.index - playerStart;
+	checkpoint.generation = Seq_Generation();
+	checkpoint.macros = playMacros;
+	checkpoint.check = CheckpointSum();
+	if ((checkpoint.offset == 0) && Timer_TickReached(journalTick)) {
+		WriteWord(RESUMEADD, activeSequence);
+		journalTick = Timer_GetTicks() + CHECKINTERVAL;
+	}
+}
+
+// Pick up playback where it stopped before a reset.  The RAM checkpoint survives
+// a brown-out and gives the exact segment; after a full power loss the journal
+// gives the sequence.  TRUE is returned if playback resumes.
+static BOOL Resume (void) {
+	unsigned int sequence;
+	
+	if ((checkpoint.marker == CHECKMARK) && (checkpoint.check == CheckpointSum()) &&
+		(checkpoint.macros == playMacros) && (checkpoint.generation == Seq_Generation()) &&
+		(checkpoint.sequence >= minAddress) && (checkpoint.sequence <= maxAddress) &&
+		((checkpoint.offset % BYTESPERSEQ) == 0)) {
+		activeSequence = checkpoint.sequence;
+		if (Seq_Open(&player, playMacros ? Macros_Read(activeSequence) : activeSequence) == FIND_OK) {
+			playerStart = player.index;
+			player.index += checkpoint.offset;
+			playing = TRUE;
+			return TRUE;
+		}
+	}
+	sequence = ReadWord(RESUMEADD);
+	if ((sequence >= minAddress) && (sequence <= maxAddress)) {
+		activeSequence = sequence;
+		playing = FALSE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void NextSequence (void) {
+	if (activeSequence < maxAddress) activeSequence++;
+	else activeSequence = minAddress;
+}
+
+// Scheduled sequence player.  Each run hands the next segment of the active
+// sequence to the PWM module once the previous one has finished, so the other
+// tasks keep running while a sequence plays.
+static void Player_Task (void) {
+	unsigned char segment[BYTESPERSEQ];
+
+	if (override) {
+		if (PWM_StreamTimedOut()) override = FALSE;	// streaming host went away
+		playing = FALSE;
+		return;
+	}
+	if (restart) {
+		// activeSequence is already the new start
+		restart = FALSE;
+		playing = FALSE;
+		PWM_Stop();				// start the next sequence from the current levels
+	}
+	if (startPending) {
+		// hold the current levels until every node on the bus starts together
+		if (!Timer_TickReached(startTick)) return;
+		startPending = FALSE;
+	}
+	if (PWM_Busy()) return;
+
+	if (!playing) {
+		if (!NightSense_IsNight()) {
+			PWM_Ramp (0, 0, 0, 0, 1, 0);
+			return;
+		}
+		if (Seq_Open(&player, playMacros ? Macros_Read(activeSequence) : activeSequence) != FIND_OK) {
+			PWM_Ramp (255, 0, 0, 0, 1, 40);		// Red flash for two seconds
+			NextSequence();
+			return;
+		}
+		playerStart = player.index;
+		playing = TRUE;
+	}
+	SaveCheckpoint();
+	if (Seq_ReadSegment(&player, segment)) {
+		PWM_Ramp (segment[2], segment[3], segment[4], segment[5], segment[0], segment[1]);
+	} else {
+		playing = FALSE;
+		NextSequence();
+	}
+}
+
+static void StartPlayer (BOOL on) {
+	playing = FALSE;
+	Sched_Enable(playerTask, on);
+}
+
 //#ifndef FLASHCOPY
 static void InitMode (void) {
     unsigned int total;
@@ -190,39 +325,7 @@ void DefineEEMacros (void) {
 }
 
 void DoSleep (void) {
-    while (PWM_Busy());			// wait for PWM to complete
-    PWM_Set(0, 0, 0, 0);
-    __delay_ms(50);
-
-    TRISBbits.TRISB4  = 1;		// change SDA to input temporarily
-    TRISBbits.TRISB6  = 1;		// change SCL to input temporarily
-
-    TRISAbits.TRISA0  = 1;		// temporarily make JTAG pins inputs
-    TRISAbits.TRISA1  = 1;
-//    WPUAbits.WPUA0 = 1;			// enable pull-ups
-//    WPUAbits.WPUA1 = 1;
-//    IOCANbits.IOCAN0 = 1;		// enable interrupt on negative edge on pin A0
-
-    TRISBbits.TRISB5 = 1;		// Set as pulled up digital inputs
-    WPUBbits.WPUB5 = 1;
-
-    TMR4IE = 0;				// Disable Timer4 interrupts
-    TMR6IE = 0;				// Disable Timer6 interrupts
-
-    FVRCON = 0;				// Disable voltage reference
-//    IOCIE = 1;				// Enable I/O interrupts
-
-//*************************************************************************************
-    SLEEP();						// processor goes into sleep mode and clears watchdog
-//*************************************************************************************
-    NOP();
-//    IOCIE = 0;
-    SBUS_Init();
-    PWM_Init();
-    PushButtons_Init();
-    NightSense_Init();
-
-    ConfirmCommand();
+    Power_Sleep();			// returns in a few mS with playback where it stopped
 }
 
 //#else
@@ -236,7 +339,7 @@ void CopyFlashToEEPROM (void) {
 	// Copies the contents of FLASH in Sequences[] to EEPROM
 	if (EEPROM_Present()) {
 		// Write Sequences data to external EEPROM
-		EEPROM_Write(0x0000, Sequences, sizeof(Sequences));
+		Seq_WriteImage(0x0000, Sequences, sizeof(Sequences));
 
 		// Verify the external EEPROM contents
 		for (i=0; i<sizeof(Sequences); i++) {
@@ -260,6 +363,10 @@ void CopyFlashToEEPROM (void) {
 
 void InitApp(void)
 {
+    IsrStats_Init();
+    Timer_Init();
+    DataEE_Init();
+    Journal_Init();
     SBUS_Init();
     EEPROM_Init();
     Macros_Init();
@@ -267,8 +374,18 @@ void InitApp(void)
     PushButtons_Init();
     NightSense_Init();
     Seq_Init();
+    Power_Init();
 
     override = FALSE;
+    restart = FALSE;
+    startPending = FALSE;
+
+    // Cooperative tasks; periods and deadlines in 5mS ticks
+    Sched_Init();
+    Sched_Add(Timer_Run, 1, 1);
+    Sched_Add(SBUS_Process_Command, 1, 2);
+    playerTask = Sched_Add(Player_Task, 1, 1);
+    StartPlayer(FALSE);
 
     // Play FLASH/EEPROM sequences or macros from internal EEPROM, changes operating modes, or define EEPROM macros
 #ifndef FLASHCOPY
@@ -284,43 +401,67 @@ void InitApp(void)
 
 TCHAR main(void)
 {
+    unsigned char event;
+    unsigned int cue;
+    BOOL resuming;
+
     /* Configure the oscillator for the device */
     ConfigureOscillator();
 
     /* Initialize I/O and Peripherals for application */
     InitApp();
+    resuming = Resume();
 
     // Play FLASH/EEPROM sequences or macros from internal EEPROM, changes operating modes, or define EEPROM macros
     while (1) {
-	// Display the firmware version number
-	ShowNumber(FW_VERSION);
+	if (resuming) {
+	    // Carry on from the checkpoint on the next tick
+	    Sched_Enable(playerTask, TRUE);
+	    resuming = FALSE;
+	} else {
+	    // Display the firmware version number
+	    ShowNumber(FW_VERSION);
+
+	    StartPlayer(TRUE);
+	}
 
 	for (;;) {
 //#ifndef FLASHCOPY
-            if (NightSense_IsNight()) {
-                if (!override) {
-                    if (playMacros) PlaySequence(Macros_Read(activeSequence));
-                    else PlaySequence(activeSequence);
-                    if (activeSequence < maxAddress) activeSequence++;
-                    else activeSequence = minAddress;
-                } else {
-                    Scan();
-                }
-            } else {
-                PWM_Ramp (0, 0, 0, 0, 1, 0);
-                Scan();
-            }
+            Counters_Loop(FALSE);
+            if (!Sched_Run()) Power_Idle();	// nothing due until the next interrupt
 
             // handle pushbuttons
+            if (PushButtons_Pressed(BUTTON1)) {
+                // Skip to the next sequence
+                PushButtons_Clear(BUTTON1);
+                NextSequence();
+                restart = TRUE;
+            }
             if (PushButtons_Pressed(BUTTON2)) {
                 // Change operating modes
                 PushButtons_Clear(BUTTON2);
+                StartPlayer(FALSE);
                 ConfirmCommand();
                 DefineEEMacros();
+                PushButtons_Flush();		// cues seen while defining macros are stale
+                StartPlayer(TRUE);
+                Counters_Loop(TRUE);
             }
             if (PushButtons_Held(BUTTON2)) {
                 PushButtons_Clear(BUTTON2);
                 DoSleep();
+                Counters_Loop(TRUE);
+            }
+
+            // cue inputs jump straight to one of the first sequences
+            while ((event = PushButtons_GetEvent()) != PB_NOEVENT) {
+                if ((PB_KIND(event) == PB_PRESSED) && (PB_INPUT(event) >= PB_CUEFIRST)) {
+                    cue = minAddress + PB_INPUT(event) - PB_CUEFIRST;
+                    if (cue <= maxAddress) {
+                        activeSequence = cue;
+                        restart = TRUE;
+                    }
+                }
             }
 //#endif
 	}
@@ -45,17 +45,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=configuration_bits.c interrupts.c system.c EEPROM.c I2C.c Macros.c NightSense.c Pushbuttons.c PWM.c RS485.c SBUS.c Sequences.c main_1.c
+SOURCEFILES_QUOTED_IF_SPACED=configuration_bits.c interrupts.c system.c EEPROM.c I2C.c Macros.c NightSense.c Pushbuttons.c PWM.c RS485.c SBUS.c Sequences.c Scheduler.c Power.c Timer.c DataEE.c Journal.c IsrStats.c Counters.c Trace.c main_1.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/configuration_bits.p1 ${OBJECTDIR}/interrupts.p1 ${OBJECTDIR}/system.p1 ${OBJECTDIR}/EEPROM.p1 ${OBJECTDIR}/I2C.p1 ${OBJECTDIR}/Macros.p1 ${OBJECTDIR}/NightSense.p1 ${OBJECTDIR}/Pushbuttons.p1 ${OBJECTDIR}/PWM.p1 ${OBJECTDIR}/RS485.p1 ${OBJECTDIR}/SBUS.p1 ${OBJECTDIR}/Sequences.p1 ${OBJECTDIR}/main_1.p1
-POSSIBLE_DEPFILES=${OBJECTDIR}/configuration_bits.p1.d ${OBJECTDIR}/interrupts.p1.d ${OBJECTDIR}/system.p1.d ${OBJECTDIR}/EEPROM.p1.d ${OBJECTDIR}/I2C.p1.d ${OBJECTDIR}/Macros.p1.d ${OBJECTDIR}/NightSense.p1.d ${OBJECTDIR}/Pushbuttons.p1.d ${OBJECTDIR}/PWM.p1.d ${OBJECTDIR}/RS485.p1.d ${OBJECTDIR}/SBUS.p1.d ${OBJECTDIR}/Sequences.p1.d ${OBJECTDIR}/main_1.p1.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/configuration_bits.p1 ${OBJECTDIR}/interrupts.p1 ${OBJECTDIR}/system.p1 ${OBJECTDIR}/EEPROM.p1 ${OBJECTDIR}/I2C.p1 ${OBJECTDIR}/Macros.p1 ${OBJECTDIR}/NightSense.p1 ${OBJECTDIR}/Pushbuttons.p1 ${OBJECTDIR}/PWM.p1 ${OBJECTDIR}/RS485.p1 ${OBJECTDIR}/SBUS.p1 ${OBJECTDIR}/Sequences.p1 ${OBJECTDIR}/Scheduler.p1 ${OBJECTDIR}/Power.p1 ${OBJECTDIR}/Timer.p1 ${OBJECTDIR}/DataEE.p1 ${OBJECTDIR}/Journal.p1 ${OBJECTDIR}/IsrStats.p1 ${OBJECTDIR}/Counters.p1 ${OBJECTDIR}/Trace.p1 ${OBJECTDIR}/main_1.p1
+POSSIBLE_DEPFILES=${OBJECTDIR}/configuration_bits.p1.d ${OBJECTDIR}/interrupts.p1.d ${OBJECTDIR}/system.p1.d ${OBJECTDIR}/EEPROM.p1.d ${OBJECTDIR}/I2C.p1.d ${OBJECTDIR}/Macros.p1.d ${OBJECTDIR}/NightSense.p1.d ${OBJECTDIR}/Pushbuttons.p1.d ${OBJECTDIR}/PWM.p1.d ${OBJECTDIR}/RS485.p1.d ${OBJECTDIR}/SBUS.p1.d ${OBJECTDIR}/Sequences.p1.d ${OBJECTDIR}/Scheduler.p1.d ${OBJECTDIR}/Power.p1.d ${OBJECTDIR}/Timer.p1.d ${OBJECTDIR}/DataEE.p1.d ${OBJECTDIR}/Journal.p1.d ${OBJECTDIR}/IsrStats.p1.d ${OBJECTDIR}/Counters.p1.d ${OBJECTDIR}/Trace.p1.d ${OBJECTDIR}/main_1.p1.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/configuration_bits.p1 ${OBJECTDIR}/interrupts.p1 ${OBJECTDIR}/system.p1 ${OBJECTDIR}/EEPROM.p1 ${OBJECTDIR}/I2C.p1 ${OBJECTDIR}/Macros.p1 ${OBJECTDIR}/NightSense.p1 ${OBJECTDIR}/Pushbuttons.p1 ${OBJECTDIR}/PWM.p1 ${OBJECTDIR}/RS485.p1 ${OBJECTDIR}/SBUS.p1 ${OBJECTDIR}/Sequences.p1 ${OBJECTDIR}/main_1.p1
+OBJECTFILES=${OBJECTDIR}/configuration_bits.p1 ${OBJECTDIR}/interrupts.p1 ${OBJECTDIR}/system.p1 ${OBJECTDIR}/EEPROM.p1 ${OBJECTDIR}/I2C.p1 ${OBJECTDIR}/Macros.p1 ${OBJECTDIR}/NightSense.p1 ${OBJECTDIR}/Pushbuttons.p1 ${OBJECTDIR}/PWM.p1 ${OBJECTDIR}/RS485.p1 ${OBJECTDIR}/SBUS.p1 ${OBJECTDIR}/Sequences.p1 ${OBJECTDIR}/Scheduler.p1 ${OBJECTDIR}/Power.p1 ${OBJECTDIR}/Timer.p1 ${OBJECTDIR}/DataEE.p1 ${OBJECTDIR}/Journal.p1 ${OBJECTDIR}/IsrStats.p1 ${OBJECTDIR}/Counters.p1 ${OBJECTDIR}/Trace.p1 ${OBJECTDIR}/main_1.p1
 
 # Source Files
-SOURCEFILES=configuration_bits.c interrupts.c system.c EEPROM.c I2C.c Macros.c NightSense.c Pushbuttons.c PWM.c RS485.c SBUS.c Sequences.c main_1.c
+SOURCEFILES=configuration_bits.c interrupts.c system.c EEPROM.c I2C.c Macros.c NightSense.c Pushbuttons.c PWM.c RS485.c SBUS.c Sequences.c Scheduler.c Power.c Timer.c DataEE.c Journal.c IsrStats.c Counters.c Trace.c main_1.c
 
 
 CFLAGS=
@@ -174,6 +174,70 @@ ${OBJECTDIR}/Sequences.p1: Sequences.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/Sequences.d ${OBJECTDIR}/Sequences.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/Sequences.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/Scheduler.p1: Scheduler.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Scheduler.p1.d 
+	@${RM} ${OBJECTDIR}/Scheduler.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Scheduler.p1  Scheduler.c 
+	@-${MV} ${OBJECTDIR}/Scheduler.d ${OBJECTDIR}/Scheduler.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Scheduler.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Power.p1: Power.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Power.p1.d 
+	@${RM} ${OBJECTDIR}/Power.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Power.p1  Power.c 
+	@-${MV} ${OBJECTDIR}/Power.d ${OBJECTDIR}/Power.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Power.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Timer.p1: Timer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Timer.p1.d 
+	@${RM} ${OBJECTDIR}/Timer.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Timer.p1  Timer.c 
+	@-${MV} ${OBJECTDIR}/Timer.d ${OBJECTDIR}/Timer.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Timer.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/DataEE.p1: DataEE.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/DataEE.p1.d 
+	@${RM} ${OBJECTDIR}/DataEE.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/DataEE.p1  DataEE.c 
+	@-${MV} ${OBJECTDIR}/DataEE.d ${OBJECTDIR}/DataEE.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/DataEE.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Journal.p1: Journal.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Journal.p1.d 
+	@${RM} ${OBJECTDIR}/Journal.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Journal.p1  Journal.c 
+	@-${MV} ${OBJECTDIR}/Journal.d ${OBJECTDIR}/Journal.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Journal.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/IsrStats.p1: IsrStats.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/IsrStats.p1.d 
+	@${RM} ${OBJECTDIR}/IsrStats.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/IsrStats.p1  IsrStats.c 
+	@-${MV} ${OBJECTDIR}/IsrStats.d ${OBJECTDIR}/IsrStats.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/IsrStats.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Counters.p1: Counters.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Counters.p1.d 
+	@${RM} ${OBJECTDIR}/Counters.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Counters.p1  Counters.c 
+	@-${MV} ${OBJECTDIR}/Counters.d ${OBJECTDIR}/Counters.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Counters.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Trace.p1: Trace.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Trace.p1.d 
+	@${RM} ${OBJECTDIR}/Trace.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1 --debugger=pickit3  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Trace.p1  Trace.c 
+	@-${MV} ${OBJECTDIR}/Trace.d ${OBJECTDIR}/Trace.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Trace.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/main_1.p1: main_1.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} ${OBJECTDIR} 
 	@${RM} ${OBJECTDIR}/main_1.p1.d 
@@ -279,6 +343,70 @@ ${OBJECTDIR}/Sequences.p1: Sequences.c  nbproject/Makefile-${CND_CONF}.mk
 	@-${MV} ${OBJECTDIR}/Sequences.d ${OBJECTDIR}/Sequences.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/Sequences.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/Scheduler.p1: Scheduler.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Scheduler.p1.d 
+	@${RM} ${OBJECTDIR}/Scheduler.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Scheduler.p1  Scheduler.c 
+	@-${MV} ${OBJECTDIR}/Scheduler.d ${OBJECTDIR}/Scheduler.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Scheduler.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Power.p1: Power.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Power.p1.d 
+	@${RM} ${OBJECTDIR}/Power.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Power.p1  Power.c 
+	@-${MV} ${OBJECTDIR}/Power.d ${OBJECTDIR}/Power.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Power.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Timer.p1: Timer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Timer.p1.d 
+	@${RM} ${OBJECTDIR}/Timer.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Timer.p1  Timer.c 
+	@-${MV} ${OBJECTDIR}/Timer.d ${OBJECTDIR}/Timer.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Timer.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/DataEE.p1: DataEE.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/DataEE.p1.d 
+	@${RM} ${OBJECTDIR}/DataEE.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/DataEE.p1  DataEE.c 
+	@-${MV} ${OBJECTDIR}/DataEE.d ${OBJECTDIR}/DataEE.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/DataEE.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Journal.p1: Journal.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Journal.p1.d 
+	@${RM} ${OBJECTDIR}/Journal.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Journal.p1  Journal.c 
+	@-${MV} ${OBJECTDIR}/Journal.d ${OBJECTDIR}/Journal.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Journal.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/IsrStats.p1: IsrStats.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/IsrStats.p1.d 
+	@${RM} ${OBJECTDIR}/IsrStats.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/IsrStats.p1  IsrStats.c 
+	@-${MV} ${OBJECTDIR}/IsrStats.d ${OBJECTDIR}/IsrStats.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/IsrStats.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Counters.p1: Counters.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Counters.p1.d 
+	@${RM} ${OBJECTDIR}/Counters.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Counters.p1  Counters.c 
+	@-${MV} ${OBJECTDIR}/Counters.d ${OBJECTDIR}/Counters.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Counters.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/Trace.p1: Trace.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} ${OBJECTDIR} 
+	@${RM} ${OBJECTDIR}/Trace.p1.d 
+	@${RM} ${OBJECTDIR}/Trace.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --opt=default,+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=free -P -N255 --warn=0 --asmlist --summary=default,-psect,-class,+mem,-hex,-file --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib --output=-mcof,+elf "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"    -o${OBJECTDIR}/Trace.p1  Trace.c 
+	@-${MV} ${OBJECTDIR}/Trace.d ${OBJECTDIR}/Trace.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/Trace.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/main_1.p1: main_1.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} ${OBJECTDIR} 
 	@${RM} ${OBJECTDIR}/main_1.p1.d 
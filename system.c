@@ -23,9 +23,11 @@
 oscillator configurations. */
 void ConfigureOscillator(void)
 {
-    /* TODO Add clock switching code if appropriate.  */
-
-    /* Typical actions in this function are to tweak the oscillator tuning
-    register, select new clock sources, and to wait until new clock sources
-    are stable before resuming execution of the main project. */
+    /* Start on the 3.6864MHz crystal with the 4x PLL off (PLLCFG = OFF).  The
+    Power module switches the PLL in while there is CPU-bound work to do and
+    rescales the timers and the baud rate generator to match. */
+    OSCTUNEbits.PLLEN = 0;
+    OSCCONbits.SCS = 0b00;          /* clock source selected by FOSC */
+    while (!OSCCONbits.OSTS)        /* wait until the crystal is running */
+        continue;
 }